@@ -1,15 +1,58 @@
+import concurrent.futures
+import heapq
 import json
 import os
-from typing import List, Set, Tuple
+import re
+import threading
+import time
+from collections import deque
+from typing import Deque, Dict, List, Optional, Set, Tuple
 
 from agent.agent import *
 from llmtool.LLM_utils import *
+from llmtool.slicescan.chunked_slicer import *
 from llmtool.slicescan.intra_slicer import *
 
 from memory.state.slicescan_state import *
 from memory.utils.value import *
 from memory.IR.U6IR import *
 from utility.request import *
+from utility.metrics import METRICS
+from utility.stage_timer import STAGE_TIMER
+from utility.tracer import TRACER
+
+WORKLIST_PENDING_ITEMS = METRICS.gauge(
+    "reposlice_worklist_pending_items",
+    "Work items pending in the worklist of a slice request",
+    ["slicing_request_id"],
+)
+WORKLIST_PROCESSED_ITEMS = METRICS.counter(
+    "reposlice_worklist_processed_items_total",
+    "Work items sliced for a slice request",
+    ["slicing_request_id"],
+)
+ACTIVE_SLICING_WORKERS = METRICS.gauge(
+    "reposlice_active_slicing_workers",
+    "Intra-procedural slicing queries in progress in all the agents",
+)
+PRUNED_API_CALL_LINES = METRICS.counter(
+    "reposlice_pruned_api_call_lines_total",
+    "Lines of effect-free library calls pruned from the backward slices",
+)
+
+# Matches a line holding a call statement whose return value is discarded
+DISCARDED_CALL_PATTERN = re.compile(r"^\s*(?:\(void\)\s*)?(\w+)\s*\((.*)\)\s*;\s*$")
+# Matches the side effects an argument of a call may have
+SIDE_EFFECT_PATTERN = re.compile(r"\+\+|--|(?<![=!<>])=(?!=)")
+# Matches the string and character literals, which are removed from the arguments
+# before the side effect check, e.g., the "=" of printf("x = %d\n", x)
+LITERAL_PATTERN = re.compile(r"\"(?:\\.|[^\"\\])*\"|'(?:\\.|[^'\\])*'")
+# Matches the identifiers of a seed name, e.g., p and len in p->len
+IDENTIFIER_PATTERN = re.compile(r"[A-Za-z_]\w*")
+
+# A work item is a function, its seed values, the mask of the slicing seeds the
+# item is propagated from, and its call depth
+WorkItem = Tuple[Function, List[Value], int, int]
 
 
 class SliceScanAgent(Agent[SliceScanState]):
@@ -29,6 +72,12 @@ class SliceScanAgent(Agent[SliceScanState]):
         max_query_num: int,
         slice_request: SliceRequest,
         call_depth: int,
+        max_scc_iterations: int = 5,
+        intra_slicer: Optional[IntraSlicer] = None,
+        llm_tenant: Optional[LLMTenant] = None,
+        max_llm_workers: int = 1,
+        prompt_dir: Optional[str] = None,
+        max_chunk_lines: Optional[int] = None,
     ) -> None:
         """Initialize the slice scan agent.
 
@@ -41,6 +90,18 @@ class SliceScanAgent(Agent[SliceScanState]):
             max_query_num: Maximum number of queries to send to the LLM for re-tries
             slice_request: Slice request
             call_depth: Maximum call depth to analyze
+            max_scc_iterations: Maximum number of rounds over a recursive SCC of the
+                call graph, across all its visits, before its pending work items
+                are dropped
+            intra_slicer: Intra-procedural slicer to reuse (and share its cache with
+                another agent), or None to create a new one
+            llm_tenant: Tenant of an LLMScheduler shared with other agents, which
+                admits the LLM queries of this agent, or None
+            max_llm_workers: Maximum number of concurrent LLM queries of this agent
+            prompt_dir: Directory of the prompt templates of a new intra-procedural
+                slicer, or None for the default ones
+            max_chunk_lines: Maximum number of lines of a chunk of a large function
+                sliced by chunks, or None to slice every function whole
         """
 
         # Initialize parent with state
@@ -56,148 +117,502 @@ class SliceScanAgent(Agent[SliceScanState]):
 
         assert language == "Cpp", "Only Cpp is supported for now."
 
-        seed_values = []
+        self.seed_functions: List[Function] = []
+        self.seed_values: List[Value] = []
 
-        for function_id in u6ir.function_env:
-            function = u6ir.function_env[function_id]
-            if (
-                function.file_path == slice_request.file_path
-                and function.start_line_number
-                <= slice_request.seed_line_number
-                <= function.end_line_number
-            ):
-                seed_value = Value(
-                    slice_request.seed_name,
+        for seed in slice_request.seeds:
+            seed_function = u6ir.get_function_by_line(
+                seed.file_path, seed.seed_line_number
+            )
+            assert seed_function is not None, f"No function contains the seed {seed}."
+            self.check_seed_name(seed_function, seed.seed_name, seed.seed_line_number)
+            self.seed_functions.append(seed_function)
+            self.seed_values.append(
+                Value(
+                    seed.seed_name,
                     ValueLabel.SRC,
-                    function.file_path,
-                    slice_request.seed_line_number,
-                    function.function_id,
-                    function.function_name,
-                    slice_request.seed_line_number - function.start_line_number + 1,
+                    seed_function.file_path,
+                    seed.seed_line_number,
+                    seed_function.function_id,
+                    seed_function.function_name,
+                    seed.seed_line_number - seed_function.start_line_number + 1,
                 )
-                self.seed_function = function
-                seed_values.append(seed_value)
-                break
-
-        assert len(seed_values) == 1, "Only one seed value is supported for now."
-        self.seed_value = seed_values[0]
+            )
 
+        self.slicing_request_id = slice_request.slicing_request_id
         self.is_backward = slice_request.is_backward
         self.call_depth = call_depth
+        self.max_scc_iterations = max_scc_iterations
+        self.max_llm_workers = max_llm_workers
+
+        # Rank the functions by the topological order of the call graph SCCs
+        self.scc_ranks: Dict[int, int] = {}
+        self.recursive_scc_ranks: Set[int] = set()
+        for scc_rank, scc in enumerate(u6ir.get_call_graph_sccs()):
+            for function_id in scc:
+                self.scc_ranks[function_id] = scc_rank
+            if u6ir.is_recursive_scc(scc):
+                self.recursive_scc_ranks.add(scc_rank)
 
         self.state.initialize_slicescan_state(
             slice_request.slicing_request_id,
-            self.seed_function,
-            self.seed_value,
+            self.seed_functions,
+            self.seed_values,
             self.call_depth,
             self.is_backward,
         )
 
         # Initialize LLM tool for intra-procedural slicing
-        self.intra_slicer = IntraSlicer(
-            self.audit_model_name,
-            self.temperature,
-            self.language,
-            self.max_query_num,
-            self.logger,
-        )
+        if intra_slicer is None:
+            intra_slicer = IntraSlicer(
+                self.audit_model_name,
+                self.temperature,
+                self.language,
+                self.max_query_num,
+                self.logger,
+                llm_tenant,
+                prompt_dir,
+            )
+        else:
+            intra_slicer.logger = self.logger
+            intra_slicer.llm_tenant = llm_tenant
+        self.intra_slicer = intra_slicer
+        # Held by each query, so the queries of the chunks of the functions sliced
+        # concurrently are bounded by max_llm_workers too
+        self.query_slots = threading.BoundedSemaphore(max_llm_workers)
+        self.chunked_slicer: Optional[ChunkedSlicer] = None
+        if max_chunk_lines is not None:
+            self.chunked_slicer = ChunkedSlicer(
+                intra_slicer, max_chunk_lines, max_llm_workers, self.query_slots
+            )
 
     def scan(self) -> None:
-        if self.seed_function is None:
+        if len(self.seed_functions) == 0:
             self.logger.print_console("No seed function found.")
             return
 
         self.logger.print_console("Start slice scanning in parallel...")
+        start_time = time.perf_counter()
+        # The intra-procedural slicer may be shared, so only count this scan's cost
+        prior_input_token_cost = self.intra_slicer.input_token_cost
+        prior_output_token_cost = self.intra_slicer.output_token_cost
+        prior_query_num = self.intra_slicer.total_query_num
 
-        # TODO: Add your implementation here.
-        # You need to start from the initial seed and its function and then recursively process its callers or callees
-        # You need to call the method process_slice_in_single_function to process the slice in a single function.
-        # You can define any other helper functions as you need.
-        work_list = [(self.seed_function, self.seed_value)]
-        while work_list:
-            function, value = work_list.pop(0)
-            intra_slicer_output = self.process_slice_in_single_function(function, value)
-            if intra_slicer_output is None:
-                continue
-            self.state.update_relevant_function_names_to_line_numbers(
-                function.function_name, intra_slicer_output.line_numbers
+        # All the seeds share one worklist. A work item carries a bitmask of the
+        # seeds it is propagated from, so that an item reached from several seeds is
+        # processed only once per seed, and its slice is attributed to all of them.
+        #
+        # The worklist is partitioned by the SCCs of the call graph, and the pending
+        # SCC with the smallest rank in the topological order (callers first) is
+        # visited next. A visit processes the pending items of the SCC round by
+        # round until a round adds no item to it. The items propagated to the
+        # callers (parameters in backward slicing, return values in forward slicing)
+        # go to SCCs of smaller ranks, which may have been visited already, so such
+        # an SCC is visited again before the next ones. A recursive SCC gets
+        # max_scc_iterations rounds over all its visits, which bounds the number of
+        # LLM queries on recursive call graphs. The items added to it after its
+        # rounds ran out are dropped and recorded in the state, which marks the
+        # slice as partial.
+        #
+        # An item is processed again for a seed when it is reached by a shorter
+        # path, so that the slice is propagated up to call_depth from each seed
+        # regardless of the order of the visits. The slice is then taken from the
+        # cache of the intra-procedural slicer.
+        pending_items: Dict[int, Deque[WorkItem]] = {}
+        pending_scc_ranks: List[int] = []
+
+        def add_work_item(work_item: WorkItem) -> None:
+            scc_rank = self.scc_ranks[work_item[0].function_id]
+            if scc_rank not in pending_items:
+                pending_items[scc_rank] = deque()
+                heapq.heappush(pending_scc_ranks, scc_rank)
+            pending_items[scc_rank].append(work_item)
+
+        for seed_index, (seed_function, seed_value) in enumerate(
+            zip(self.seed_functions, self.seed_values)
+        ):
+            add_work_item((seed_function, [seed_value], 1 << seed_index, 0))
+
+        # Maps (function_id, seed values) -> seed index -> smallest depth at which
+        # the item was propagated from the seed
+        visited_depths: Dict[Tuple[int, Tuple[Value, ...]], Dict[int, int]] = {}
+
+        def process_round(round_items: Deque[WorkItem]) -> int:
+            """Slice the items of a round and add the items they propagate to.
+
+            Returns:
+                Number of items sliced, i.e., not visited before for their seeds at
+                the same or a smaller depth
+            """
+            # Maps (work item key, depth) -> index of the item in work_items, to
+            # merge the masks of the same item reached by several paths in a round
+            work_item_indices: Dict[Tuple[Tuple[int, Tuple[Value, ...]], int], int] = {}
+            work_items: List[WorkItem] = []
+            with STAGE_TIMER.stage("worklist_bookkeeping"):
+                for function, values, seed_mask, depth in round_items:
+                    work_item_key = (
+                        function.function_id, tuple(sorted(values, key=str))
+                    )
+                    seed_depths = visited_depths.setdefault(work_item_key, {})
+                    new_seed_mask = 0
+                    for seed_index in range(seed_mask.bit_length()):
+                        if not seed_mask >> seed_index & 1:
+                            continue
+                        if seed_depths.get(seed_index, self.call_depth + 1) > depth:
+                            seed_depths[seed_index] = depth
+                            new_seed_mask |= 1 << seed_index
+                    if new_seed_mask == 0:
+                        continue
+                    work_item_index = work_item_indices.get((work_item_key, depth))
+                    if work_item_index is None:
+                        work_item_indices[(work_item_key, depth)] = len(work_items)
+                        work_items.append((function, values, new_seed_mask, depth))
+                    else:
+                        _, _, merged_seed_mask, _ = work_items[work_item_index]
+                        work_items[work_item_index] = (
+                            function,
+                            values,
+                            merged_seed_mask | new_seed_mask,
+                            depth,
+                        )
+
+            # The items of a round are independent, so they are sliced concurrently
+            intra_slicer_outputs = self.process_slices_in_functions(
+                [(function, values) for function, values, _, _ in work_items]
             )
 
-            # Currently, the following code is incomplete.
-            # The worklist algorithm only support the intra-procedural slicing.
-            for ext_value in intra_slicer_output.ext_values:
-                if self.is_backward:
-                    if ext_value["type"] == "Parameter":
-                        # Example: Handle the parameter
-                        # Hint: You need to find the call sites of the function in its caller functions
-                        # and slice the caller functions from the arguments in a backward manner.
-                        # You need to add each pair of caller function and argument to the work list.
-
-                        index = ext_value["index"]
-                        caller_functions = self.u6ir.get_all_caller_functions(function)
-
-                        for caller_function in caller_functions:
-                            call_site_nodes = self.u6ir.get_callsites_by_callee_name(
-                                caller_function, function.function_name
+            with STAGE_TIMER.stage("worklist_bookkeeping"):
+                for (function, values, seed_mask, depth), intra_slicer_output in zip(
+                    work_items, intra_slicer_outputs
+                ):
+                    if intra_slicer_output is None:
+                        continue
+                    line_numbers = intra_slicer_output.line_numbers
+                    if self.is_backward:
+                        line_numbers = self.prune_effect_free_api_calls(
+                            function, values, line_numbers
+                        )
+                    self.state.update_relevant_function_names_to_line_numbers(
+                        function, line_numbers, seed_mask
+                    )
+
+                    if depth >= self.call_depth:
+                        continue
+                    for ext_value in intra_slicer_output.ext_values:
+                        for next_function, next_values in self.get_next_work_items(
+                            function, ext_value
+                        ):
+                            add_work_item(
+                                (next_function, next_values, seed_mask, depth + 1)
                             )
-                            for call_site_node in call_site_nodes:
-                                call_site_id = caller_function.get_call_site_id(
-                                    call_site_node
-                                )
-                                if call_site_id == -1:
-                                    continue
-
-                                args_at_index = caller_function.args(
-                                    call_site_id=call_site_id, index=index
-                                )
-
-                                for arg in args_at_index:
-                                    work_list.append(
-                                        (
-                                            caller_function,
-                                            arg,
-                                        )
-                                    )
-                    elif ext_value["type"] == "Output Value":
-                        # TODO: Add your implementation here.
-                        # Hint: You need to find the callee functions
-                        # and slice the callee functions from its returned value in a backward manner.
-                        # You need to add each pair of callee function and returned value to the work list.
-                        pass
-                else:
-                    if ext_value["type"] == "Argument":
-                        # TODO: Add your implementation here.
-                        # Hint: You need to find the callee functions
-                        # and slice the callee functions from its parameters in a forward manner.
-                        # You need to add each pair of callee function and parameter to the work list.
-                        pass
-                    elif ext_value["type"] == "Return Value":
-                        # TODO: Add your implementation here.
-                        # Hint: You need to find the call sites of the function in its caller functions
-                        # and slice the caller functions from the output value (i.e., call expression) in a forward manner.
-                        # You need to add each pair of caller function and output value to the work list.
-                        pass
+            return len(work_items)
+
+        # Maps SCC rank -> number of rounds over the SCC, across all its visits
+        scc_round_nums: Dict[int, int] = {}
+
+        pending_item_gauge = WORKLIST_PENDING_ITEMS.labels(self.slicing_request_id)
+        processed_item_counter = WORKLIST_PROCESSED_ITEMS.labels(
+            self.slicing_request_id
+        )
+        while pending_scc_ranks:
+            scc_rank = heapq.heappop(pending_scc_ranks)
+            # The rank is pushed again by the items a visit adds to its own SCC,
+            # which the visit processes itself
+            if scc_rank not in pending_items:
+                continue
+
+            # Visit the SCC
+            while scc_rank in pending_items:
+                pending_item_gauge.set(
+                    sum(len(items) for items in pending_items.values())
+                )
+                round_items = pending_items.pop(scc_rank)
+                scc_round_nums[scc_rank] = scc_round_nums.get(scc_rank, 0) + 1
+                if (
+                    scc_rank in self.recursive_scc_ranks
+                    and scc_round_nums[scc_rank] > self.max_scc_iterations
+                ):
+                    self.logger.print_log(
+                        f"Recursive SCC {scc_rank} is not stable after "
+                        f"{self.max_scc_iterations} rounds. "
+                        f"Dropping {len(round_items)} work items."
+                    )
+                    dropped_function_names = [
+                        function.function_name for function, _, _, _ in round_items
+                    ]
+                    self.state.add_truncated_scc_items(
+                        scc_rank, dropped_function_names, len(round_items)
+                    )
+                    break
+
+                with TRACER.span(
+                    "worklist_round",
+                    "agent",
+                    scc_rank=scc_rank,
+                    pending_item_num=len(round_items),
+                ) as span:
+                    processed_item_num = process_round(round_items)
+                    span.set(processed_item_num=processed_item_num)
+                processed_item_counter.inc(processed_item_num)
+        pending_item_gauge.set(0)
 
         state_dict = self.state.to_dict()
+        state_dict["cost"] = {
+            "input_token_cost": self.intra_slicer.input_token_cost
+            - prior_input_token_cost,
+            "output_token_cost": self.intra_slicer.output_token_cost
+            - prior_output_token_cost,
+            "llm_query_num": self.intra_slicer.total_query_num - prior_query_num,
+            "wall_time": time.perf_counter() - start_time,
+        }
         request_id = self.state._slicing_request_id
         slice_info_fn = f"slice_info_{request_id}.json"
         with open(self.res_dir_path + "/" + slice_info_fn, "w") as slice_info_file:
-            json.dump(self.state.to_dict(), slice_info_file, indent=4)
+            json.dump(state_dict, slice_info_file, indent=4)
         self.logger.print_console(
             "The slicing result is saved in " + self.res_dir_path + "/" + slice_info_fn
         )
 
+    def check_seed_name(
+        self, seed_function: Function, seed_name: str, seed_line_number: int
+    ) -> None:
+        """Warn if no identifier of a seed occurs at its line.
+
+        The seed is still sliced, as its name may hold no identifier (e.g., a
+        literal), but a mistyped name or line is reported before any LLM query.
+
+        Args:
+            seed_function: The function containing the seed
+            seed_name: The name of the seed in the slice request
+            seed_line_number: The line number of the seed in the file
+        """
+        identifier_index = seed_function.identifier_index
+        # The functions of the synthetic IRs are not indexed
+        if len(identifier_index) == 0:
+            return
+        line_number = seed_line_number - seed_function.start_line_number + 1
+        if not any(
+            identifier_index.is_mentioned(name, line_number)
+            for name in IDENTIFIER_PATTERN.findall(seed_name)
+        ):
+            self.logger.print_console(
+                f"Warning: The seed {seed_name} does not occur at line "
+                f"{seed_line_number} of {seed_function.function_name}."
+            )
+
+    def get_next_work_items(
+        self, function: Function, ext_value: Dict
+    ) -> List[Tuple[Function, List[Value]]]:
+        """Get the work items an external value of a function slice propagates to.
+
+        Args:
+            function: The function whose slice contains the external value
+            ext_value: The external value reported by the intra-procedural slicer
+
+        Returns:
+            List of pairs of the function to slice and its seed values
+        """
+        next_work_items: List[Tuple[Function, List[Value]]] = []
+        if self.is_backward:
+            if ext_value["type"] == "Parameter":
+                # Slice the caller functions from the arguments at the call sites
+                index = ext_value["index"]
+                caller_functions = self.u6ir.get_all_caller_functions(function)
+
+                for caller_function in caller_functions:
+                    call_site_nodes = self.u6ir.get_callsites_by_callee_name(
+                        caller_function, function.function_name
+                    )
+                    for call_site_node in call_site_nodes:
+                        call_site_id = caller_function.get_call_site_id(call_site_node)
+                        if call_site_id == -1:
+                            continue
+
+                        args_at_index = caller_function.args(
+                            call_site_id=call_site_id, index=index
+                        )
+
+                        for arg in args_at_index:
+                            next_work_items.append((caller_function, [arg]))
+            elif ext_value["type"] == "Output Value":
+                # Slice the callee functions from their return values
+                for callee_function in self.get_callee_functions_at_line(
+                    function, ext_value["callee_name"], ext_value["line_number"]
+                ):
+                    retvals = list(callee_function.retvals())
+                    if len(retvals) > 0:
+                        next_work_items.append((callee_function, retvals))
+        else:
+            if ext_value["type"] == "Argument":
+                # Slice the callee functions from the parameters at the same index
+                for callee_function in self.get_callee_functions_at_line(
+                    function, ext_value["callee_name"], ext_value["line_number"]
+                ):
+                    for para in callee_function.paras():
+                        if para.index == ext_value["index"]:
+                            next_work_items.append((callee_function, [para]))
+            elif ext_value["type"] == "Return Value":
+                # Slice the caller functions from the output values at the call sites
+                caller_functions = self.u6ir.get_all_caller_functions(function)
+
+                for caller_function in caller_functions:
+                    call_site_nodes = self.u6ir.get_callsites_by_callee_name(
+                        caller_function, function.function_name
+                    )
+                    for call_site_node in call_site_nodes:
+                        call_site_id = caller_function.get_call_site_id(call_site_node)
+                        if call_site_id == -1:
+                            continue
+
+                        outval = caller_function.outval(call_site_id)
+                        if outval is not None:
+                            next_work_items.append((caller_function, [outval]))
+        return next_work_items
+
+    def get_callee_functions_at_line(
+        self, function: Function, callee_name: Optional[str], line_number: Optional[int]
+    ) -> List[Function]:
+        """Get the user-defined functions called by name at a line of a function.
+
+        Args:
+            function: The caller function
+            callee_name: The name of the callee function
+            line_number: The line number of the call site in the caller function
+
+        Returns:
+            List of the callee functions
+        """
+        callee_functions: List[Function] = []
+        if callee_name is None or line_number is None:
+            return callee_functions
+        call_sites = function.function_call_site_nodes
+        for call_site_node, name, start_line, end_line in call_sites.values():
+            if name != callee_name or not start_line <= line_number <= end_line:
+                continue
+            for callee_function in self.u6ir.get_callee_functions_by_callsite(
+                function, call_site_node
+            ):
+                if callee_function not in callee_functions:
+                    callee_functions.append(callee_function)
+        return callee_functions
+
+    def prune_effect_free_api_calls(
+        self, function: Function, values: List[Value], line_numbers: List[int]
+    ) -> List[int]:
+        """Remove the calls of effect-free library APIs from a backward slice.
+
+        A line holding only a call to a modeled API that modifies no value and
+        whose return value is discarded (e.g., printf) cannot influence the seed
+        values, whatever the LLM answers. The lines of the seed values are kept.
+
+        Args:
+            function: The sliced function
+            values: The seed values of the slice
+            line_numbers: Line numbers of the slice in the function
+
+        Returns:
+            Line numbers of the slice without the effect-free calls
+        """
+        callee_apis = self.u6ir.get_callee_apis_by_call_site(function)
+        if not callee_apis:
+            return line_numbers
+        call_site_nums: Dict[int, int] = {}
+        for _, _, start_line, _ in function.all_call_site_nodes.values():
+            call_site_nums[start_line] = call_site_nums.get(start_line, 0) + 1
+        seed_lines = {value.line_number_in_function for value in values}
+        code_lines = function.function_code.split("\n")
+
+        effect_free_lines: Set[int] = set()
+        for call_site_id, api in callee_apis.items():
+            if api.model is None or not api.model.is_effect_free():
+                continue
+            _, callee_name, start_line, end_line = function.all_call_site_nodes[
+                call_site_id
+            ]
+            # Nested calls may have effects of their own
+            if start_line != end_line or call_site_nums[start_line] != 1:
+                continue
+            if start_line in seed_lines or not 1 <= start_line <= len(code_lines):
+                continue
+            match = DISCARDED_CALL_PATTERN.match(code_lines[start_line - 1])
+            if (
+                match is not None
+                and match.group(1) == callee_name
+                and not SIDE_EFFECT_PATTERN.search(
+                    LITERAL_PATTERN.sub('""', match.group(2))
+                )
+            ):
+                effect_free_lines.add(start_line)
+
+        pruned_line_numbers = [
+            line_number
+            for line_number in line_numbers
+            if line_number not in effect_free_lines
+        ]
+        if len(pruned_line_numbers) < len(line_numbers):
+            PRUNED_API_CALL_LINES.inc(len(line_numbers) - len(pruned_line_numbers))
+            self.logger.print_log(
+                f"Pruned the effect-free library calls at lines "
+                f"{sorted(set(line_numbers) & effect_free_lines)} "
+                f"from the slice of {function.function_name}"
+            )
+        return pruned_line_numbers
+
+    def process_slices_in_functions(
+        self, slice_inputs: List[Tuple[Function, List[Value]]]
+    ) -> List[Optional[IntraSlicerOutput]]:
+        """Process the slices in several functions with up to max_llm_workers threads.
+
+        Args:
+            slice_inputs: Pairs of the function to process and its seed values
+
+        Returns:
+            The outputs of the intra-procedural slicer, in the order of the inputs
+        """
+        if self.max_llm_workers <= 1 or len(slice_inputs) <= 1:
+            return [
+                self.process_slice_in_single_function(function, values)
+                for function, values in slice_inputs
+            ]
+        with concurrent.futures.ThreadPoolExecutor(
+            max_workers=min(self.max_llm_workers, len(slice_inputs))
+        ) as executor:
+            return list(
+                executor.map(
+                    lambda slice_input: self.process_slice_in_single_function(
+                        *slice_input
+                    ),
+                    slice_inputs,
+                )
+            )
+
     def process_slice_in_single_function(
-        self, function: Function, value: Value
+        self, function: Function, values: List[Value]
     ) -> Optional[IntraSlicerOutput]:
         """Process the slice in a single function.
 
         Args:
             function: The function to process
-            value: The value as the seed value for slicing in the function
+            values: The values as the seed values for slicing in the function
         """
-        intra_slicer_input = IntraSlicerInput(function, [value], self.is_backward)
-        intra_slicer_output = self.intra_slicer.invoke(intra_slicer_input)
+        callee_apis = self.u6ir.get_all_callee_apis(function)
+        ACTIVE_SLICING_WORKERS.inc()
+        try:
+            if self.chunked_slicer is not None and self.chunked_slicer.is_chunked(
+                function
+            ):
+                intra_slicer_output = self.chunked_slicer.slice(
+                    function, values, self.is_backward, callee_apis
+                )
+            else:
+                with self.query_slots:
+                    intra_slicer_output = self.intra_slicer.invoke(
+                        IntraSlicerInput(
+                            function, values, self.is_backward, callee_apis
+                        )
+                    )
+        finally:
+            ACTIVE_SLICING_WORKERS.dec()
         return intra_slicer_output
 
     def finalize(self) -> U6IR:
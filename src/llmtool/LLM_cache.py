@@ -0,0 +1,118 @@
+"""Content-addressed cache of LLM answers shared by processes and hosts.
+
+The answers are stored as files under a cache directory (e.g., on a shared file
+system), addressed by the hash of the model, temperature, system role and
+message. Each file is written to a temporary name and renamed, so that readers on
+other processes never see a partial answer, and concurrent writers of the same
+answer simply replace each other.
+
+As in the LLM trace (see llmtool/LLM_trace.py), a message may be answered several
+times, e.g., on the retries of an unparsable answer. The n-th query of a message
+in a process is answered by the n-th cached answer, and queried (then cached) if
+no process stored it yet.
+"""
+
+import json
+import os
+import tempfile
+import threading
+from pathlib import Path
+from typing import Dict, Optional, Tuple
+
+from llmtool.LLM_trace import get_message_key
+
+
+class LLMCache:
+    """Thread-safe on-disk cache of LLM answers, inactive by default."""
+
+    def __init__(self) -> None:
+        self.cache_dir: Optional[Path] = None
+        self.hit_num = 0
+        self.miss_num = 0
+        self._lock = threading.Lock()
+        # Maps keys -> number of answers of the key served in this process
+        self._answered_nums: Dict[str, int] = {}
+
+    @property
+    def is_enabled(self) -> bool:
+        return self.cache_dir is not None
+
+    def enable(self, cache_dir: str) -> None:
+        """Answer the following queries from a cache directory and fill it.
+
+        Args:
+            cache_dir: Directory of the cache, created if missing
+        """
+        Path(cache_dir).mkdir(parents=True, exist_ok=True)
+        with self._lock:
+            self.cache_dir = Path(cache_dir)
+            self._answered_nums = {}
+
+    def disable(self) -> None:
+        """Stop using the cache directory."""
+        with self._lock:
+            self.cache_dir = None
+
+    def get_key(
+        self, model_name: str, temperature: float, system_role: str, message: str
+    ) -> str:
+        """Get the key of a query in the cache."""
+        return get_message_key(
+            json.dumps([model_name, temperature, system_role, message])
+        )
+
+    def _get_answer_path(self, key: str, answer_index: int) -> Path:
+        assert self.cache_dir is not None
+        # Fanning out by the first byte of the key keeps the directories small
+        return self.cache_dir / key[:2] / f"{key}.{answer_index}.json"
+
+    def get(self, key: str) -> Tuple[Optional[str], int]:
+        """Get the next cached answer of a query in this process.
+
+        Args:
+            key: Key of the query (see get_key)
+
+        Returns:
+            Tuple of (the cached answer, or None if it is not cached yet, and the
+            index of the answer). On a miss, the caller queries the model and
+            stores the answer with put.
+        """
+        with self._lock:
+            if self.cache_dir is None:
+                return None, 0
+            answer_index = self._answered_nums.get(key, 0)
+            answer_path = self._get_answer_path(key, answer_index)
+            self._answered_nums[key] = answer_index + 1
+        try:
+            with open(answer_path, "r", encoding="utf-8") as f:
+                output = json.load(f)["output"]
+        except FileNotFoundError:
+            with self._lock:
+                self.miss_num += 1
+            return None, answer_index
+        with self._lock:
+            self.hit_num += 1
+        return output, answer_index
+
+    def put(self, key: str, answer_index: int, model_name: str, output: str) -> None:
+        """Store an answer missed by get.
+
+        Args:
+            key: Key of the query
+            answer_index: Index of the answer returned by get
+            model_name: Name of the model that answered
+            output: Answer of the model
+        """
+        with self._lock:
+            if self.cache_dir is None:
+                return
+            answer_path = self._get_answer_path(key, answer_index)
+        answer_path.parent.mkdir(parents=True, exist_ok=True)
+        fd, tmp_path = tempfile.mkstemp(dir=answer_path.parent, suffix=".tmp")
+        with os.fdopen(fd, "w", encoding="utf-8") as f:
+            json.dump({"model": model_name, "output": output}, f)
+        os.replace(tmp_path, answer_path)
+
+
+# The cache shared by all the LLM queries of a process
+LLM_CACHE = LLMCache()
@@ -0,0 +1,219 @@
+"""Deterministic LLM stand-in for benchmarking the slicing pipeline offline.
+
+The mock answers slicing prompts with a name-based def-use closure over the target
+function, formatted like a real LLM answer, so that prompt rendering, response
+parsing and the inter-procedural worklist are exercised without any API call.
+The answers are only meant to be plausible and reproducible, not precise.
+"""
+
+import re
+import time
+from typing import Dict, List, Set, Tuple
+
+FUNCTION_PATTERN = re.compile(r"target function: \s*```\n(?P<function>.*?)\n```", re.S)
+SEED_PATTERN = re.compile(
+    r"`(?P<name>[^`]+)`(?: \(at index \d+\))? at line (?P<line>\d+)"
+)
+LINED_CODE_PATTERN = re.compile(r"^(?P<line_number>\d+)\. ?(?P<code>.*)$")
+IDENTIFIER_PATTERN = re.compile(r"[A-Za-z_]\w*")
+CALL_PATTERN = re.compile(r"([A-Za-z_]\w*)\s*\(")
+ASSIGNMENT_PATTERN = re.compile(
+    r"^\s*(?:[A-Za-z_][\w\s\*]*?\s+\**)?(?P<lhs>[A-Za-z_]\w*)"
+    r"\s*(?:\[[^\]]*\]\s*)*(?:[+\-*/%&|^]|<<|>>)?=(?!=)\s*(?P<rhs>.*)$"
+)
+
+C_KEYWORDS = {
+    "if", "else", "for", "while", "do", "return", "switch", "case", "break",
+    "continue", "sizeof", "int", "char", "float", "double", "long", "short",
+    "unsigned", "signed", "void", "const", "static", "struct", "NULL",
+}  # fmt: skip
+
+
+def parse_mock_latency(model_name: str) -> float:
+    """Parse the simulated latency (in seconds) of a mock model name.
+
+    "mock" answers immediately, and "mock-<ms>" sleeps <ms> milliseconds per query.
+
+    Args:
+        model_name: Name of the mock model
+
+    Returns:
+        Simulated latency in seconds
+    """
+    match = re.fullmatch(r"mock-(\d+)", model_name)
+    return int(match.group(1)) / 1000.0 if match else 0.0
+
+
+def _split_arguments(arguments: str) -> List[str]:
+    """Split the arguments of a call at the top-level commas."""
+    depth = 0
+    current = ""
+    result: List[str] = []
+    for ch in arguments:
+        if ch == "," and depth == 0:
+            result.append(current)
+            current = ""
+            continue
+        if ch in "([{":
+            depth += 1
+        elif ch in ")]}":
+            if depth == 0:
+                break
+            depth -= 1
+        current += ch
+    if current.strip():
+        result.append(current)
+    return result
+
+
+def _get_call_arguments(code: str) -> List[Tuple[str, List[str]]]:
+    """Get the callee names and arguments of the calls in a line of code."""
+    calls: List[Tuple[str, List[str]]] = []
+    for match in CALL_PATTERN.finditer(code):
+        if match.group(1) in C_KEYWORDS:
+            continue
+        calls.append((match.group(1), _split_arguments(code[match.end() :])))
+    return calls
+
+
+def _identifiers(code: str) -> Set[str]:
+    """Get the identifiers used in a line of code, excluding keywords."""
+    return set(IDENTIFIER_PATTERN.findall(code)) - C_KEYWORDS
+
+
+def _get_parameters(lines: Dict[int, str]) -> List[str]:
+    """Get the parameter names from the signature of the function."""
+    signature = ""
+    for line_number in sorted(lines):
+        signature += lines[line_number]
+        if "{" in lines[line_number] or ")" in lines[line_number]:
+            break
+    calls = _get_call_arguments(signature)
+    if not calls:
+        return []
+    parameters = []
+    for parameter in calls[0][1]:
+        names = IDENTIFIER_PATTERN.findall(parameter)
+        if names and names[-1] != "void":
+            parameters.append(names[-1])
+    return parameters
+
+
+def render_mock_slice_response(message: str) -> str:
+    """Answer a slicing prompt deterministically.
+
+    Args:
+        message: The slicing prompt rendered by IntraSlicer
+
+    Returns:
+        Response in the answer format of the slicing prompts
+    """
+    is_backward = "influence" in message
+    lines: Dict[int, str] = {}
+    function_match = FUNCTION_PATTERN.search(message)
+    if function_match is not None:
+        for lined_code in function_match.group("function").splitlines():
+            lined_code_match = LINED_CODE_PATTERN.match(lined_code)
+            if lined_code_match is not None:
+                lines[int(lined_code_match.group("line_number"))] = (
+                    lined_code_match.group("code")
+                )
+
+    seed_match = SEED_PATTERN.search(message)
+    seed_names = {seed_match.group("name")} if seed_match else set()
+    seed_line_number = int(seed_match.group("line")) if seed_match else 1
+    tracked_names = set().union(*(_identifiers(name) for name in seed_names))
+
+    # Name-based def-use closure until a fixpoint
+    slice_line_numbers: Set[int] = set()
+    if seed_line_number in lines:
+        slice_line_numbers.add(seed_line_number)
+    is_changed = True
+    while is_changed:
+        is_changed = False
+        for line_number, code in lines.items():
+            assignment = ASSIGNMENT_PATTERN.match(code)
+            if assignment is not None:
+                lhs = assignment.group("lhs")
+                rhs_names = _identifiers(assignment.group("rhs"))
+                if is_backward and lhs in tracked_names:
+                    new_names = rhs_names - tracked_names
+                elif not is_backward and rhs_names & tracked_names:
+                    new_names = {lhs} - tracked_names
+                else:
+                    continue
+            elif _identifiers(code) & tracked_names:
+                new_names = set()
+            else:
+                continue
+            if line_number not in slice_line_numbers:
+                slice_line_numbers.add(line_number)
+                is_changed = True
+            if new_names:
+                tracked_names |= new_names
+                is_changed = True
+
+    ext_values: List[str] = []
+    if is_backward:
+        for index, parameter in enumerate(_get_parameters(lines)):
+            if parameter in tracked_names:
+                ext_values.append(f"- Type: Parameter. Index: {index}.")
+        for line_number in sorted(slice_line_numbers):
+            if line_number == 1:
+                continue
+            for callee_name, _ in _get_call_arguments(lines[line_number]):
+                ext_values.append(
+                    f"- Type: Output Value. Callee: {callee_name}. Index: 0. "
+                    f"Line: {line_number}."
+                )
+    else:
+        for line_number in sorted(slice_line_numbers):
+            code = lines[line_number]
+            if line_number == 1:
+                continue
+            for callee_name, arguments in _get_call_arguments(code):
+                for index, argument in enumerate(arguments):
+                    if _identifiers(argument) & tracked_names:
+                        ext_values.append(
+                            f"- Type: Argument. Callee: {callee_name}. "
+                            f"Index: {index}. Line: {line_number}."
+                        )
+            if code.strip().startswith("return") and _identifiers(code) & tracked_names:
+                ext_values.append("- Type: Return Value.")
+
+    if not slice_line_numbers:
+        slice_line_numbers = {1}
+    sorted_line_numbers = sorted(slice_line_numbers)
+    slice_code = "\n".join(
+        lines.get(line_number, "") for line_number in sorted_line_numbers
+    )
+    return "\n".join(
+        [
+            "The slice is computed by the deterministic mock model.",
+            "Answer:",
+            "Slice:",
+            "```",
+            slice_code,
+            "```",
+            "External Variables:",
+            *ext_values,
+            "Line numbers in the slice:",
+            "[" + ", ".join(str(number) for number in sorted_line_numbers) + "]",
+        ]
+    )
+
+
+def infer_with_mock(model_name: str, message: str) -> str:
+    """Answer a prompt with the mock model, after its simulated latency.
+
+    Args:
+        model_name: Name of the mock model ("mock" or "mock-<ms>")
+        message: The prompt
+
+    Returns:
+        The deterministic response
+    """
+    latency = parse_mock_latency(model_name)
+    if latency > 0:
+        time.sleep(latency)
+    return render_mock_slice_response(message)
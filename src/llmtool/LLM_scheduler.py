@@ -0,0 +1,261 @@
+import threading
+import time
+from collections import deque
+from contextlib import contextmanager
+from typing import Deque, Dict, Iterator, List, Optional
+
+
+class _LLMTicket:
+    """A pending LLM query waiting for admission."""
+
+    def __init__(self, cost: int) -> None:
+        self.cost = cost
+        self.enqueue_time = time.monotonic()
+        self.is_granted = False
+
+
+class LLMTenant:
+    """A tenant (e.g., a team or a slice request) sharing the LLM concurrency.
+
+    Tenants are created by LLMScheduler.register_tenant. An LLM tool holding a tenant
+    wraps each LLM query into `with tenant.admit(cost): ...`.
+    """
+
+    def __init__(
+        self,
+        scheduler: "LLMScheduler",
+        name: str,
+        weight: float,
+        max_queries_per_second: Optional[float],
+    ) -> None:
+        """Initialize a tenant.
+
+        Args:
+            scheduler: The scheduler the tenant is registered to
+            name: Name of the tenant
+            weight: Share of the LLM concurrency relative to the other tenants
+            max_queries_per_second: Rate limit of the tenant, or None for no limit
+        """
+        self.scheduler = scheduler
+        self.name = name
+        self.weight = weight
+        self.max_queries_per_second = max_queries_per_second
+
+        # Deficit round-robin state
+        self.deficit = 0.0
+        self.waiting_tickets: Deque[_LLMTicket] = deque()
+
+        # Token bucket of the rate limit. The bucket holds at most one second of
+        # queries (and at least one query), so short bursts are allowed.
+        self.bucket_capacity = max(1.0, max_queries_per_second or 0.0)
+        self.bucket_tokens = self.bucket_capacity
+        self.bucket_refill_time = time.monotonic()
+
+        # Statistics
+        self.granted_query_num = 0
+        self.total_wait_time = 0.0
+
+    def refill_bucket(self, now: float) -> None:
+        """Refill the token bucket of the rate limit.
+
+        Args:
+            now: Current time from time.monotonic()
+        """
+        if self.max_queries_per_second is None:
+            return
+        elapsed_time = now - self.bucket_refill_time
+        self.bucket_tokens = min(
+            self.bucket_capacity,
+            self.bucket_tokens + elapsed_time * self.max_queries_per_second,
+        )
+        self.bucket_refill_time = now
+
+    def is_rate_limited(self) -> bool:
+        """Check whether the tenant has to wait for its rate limit."""
+        return self.max_queries_per_second is not None and self.bucket_tokens < 1.0
+
+    def time_to_next_token(self) -> float:
+        """Get the time (in seconds) until the rate limit admits the next query."""
+        if not self.is_rate_limited():
+            return 0.0
+        assert self.max_queries_per_second is not None
+        return (1.0 - self.bucket_tokens) / self.max_queries_per_second
+
+    @contextmanager
+    def admit(self, cost: int = 1) -> Iterator[None]:
+        """Hold an LLM slot of the scheduler for the duration of a query.
+
+        Args:
+            cost: Cost of the query (e.g., its estimated number of prompt tokens)
+        """
+        self.scheduler.acquire(self, cost)
+        try:
+            yield
+        finally:
+            self.scheduler.release(self)
+
+    def to_dict(self) -> dict:
+        """Convert the tenant statistics to dictionary representation.
+
+        Returns:
+            Dictionary containing the tenant configuration and statistics
+        """
+        return {
+            "name": self.name,
+            "weight": self.weight,
+            "max_queries_per_second": self.max_queries_per_second,
+            "granted_query_num": self.granted_query_num,
+            "total_wait_time": self.total_wait_time,
+        }
+
+
+class LLMScheduler:
+    """Fair admission of LLM queries issued by concurrent agents.
+
+    The scheduler bounds the number of in-flight LLM queries of all the tenants and
+    admits the waiting queries by deficit round-robin (DRR): each time the round
+    robin visits a tenant, the deficit of the tenant grows by its weighted quantum,
+    and the tenant may start queries as long as their costs fit into the deficit.
+    A tenant's deficit is dropped once it has no waiting query, so idle tenants do
+    not hoard credit. Per-tenant rate limits are enforced with token buckets.
+
+    With costs measured in prompt tokens, a tenant issuing huge prompts gets the
+    same token throughput as the others (scaled by the weights), and the queries of
+    small requests are admitted within one round of the round robin.
+    """
+
+    def __init__(self, max_concurrency: int, quantum: int = 4096) -> None:
+        """Initialize the scheduler.
+
+        Args:
+            max_concurrency: Maximum number of in-flight LLM queries of all tenants
+            quantum: Cost credited to a tenant of weight 1.0 per round-robin visit
+        """
+        assert max_concurrency > 0, "max_concurrency must be positive"
+        self.max_concurrency = max_concurrency
+        self.quantum = quantum
+
+        self._condition = threading.Condition()
+        self._tenants: List[LLMTenant] = []
+        self._tenant_names: Dict[str, LLMTenant] = {}
+        self._next_tenant_index = 0
+        self._is_visit_started = False
+        self._active_query_num = 0
+
+    def register_tenant(
+        self,
+        name: str,
+        weight: float = 1.0,
+        max_queries_per_second: Optional[float] = None,
+    ) -> LLMTenant:
+        """Register a tenant, or return the tenant registered with the same name.
+
+        Args:
+            name: Name of the tenant
+            weight: Share of the LLM concurrency relative to the other tenants
+            max_queries_per_second: Rate limit of the tenant, or None for no limit
+
+        Returns:
+            The tenant
+        """
+        assert weight > 0, "weight must be positive"
+        with self._condition:
+            if name not in self._tenant_names:
+                tenant = LLMTenant(self, name, weight, max_queries_per_second)
+                self._tenants.append(tenant)
+                self._tenant_names[name] = tenant
+            return self._tenant_names[name]
+
+    def get_tenants(self) -> List[LLMTenant]:
+        """Get all the registered tenants."""
+        with self._condition:
+            return list(self._tenants)
+
+    def acquire(self, tenant: LLMTenant, cost: int = 1) -> None:
+        """Block until the scheduler admits a query of the tenant.
+
+        Args:
+            tenant: The tenant issuing the query
+            cost: Cost of the query
+        """
+        ticket = _LLMTicket(max(1, cost))
+        with self._condition:
+            tenant.waiting_tickets.append(ticket)
+            self._dispatch()
+            while not ticket.is_granted:
+                # Wake up for the rate limits even if no query finishes
+                self._condition.wait(timeout=self._get_wait_timeout())
+                self._dispatch()
+            tenant.total_wait_time += time.monotonic() - ticket.enqueue_time
+
+    def release(self, tenant: LLMTenant) -> None:
+        """Release the slot of a finished query.
+
+        Args:
+            tenant: The tenant whose query finished
+        """
+        with self._condition:
+            self._active_query_num -= 1
+            self._dispatch()
+
+    def _get_wait_timeout(self) -> Optional[float]:
+        """Get how long a waiting query may sleep before the next dispatch."""
+        delays = [
+            tenant.time_to_next_token()
+            for tenant in self._tenants
+            if tenant.waiting_tickets and tenant.is_rate_limited()
+        ]
+        return min(delays) + 0.001 if delays else None
+
+    def _advance(self) -> None:
+        """Move the round robin to the next tenant."""
+        self._next_tenant_index = (self._next_tenant_index + 1) % len(self._tenants)
+        self._is_visit_started = False
+
+    def _dispatch(self) -> None:
+        """Admit waiting queries by deficit round-robin. Requires the lock."""
+        now = time.monotonic()
+        for tenant in self._tenants:
+            tenant.refill_bucket(now)
+
+        is_granted = False
+        while self._active_query_num < self.max_concurrency:
+            if not any(
+                tenant.waiting_tickets and not tenant.is_rate_limited()
+                for tenant in self._tenants
+            ):
+                break
+
+            tenant = self._tenants[self._next_tenant_index]
+            if not tenant.waiting_tickets:
+                tenant.deficit = 0.0
+                self._advance()
+                continue
+            if tenant.is_rate_limited():
+                self._advance()
+                continue
+
+            if not self._is_visit_started:
+                tenant.deficit += self.quantum * tenant.weight
+                self._is_visit_started = True
+
+            ticket = tenant.waiting_tickets[0]
+            if ticket.cost > tenant.deficit:
+                self._advance()
+                continue
+
+            tenant.waiting_tickets.popleft()
+            tenant.deficit -= ticket.cost
+            if tenant.max_queries_per_second is not None:
+                tenant.bucket_tokens -= 1.0
+            tenant.granted_query_num += 1
+            ticket.is_granted = True
+            self._active_query_num += 1
+            is_granted = True
+
+            if not tenant.waiting_tickets:
+                tenant.deficit = 0.0
+                self._advance()
+
+        if is_granted:
+            self._condition.notify_all()
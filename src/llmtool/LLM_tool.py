@@ -1,3 +1,4 @@
+import time
 from abc import ABC, abstractmethod
 from threading import Lock
 from typing import (
@@ -12,8 +13,24 @@ from typing import (
     get_origin,
 )
 
+from llmtool.LLM_scheduler import LLMTenant
 from llmtool.LLM_utils import LLM
+from utility.interaction_log import INTERACTION_LOG_NAME, LogBuffer
 from utility.logger import Logger
+from utility.metrics import METRICS
+from utility.stage_timer import STAGE_TIMER
+from utility.tracer import TRACER
+
+LLM_TOOL_INVOCATIONS = METRICS.counter(
+    "reposlice_llm_tool_invocations_total",
+    "LLM tool invocations by tool and result (cache_hit, parsed or unparsed)",
+    ["tool", "result"],
+)
+LLM_TOOL_LATENCY = METRICS.histogram(
+    "reposlice_llm_tool_latency_seconds",
+    "Latency of the LLM tool invocations, including retries",
+    ["tool"],
+)
 
 
 class LLMToolInput(ABC):
@@ -58,6 +75,7 @@ class LLMTool(Generic[TInput, TOutput], ABC):
         language: str,
         max_query_num: int,
         logger: Logger,
+        llm_tenant: Optional[LLMTenant] = None,
     ) -> None:
         """Initialize LLM tool.
 
@@ -67,12 +85,15 @@ class LLMTool(Generic[TInput, TOutput], ABC):
             language: Programming language being analyzed
             max_query_num: Maximum number of LLM queries allowed for re-tries
             logger: Logger instance for tracking
+            llm_tenant: Tenant of a shared LLMScheduler admitting the LLM queries,
+                or None to query the LLM without admission control
         """
         self.model_name = model_name
         self.temperature = temperature
         self.language = language
         self.max_query_num = max_query_num
         self.logger = logger
+        self.llm_tenant = llm_tenant
 
         self.model = LLM(model_name, temperature)
         self.cache: Dict[TInput, TOutput] = {}
@@ -138,20 +159,20 @@ class LLMTool(Generic[TInput, TOutput], ABC):
                 f"Expected input of type {self._input_type}, but got {type(input)}"
             )
 
-        log_strs = []
-        log_strs.append("\n")
-        log_strs.append("================================================")
+        # The prompts and responses are logged in the interaction log, so the
+        # messages of a call are short and bounded
+        log_strs = LogBuffer()
         log_strs.append("LLM Tool Log starts...")
-        log_strs.append("================================================")
 
-        output, log_strs = self._invoke(input, log_strs)
+        start_time = time.perf_counter()
+        with TRACER.span(f"{type(self).__name__}.invoke", "llm_tool"):
+            output, log_strs = self._invoke(input, log_strs)
+        LLM_TOOL_LATENCY.labels(type(self).__name__).observe(
+            time.perf_counter() - start_time
+        )
 
-        log_strs.append("================================================")
         log_strs.append("LLM Tool Log ends...")
-        log_strs.append("================================================")
-        log_strs.append("\n")
-
-        self.logger.print_log("\n".join(log_strs))
+        self.logger.print_debug("\n".join(log_strs))
 
         if output is not None and not isinstance(output, self._output_type):
             raise TypeError(
@@ -174,50 +195,100 @@ class LLMTool(Generic[TInput, TOutput], ABC):
         """
         class_name = type(self).__name__
         log_strs.append(f"The LLM Tool {class_name} is invoked.")
+        span = TRACER.current_span()
         if input in self.cache:
             log_strs.append("Cache hit.")
+            span.set(is_cache_hit=True)
+            self.logger.log_interaction(
+                {"tool": class_name, "model": self.model_name, "event": "cache_hit"}
+            )
+            LLM_TOOL_INVOCATIONS.labels(class_name, "cache_hit").inc()
             return self.cache[input], log_strs
 
-        prompt = self._get_prompt(input)
-        log_strs.append("------------------------------------------------")
-        log_strs.append("Prompt:")
-        log_strs.append("------------------------------------------------")
-        log_strs.append(prompt)
-        log_strs.append("------------------------------------------------")
+        with STAGE_TIMER.stage("prompt_rendering"):
+            prompt = self._get_prompt(input)
+        log_strs.append(
+            f"Prompt: {len(prompt)} characters (see {INTERACTION_LOG_NAME})"
+        )
 
         single_query_num = 0
+        input_token_sum = 0
+        output_token_sum = 0
         output = None
         while True:
             if single_query_num > self.max_query_num:
                 break
             single_query_num += 1
-            response, input_token_cost, output_token_cost, log_strs = self.model.infer(
-                prompt, True, log_strs
+            query_start_time = time.perf_counter()
+            with STAGE_TIMER.stage("llm_wait"):
+                response, input_token_cost, output_token_cost, log_strs = (
+                    self._infer(prompt, log_strs)
+                )
+            latency = time.perf_counter() - query_start_time
+            log_strs.append(f"Response: {len(response)} characters")
+
+            with self.lock:
+                self.input_token_cost += input_token_cost
+                self.output_token_cost += output_token_cost
+            input_token_sum += input_token_cost
+            output_token_sum += output_token_cost
+            with STAGE_TIMER.stage("response_parsing"):
+                output = self._parse_response(response, input)
+            self.logger.log_interaction(
+                {
+                    "tool": class_name,
+                    "model": self.model_name,
+                    "event": "query",
+                    "attempt": single_query_num,
+                    "input_token_cost": input_token_cost,
+                    "output_token_cost": output_token_cost,
+                    "latency": latency,
+                    "is_parsed": output is not None,
+                },
+                prompt,
+                response,
             )
-            log_strs.append("------------------------------------------------")
-            log_strs.append("Response:")
-            log_strs.append("------------------------------------------------")
-            log_strs.append(response)
-            log_strs.append("------------------------------------------------")
-
-            self.input_token_cost += input_token_cost
-            self.output_token_cost += output_token_cost
-            output = self._parse_response(response, input)
 
             if output is not None:
                 break
 
-        log_strs.append("------------------------------------------------")
-        log_strs.append("Output:")
-        log_strs.append("------------------------------------------------")
-        log_strs.append(str(output))
-        log_strs.append("------------------------------------------------")
+        log_strs.append(f"Output: {output}")
 
-        self.total_query_num += single_query_num
-        if output is not None:
-            self.cache[input] = output
+        with self.lock:
+            self.total_query_num += single_query_num
+            if output is not None:
+                self.cache[input] = output
+        span.set(
+            is_cache_hit=False,
+            attempt_num=single_query_num,
+            input_token_cost=input_token_sum,
+            output_token_cost=output_token_sum,
+            is_parsed=output is not None,
+        )
+        LLM_TOOL_INVOCATIONS.labels(
+            class_name, "parsed" if output is not None else "unparsed"
+        ).inc()
         return output, log_strs
 
+    def _infer(
+        self, prompt: str, log_strs: List[str]
+    ) -> Tuple[str, int, int, List[str]]:
+        """Query the LLM, waiting for the admission of the tenant if there is one.
+
+        Args:
+            prompt: The prompt to send to the LLM
+            log_strs: List of log strings to append to
+
+        Returns:
+            Tuple of (response, input token cost, output token cost, log strings)
+        """
+        if self.llm_tenant is None:
+            return self.model.infer(prompt, True, log_strs)
+
+        # The cost of a query is its approximate number of prompt tokens
+        with self.llm_tenant.admit(len(prompt) // 4 + 1):
+            return self.model.infer(prompt, True, log_strs)
+
     @abstractmethod
     def _get_prompt(self, input: TInput) -> str:
         """Type-safe generate prompt for LLM from input.
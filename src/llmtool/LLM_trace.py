@@ -0,0 +1,170 @@
+"""Recording and replay of the LLM answers of a run.
+
+A recorded trace is a JSONL file with one line per answered message. Replaying it
+answers every message the recorded run asked without querying any provider, so
+that a change of the slicing pipeline can be measured on the exact LLM answers of
+a reference run, e.g., by the regression check (see utility/regression_check.py).
+"""
+
+import hashlib
+import json
+import threading
+import time
+from typing import Dict, List, Optional, TextIO, Tuple
+
+from utility.errors import RALLMAPIError
+
+
+def get_message_key(message: str) -> str:
+    """Get the hash of a message."""
+    return hashlib.sha256(message.encode("utf-8")).hexdigest()
+
+
+def get_query_key(model_name: str, temperature: float, message: str) -> str:
+    """Get the key of a query in a trace.
+
+    The model and the temperature are part of the key, so that a trace recorded
+    with one model is not replayed as the answers of another.
+    """
+    return get_message_key(json.dumps([model_name, temperature, message]))
+
+
+class LLMTrace:
+    """Thread-safe recorder and replayer of the LLM answers of a run.
+
+    The trace is inactive by default. A query, i.e., a message sent to a model at
+    a temperature, is keyed by get_query_key. A message answered several times (e.g., on
+    the retries of an unparsable answer) is replayed with its answers in the
+    recorded order, the last one being repeated. When only replaying, a message
+    missing from the trace raises an error instead of querying the provider, as
+    the replayed run would otherwise silently depend on a live model. When also
+    recording, the missing messages are queried and recorded, so that a trace can
+    be completed incrementally.
+    """
+
+    def __init__(self) -> None:
+        self.is_recording = False
+        self.is_replaying = False
+        self._lock = threading.Lock()
+        self.is_latency_simulated = False
+        # Maps message keys -> (answer, latency in seconds) in the recorded order
+        self._outputs: Dict[str, List[Tuple[str, float]]] = {}
+        self._replayed_nums: Dict[str, int] = {}
+        self._trace_file: Optional[TextIO] = None
+
+    def start_recording(self, trace_path: str) -> None:
+        """Append the answers of the following queries to a trace file.
+
+        Args:
+            trace_path: Path of the JSONL trace file
+        """
+        with self._lock:
+            self._trace_file = open(trace_path, "a", encoding="utf-8")
+            self.is_recording = True
+
+    def start_replaying(
+        self, trace_path: str, is_latency_simulated: bool = False
+    ) -> None:
+        """Answer the following queries from a trace file.
+
+        Args:
+            trace_path: Path of the JSONL trace file
+            is_latency_simulated: Whether a replayed answer waits for the recorded
+                latency of the query, so that the wall time of the run stays
+                representative of live queries
+        """
+        outputs: Dict[str, List[Tuple[str, float]]] = {}
+        with open(trace_path, "r", encoding="utf-8") as f:
+            for line in f:
+                if not line.strip():
+                    continue
+                entry = json.loads(line)
+                outputs.setdefault(entry["message_key"], []).append(
+                    (entry["output"], entry.get("latency", 0.0))
+                )
+        with self._lock:
+            self._outputs = outputs
+            self._replayed_nums = {}
+            self.is_latency_simulated = is_latency_simulated
+            self.is_replaying = True
+
+    def stop(self) -> None:
+        """Stop recording or replaying, and close the recorded trace file."""
+        with self._lock:
+            self.is_recording = False
+            self.is_replaying = False
+            if self._trace_file is not None:
+                self._trace_file.close()
+                self._trace_file = None
+
+    def record(
+        self,
+        model_name: str,
+        temperature: float,
+        message: str,
+        output: str,
+        latency: float,
+    ) -> None:
+        """Record the answer of a message.
+
+        Args:
+            model_name: Name of the model that answered
+            temperature: Sampling temperature of the query
+            message: Message sent to the model
+            output: Answer of the model
+            latency: Seconds the model took to answer
+        """
+        if not self.is_recording:
+            return
+        entry = {
+            "message_key": get_query_key(model_name, temperature, message),
+            "model": model_name,
+            "temperature": temperature,
+            "output": output,
+            "latency": latency,
+        }
+        with self._lock:
+            if self._trace_file is None:
+                return
+            self._trace_file.write(json.dumps(entry) + "\n")
+            # Flush per answer, so that an interrupted run keeps its trace
+            self._trace_file.flush()
+
+    def replay(
+        self, model_name: str, temperature: float, message: str
+    ) -> Optional[str]:
+        """Get the recorded answer of a message.
+
+        Args:
+            model_name: Name of the model the message is sent to
+            temperature: Sampling temperature of the query
+            message: Message sent to the model
+
+        Returns:
+            The recorded answer, or None if the message is not in the trace and the
+            missing messages are recorded
+
+        Raises:
+            RALLMAPIError: If the message is not in the trace and is not recorded
+        """
+        message_key = get_query_key(model_name, temperature, message)
+        with self._lock:
+            outputs = self._outputs.get(message_key)
+            if outputs is None:
+                if self.is_recording:
+                    return None
+                raise RALLMAPIError(
+                    f"The message to {model_name} at temperature {temperature} is "
+                    "not in the replayed LLM trace; record the trace again with "
+                    "--llm-record-path"
+                )
+            replayed_num = self._replayed_nums.get(message_key, 0)
+            self._replayed_nums[message_key] = replayed_num + 1
+            output, latency = outputs[min(replayed_num, len(outputs) - 1)]
+        if self.is_latency_simulated:
+            time.sleep(latency)
+        return output
+
+
+# The trace shared by all the LLM queries of a process
+LLM_TRACE = LLMTrace()
@@ -7,7 +7,7 @@ import threading
 import time
 from functools import partial
 from pathlib import Path
-from typing import List, Tuple
+from typing import List, Optional, Tuple
 
 import boto3
 import google.generativeai as genai
@@ -16,10 +16,35 @@ from botocore.config import Config
 from botocore.exceptions import BotoCoreError, ClientError
 from openai import *
 
+from llmtool.LLM_cache import LLM_CACHE
+from llmtool.LLM_mock import infer_with_mock
+from llmtool.LLM_trace import LLM_TRACE
 from utility.errors import RALLMAPIError, RAValueError
 from utility.logger import Logger
+from utility.metrics import METRICS
+from utility.tracer import TRACER
 import anthropic
 
+LLM_CALLS = METRICS.counter(
+    "reposlice_llm_calls_total",
+    "LLM provider calls by model and outcome (success, empty or error)",
+    ["model", "outcome"],
+)
+LLM_CALL_LATENCY = METRICS.histogram(
+    "reposlice_llm_call_latency_seconds", "Latency of the LLM provider calls", ["model"]
+)
+LLM_ACTIVE_CALLS = METRICS.gauge(
+    "reposlice_llm_active_calls", "LLM provider calls in flight", ["model"]
+)
+LLM_INPUT_TOKENS = METRICS.counter(
+    "reposlice_llm_input_tokens_total", "Input tokens sent to the LLMs", ["model"]
+)
+LLM_OUTPUT_TOKENS = METRICS.counter(
+    "reposlice_llm_output_tokens_total",
+    "Output tokens received from the LLMs",
+    ["model"],
+)
+
 
 class LLM:
     """
@@ -28,6 +53,7 @@ class LLM:
     - OpenAI models (GPT-3.5, GPT-4, etc)
     - DeepSeek models (V3, R1)
     - Anthropic's Claude (3.5 and 3.7)
+    - A deterministic mock ("mock" or "mock-<latency in ms>") for offline benchmarks
     """
 
     def __init__(
@@ -53,7 +79,10 @@ class LLM:
         self.max_output_length = max_output_length
 
     def infer(
-        self, message: str, is_measure_cost: bool = False, log_strs: List[str] = []
+        self,
+        message: str,
+        is_measure_cost: bool = False,
+        log_strs: Optional[List[str]] = None,
     ) -> Tuple[str, int, int, List[str]]:
         """
         Generate a response from the LLM for the given input message.
@@ -70,24 +99,28 @@ class LLM:
             - Output token count (if measuring cost)
             - Updated log messages
         """
+        if log_strs is None:
+            log_strs = []
         log_strs.append(f"{self.online_model_name} is running")
-        print("Message: ", message)
-        print(self.online_model_name)
-
-        output = ""
 
-        if "gemini" in self.online_model_name:
-            output, log_strs = self.infer_with_gemini(message, log_strs)
-        elif "gpt" in self.online_model_name:
-            output, log_strs = self.infer_with_openai_model(message, log_strs)
-        elif "o3-mini" in self.online_model_name or "o4-mini" in self.online_model_name:
-            output, log_strs = self.infer_with_On_mini_model(message, log_strs)
-        elif "claude" in self.online_model_name:
-            output, log_strs = self.infer_with_claude_key(message, log_strs)
-        elif "deepseek" in self.online_model_name:
-            output, log_strs = self.infer_with_deepseek_model(message, log_strs)
-        else:
-            raise RAValueError("Unsupported model name")
+        model_name = self.online_model_name
+        LLM_ACTIVE_CALLS.labels(model_name).inc()
+        start_time = time.perf_counter()
+        outcome = "error"
+        try:
+            with TRACER.span(
+                "LLM.infer", "llm", model=model_name, message_len=len(message)
+            ) as span:
+                output, log_strs = self.infer_with_provider(message, log_strs)
+                span.set(output_len=len(output))
+            # The providers answer an empty output on timeouts and API failures
+            outcome = "success" if output else "empty"
+        finally:
+            LLM_ACTIVE_CALLS.labels(model_name).dec()
+            LLM_CALL_LATENCY.labels(model_name).observe(
+                time.perf_counter() - start_time
+            )
+            LLM_CALLS.labels(model_name, outcome).inc()
 
         input_token_cost = (
             0
@@ -98,11 +131,84 @@ class LLM:
         output_token_cost = (
             0 if not is_measure_cost else len(self.encoding.encode(output))
         )
-
-        print("Output: ", output)
+        LLM_INPUT_TOKENS.labels(model_name).inc(input_token_cost)
+        LLM_OUTPUT_TOKENS.labels(model_name).inc(output_token_cost)
 
         return output, input_token_cost, output_token_cost, log_strs
 
+    def infer_with_provider(
+        self, message: str, log_strs: List[str]
+    ) -> Tuple[str, List[str]]:
+        """
+        Query the provider of the model, or answer from the replayed LLM trace or
+        the shared LLM cache.
+
+        Args:
+            message: Input text to send to the model
+            log_strs: List to collect logging messages
+
+        Returns:
+            Tuple of (generated text response, updated log messages)
+        """
+        if LLM_TRACE.is_replaying:
+            output = LLM_TRACE.replay(
+                self.online_model_name, self.temperature, message
+            )
+            if output is not None:
+                return output, log_strs
+        cache_key = ""
+        answer_index = 0
+        if LLM_CACHE.is_enabled:
+            cache_key = LLM_CACHE.get_key(
+                self.online_model_name, self.temperature, self.systemRole, message
+            )
+            cached_output, answer_index = LLM_CACHE.get(cache_key)
+            if cached_output is not None:
+                log_strs.append("Answered from the shared LLM cache")
+                return cached_output, log_strs
+        start_time = time.perf_counter()
+        output, log_strs = self.infer_with_model(message, log_strs)
+        LLM_TRACE.record(
+            self.online_model_name,
+            self.temperature,
+            message,
+            output,
+            time.perf_counter() - start_time,
+        )
+        # Empty outputs are failed queries, which are not cached
+        if cache_key and output:
+            LLM_CACHE.put(cache_key, answer_index, self.online_model_name, output)
+        return output, log_strs
+
+    def infer_with_model(
+        self, message: str, log_strs: List[str]
+    ) -> Tuple[str, List[str]]:
+        """
+        Dispatch the query to the provider of the model.
+
+        Args:
+            message: Input text to send to the model
+            log_strs: List to collect logging messages
+
+        Returns:
+            Tuple of (generated text response, updated log messages)
+        """
+        if self.online_model_name.startswith("mock"):
+            # Deterministic stand-in for offline benchmarks
+            return infer_with_mock(self.online_model_name, message), log_strs
+        elif "gemini" in self.online_model_name:
+            return self.infer_with_gemini(message, log_strs)
+        elif "gpt" in self.online_model_name:
+            return self.infer_with_openai_model(message, log_strs)
+        elif "o3-mini" in self.online_model_name or "o4-mini" in self.online_model_name:
+            return self.infer_with_On_mini_model(message, log_strs)
+        elif "claude" in self.online_model_name:
+            return self.infer_with_claude_key(message, log_strs)
+        elif "deepseek" in self.online_model_name:
+            return self.infer_with_deepseek_model(message, log_strs)
+        else:
+            raise RAValueError("Unsupported model name")
+
     def run_with_timeout(
         self, func, timeout: int, log_strs: List[str]
     ) -> Tuple[str, List[str]]:
@@ -0,0 +1,328 @@
+"""Chunked intra-procedural slicing of large functions.
+
+A function longer than the chunk size is split into chunks of consecutive lines
+at the boundaries of its control structures: no chunk cuts an if or loop
+statement short enough to fit in a chunk. Each chunk is sliced by a separate
+query on the chunk and the function header, so the prompt size, and the latency
+of each query, is bounded by the chunk size instead of the function size.
+
+The dependencies between the chunks are summarized by the identifiers on the
+slice lines of a chunk (see memory/utils/identifier_index.py):
+- backward, an identifier read in the slice of a chunk becomes a seed of the
+  earlier chunks defining it, i.e., its value at the exit of those chunks;
+- forward, an identifier defined in the slice of a chunk becomes a seed of the
+  later chunks using it, i.e., its value at the entry of those chunks.
+Within a loop spanning several chunks, the chunks after (resp. before) a chunk
+are considered too, for the values flowing along the back edge.
+
+The chunks are sliced in waves: the chunks of the initial seeds first, then the
+chunks with new boundary seeds, each wave in parallel. A chunk is sliced once per
+boundary identifier, so the number of waves is bounded by the number of chunks
+times the number of identifiers, and is small in practice. The slices of the
+chunks are merged into the slice of the function.
+
+The chunked slicer runs in the worker threads of the agent, so its queries take
+the query slots of the agent, which bound the concurrent queries of the agent as
+a whole.
+
+Identifiers aliased through pointers are only tracked by their names, so the
+merged slice may miss the dependencies a whole-function query would find.
+"""
+
+import concurrent.futures
+import threading
+from typing import Dict, Iterable, List, Optional, Set, Tuple
+
+from llmtool.slicescan.intra_slicer import *
+from memory.utils.api import *
+from memory.utils.function import *
+from memory.utils.identifier_index import IdentifierRole
+from memory.utils.value import *
+from utility.metrics import METRICS
+
+SLICED_CHUNKS = METRICS.counter(
+    "reposlice_sliced_chunks_total",
+    "Chunks of large functions sliced by separate intra-procedural queries",
+)
+
+# Roles of the occurrences reading and defining an identifier
+READ_ROLES = [IdentifierRole.USE, IdentifierRole.ARG, IdentifierRole.RET]
+DEF_ROLES = [IdentifierRole.DEF]
+
+# A chunk is the first and last lines of the chunk in the function
+Chunk = Tuple[int, int]
+
+
+def split_function_into_chunks(function: Function, max_chunk_lines: int) -> List[Chunk]:
+    """Split a function into chunks at the boundaries of its control structures.
+
+    A cut between two lines is allowed unless both lines are in an if or loop
+    statement of at most max_chunk_lines lines. Each chunk ends at the last
+    allowed cut within max_chunk_lines lines, or is cut there if there is none.
+
+    Args:
+        function: Function to split
+        max_chunk_lines: Maximum number of lines of a chunk
+
+    Returns:
+        The chunks covering the lines of the function, in order
+    """
+    line_count = function.lined_code.count("\n") + 1
+    # Cut after line i is forbidden if forbidden_cuts[i]
+    forbidden_cuts = [False] * (line_count + 1)
+    for start_line, end_line in list(function.if_statements) + list(
+        function.loop_statements
+    ):
+        start_line = function.file_line2function_line(start_line)
+        end_line = function.file_line2function_line(end_line)
+        if end_line - start_line + 1 > max_chunk_lines:
+            continue
+        for line in range(max(start_line, 1), min(end_line, line_count + 1)):
+            forbidden_cuts[line] = True
+
+    chunks: List[Chunk] = []
+    chunk_start_line = 1
+    while chunk_start_line <= line_count:
+        chunk_end_line = min(chunk_start_line + max_chunk_lines - 1, line_count)
+        if chunk_end_line < line_count:
+            cut_line = chunk_end_line
+            while cut_line >= chunk_start_line and forbidden_cuts[cut_line]:
+                cut_line -= 1
+            if cut_line >= chunk_start_line:
+                chunk_end_line = cut_line
+        chunks.append((chunk_start_line, chunk_end_line))
+        chunk_start_line = chunk_end_line + 1
+    return chunks
+
+
+class ChunkedSlicer:
+    """Slicer of large functions by chunks, built on an intra-procedural slicer."""
+
+    def __init__(
+        self,
+        intra_slicer: IntraSlicer,
+        max_chunk_lines: int,
+        max_workers: int = 1,
+        query_slots: Optional[threading.Semaphore] = None,
+    ) -> None:
+        """Initialize the chunked slicer.
+
+        Args:
+            intra_slicer: Intra-procedural slicer of the chunks
+            max_chunk_lines: Maximum number of lines of a chunk
+            max_workers: Maximum number of chunks of a function sliced concurrently
+            query_slots: Semaphore held by each query, shared with the other
+                queries of the agent, or None if the queries are not bounded
+        """
+        self.intra_slicer = intra_slicer
+        self.max_chunk_lines = max_chunk_lines
+        self.max_workers = max_workers
+        self.query_slots = query_slots
+
+    def is_chunked(self, function: Function) -> bool:
+        """Check whether a function is long enough to be sliced by chunks."""
+        return function.lined_code.count("\n") + 1 > self.max_chunk_lines
+
+    def slice(
+        self,
+        function: Function,
+        seed_values: List[Value],
+        is_backward: bool,
+        callee_apis: Optional[List[API]] = None,
+    ) -> Optional[IntraSlicerOutput]:
+        """Slice a function by chunks.
+
+        Args:
+            function: Function to slice
+            seed_values: Seed values, valid as the seed list of an IntraSlicerInput
+            is_backward: Whether to perform backward slicing
+            callee_apis: Library APIs called by the function
+
+        Returns:
+            The merged slice of the chunks, or None if no chunk could be sliced
+        """
+        chunks = split_function_into_chunks(function, self.max_chunk_lines)
+        self.intra_slicer.logger.print_log(
+            f"Slicing {function.function_name} by {len(chunks)} chunks: {chunks}"
+        )
+
+        # Inputs of the next wave, and the boundary identifiers already seeded in
+        # each chunk
+        pending_inputs: List[IntraSlicerInput] = []
+        seeded_names: Dict[int, Set[str]] = {i: set() for i in range(len(chunks))}
+        seeds_by_chunk: Dict[int, List[Value]] = {}
+        for seed_value in seed_values:
+            chunk_index = self._find_chunk(chunks, seed_value.line_number_in_function)
+            seeds_by_chunk.setdefault(chunk_index, []).append(seed_value)
+        for chunk_index, chunk_seeds in sorted(seeds_by_chunk.items()):
+            pending_inputs.append(
+                IntraSlicerInput(
+                    function, chunk_seeds, is_backward, callee_apis, chunks[chunk_index]
+                )
+            )
+
+        outputs: List[Tuple[Chunk, IntraSlicerOutput]] = []
+        while pending_inputs:
+            wave_inputs, pending_inputs = pending_inputs, []
+            wave_outputs = self._slice_chunks(wave_inputs)
+            for slicer_input, output in zip(wave_inputs, wave_outputs):
+                if output is None or slicer_input.line_range is None:
+                    continue
+                outputs.append((slicer_input.line_range, output))
+                for chunk_index, name, line in self._get_boundary_seeds(
+                    function,
+                    chunks,
+                    slicer_input.line_range,
+                    output.line_numbers,
+                    is_backward,
+                ):
+                    if name in seeded_names[chunk_index]:
+                        continue
+                    seeded_names[chunk_index].add(name)
+                    boundary_seed = Value(
+                        name,
+                        ValueLabel.LOCAL,
+                        function.file_path,
+                        function.start_line_number + line - 1,
+                        function.function_id,
+                        function.function_name,
+                        line,
+                    )
+                    pending_inputs.append(
+                        IntraSlicerInput(
+                            function,
+                            [boundary_seed],
+                            is_backward,
+                            callee_apis,
+                            chunks[chunk_index],
+                        )
+                    )
+
+        if len(outputs) == 0:
+            return None
+        return self._merge_outputs(function, outputs)
+
+    @staticmethod
+    def _find_chunk(chunks: List[Chunk], line_number: int) -> int:
+        """Get the index of the chunk containing a line, or of the closest one."""
+        for chunk_index, (_, end_line) in enumerate(chunks):
+            if line_number <= end_line:
+                return chunk_index
+        return len(chunks) - 1
+
+    def _slice_chunks(
+        self, slicer_inputs: List[IntraSlicerInput]
+    ) -> List[Optional[IntraSlicerOutput]]:
+        """Slice the chunks of a wave with up to max_workers threads."""
+        SLICED_CHUNKS.inc(len(slicer_inputs))
+        if self.max_workers <= 1 or len(slicer_inputs) <= 1:
+            return [self._slice_chunk(input) for input in slicer_inputs]
+        with concurrent.futures.ThreadPoolExecutor(
+            max_workers=min(self.max_workers, len(slicer_inputs))
+        ) as executor:
+            return list(executor.map(self._slice_chunk, slicer_inputs))
+
+    def _slice_chunk(
+        self, slicer_input: IntraSlicerInput
+    ) -> Optional[IntraSlicerOutput]:
+        """Slice a chunk in a query slot, if the queries are bounded."""
+        if self.query_slots is None:
+            return self.intra_slicer.invoke(slicer_input)
+        with self.query_slots:
+            return self.intra_slicer.invoke(slicer_input)
+
+    def _get_boundary_seeds(
+        self,
+        function: Function,
+        chunks: List[Chunk],
+        chunk: Chunk,
+        line_numbers: Iterable[int],
+        is_backward: bool,
+    ) -> List[Tuple[int, str, int]]:
+        """Get the seeds the slice of a chunk induces in the other chunks.
+
+        Args:
+            function: Function sliced by chunks
+            chunks: Chunks of the function
+            chunk: Chunk whose slice is propagated
+            line_numbers: Line numbers of the slice of the chunk
+            is_backward: Whether to perform backward slicing
+
+        Returns:
+            Triples of the index of a chunk, the name of an identifier and the
+            line of its last definition (backward) or first use (forward) there
+        """
+        start_line, end_line = chunk
+        identifier_index = function.identifier_index
+        slice_lines = sorted(
+            {line for line in line_numbers if start_line <= line <= end_line}
+        )
+        source_roles = READ_ROLES if is_backward else DEF_ROLES
+        target_roles = DEF_ROLES if is_backward else READ_ROLES
+
+        # Lines whose occurrences the slice of the chunk depends on (backward) or
+        # flows to (forward), including the loops around the chunk
+        target_ranges: List[Tuple[int, int]] = (
+            [(1, start_line - 1)]
+            if is_backward
+            else [(end_line + 1, chunks[-1][1])]
+        )
+        for loop_start_line, loop_end_line in function.loop_statements:
+            loop_start_line = function.file_line2function_line(loop_start_line)
+            loop_end_line = function.file_line2function_line(loop_end_line)
+            if loop_start_line <= end_line and loop_end_line >= start_line:
+                target_ranges.append((loop_start_line, loop_end_line))
+
+        boundary_seeds: Dict[Tuple[int, str], int] = {}
+        for name in identifier_index.names():
+            if not any(
+                identifier_index.get_occurrences(name, line, line, source_roles)
+                for line in slice_lines
+            ):
+                continue
+            for range_start_line, range_end_line in target_ranges:
+                for line, _, _, _ in identifier_index.get_occurrences(
+                    name, range_start_line, range_end_line, target_roles
+                ):
+                    if start_line <= line <= end_line:
+                        continue
+                    key = (self._find_chunk(chunks, line), name)
+                    if key not in boundary_seeds:
+                        boundary_seeds[key] = line
+                    elif is_backward:
+                        boundary_seeds[key] = max(boundary_seeds[key], line)
+                    else:
+                        boundary_seeds[key] = min(boundary_seeds[key], line)
+        return [
+            (chunk_index, name, line)
+            for (chunk_index, name), line in sorted(boundary_seeds.items())
+        ]
+
+    @staticmethod
+    def _merge_outputs(
+        function: Function, outputs: List[Tuple[Chunk, IntraSlicerOutput]]
+    ) -> IntraSlicerOutput:
+        """Merge the slices of the chunks into the slice of the function.
+
+        Args:
+            function: Function sliced by chunks
+            outputs: Pairs of a chunk and its slice
+
+        Returns:
+            The slice of the function
+        """
+        line_numbers: Set[int] = set()
+        ext_values: List[Dict] = []
+        ext_value_keys: Set[Tuple] = set()
+        slices: List[str] = []
+        for _, output in sorted(outputs, key=lambda chunk_output: chunk_output[0]):
+            line_numbers.update(output.line_numbers)
+            slices.append(output.slice)
+            for ext_value in output.ext_values:
+                key = tuple(sorted((k, str(v)) for k, v in ext_value.items()))
+                if key not in ext_value_keys:
+                    ext_value_keys.add(key)
+                    ext_values.append(ext_value)
+        return IntraSlicerOutput(
+            "\n".join(slices), ext_values, function.lined_code, sorted(line_numbers)
+        )
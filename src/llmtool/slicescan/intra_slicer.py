@@ -1,5 +1,5 @@
 from pathlib import Path
-from typing import List, Set, Optional, Dict
+from typing import List, Set, Optional, Dict, Tuple
 import json
 import time
 
@@ -20,7 +20,12 @@ class IntraSlicerInput(LLMToolInput):
     """
 
     def __init__(
-        self, function: Function, seed_list: List[Value], is_backward: bool = True
+        self,
+        function: Function,
+        seed_list: List[Value],
+        is_backward: bool = True,
+        callee_apis: Optional[List[API]] = None,
+        line_range: Optional[Tuple[int, int]] = None,
     ) -> None:
         """Initialize intra-slicer input.
 
@@ -28,6 +33,11 @@ class IntraSlicerInput(LLMToolInput):
             function: Function to be sliced
             seed_list: List of seed values for slicing
             is_backward: Whether to perform backward slicing (default: True)
+            callee_apis: Library APIs called by the function, whose modeled
+                effects are stated in the prompt
+            line_range: First and last lines of the chunk of the function to
+                slice (see llmtool/slicescan/chunked_slicer.py), or None to slice
+                the whole function
         """
         assert IntraSlicerInput.check_validity_of_seed_list(
             seed_list
@@ -35,6 +45,7 @@ class IntraSlicerInput(LLMToolInput):
 
         self.function = function
         self.is_backward = is_backward
+        self.line_range = line_range
         self.seed_list = sorted(
             set(seed_list), key=lambda seed: (seed.index, seed.name)
         )
@@ -44,6 +55,15 @@ class IntraSlicerInput(LLMToolInput):
         self.seed_type = self.seed_list[0].description()
         self.seed_line_number = self.seed_list[0].line_number_in_function
 
+        # Descriptions of the effects of the modeled APIs, one per API
+        self.api_descriptions = sorted(
+            {
+                description
+                for description in (api.description() for api in callee_apis or [])
+                if description is not None
+            }
+        )
+
     @staticmethod
     def check_validity_of_seed_list(seed_list: List[Value]) -> bool:
         """Check if seed list is valid.
@@ -79,9 +99,62 @@ class IntraSlicerInput(LLMToolInput):
 
         return is_return or is_same_loc_label or is_length_one
 
+    def content_key(self) -> Tuple:
+        """Generate a location-independent key of the input.
+
+        Seeds are described relative to the function and the function is identified
+        by its content hash, so the key is stable across revisions of a project
+        as long as the function itself is unchanged.
+
+        Returns:
+            Tuple of function content hash, relative seed descriptions, direction
+            and API effects stated in the prompt
+        """
+        relative_seeds = tuple(
+            (seed.name, str(seed.label), seed.line_number_in_function, seed.index)
+            for seed in self.seed_list
+        )
+        return (
+            self.function.content_hash(),
+            relative_seeds,
+            self.is_backward,
+            tuple(self.api_descriptions),
+            self.line_range,
+        )
+
     def __hash__(self) -> int:
-        """Generate hash based on seeds, function and direction."""
-        return hash((str(self.seed_list), self.function.function_id, self.is_backward))
+        """Generate hash based on seeds, function content and direction."""
+        return hash(self.content_key())
+
+    def get_lined_code(self) -> str:
+        """Get the numbered code to slice.
+
+        A chunk is shown after the header of the function (up to its opening
+        brace), so that the parameters can still be reported, and the elided
+        lines are marked. The lines keep their numbers in the function.
+
+        Returns:
+            The numbered lines of the function or the chunk
+        """
+        if self.line_range is None:
+            return self.function.lined_code
+        lines = self.function.lined_code.split("\n")
+        start_line, end_line = self.line_range
+        header_end_line = 1
+        while (
+            header_end_line < start_line - 1
+            and "{" not in lines[header_end_line - 1]
+        ):
+            header_end_line += 1
+        header_end_line = min(header_end_line, start_line - 1)
+
+        chunk_lines = lines[:header_end_line]
+        if header_end_line < start_line - 1:
+            chunk_lines.append("...")
+        chunk_lines.extend(lines[start_line - 1 : end_line])
+        if end_line < len(lines):
+            chunk_lines.append("...")
+        return "\n".join(chunk_lines)
 
 
 class IntraSlicerOutput(LLMToolOutput):
@@ -142,6 +215,8 @@ class IntraSlicer(LLMTool[IntraSlicerInput, IntraSlicerOutput]):
         language: str,
         max_query_num: int,
         logger: Logger,
+        llm_tenant: Optional[LLMTenant] = None,
+        prompt_dir: Optional[str] = None,
     ) -> None:
         """Initialize the intra-slicer.
 
@@ -151,14 +226,17 @@ class IntraSlicer(LLMTool[IntraSlicerInput, IntraSlicerOutput]):
             language: Programming language being analyzed
             max_query_num: Maximum number of LLM queries allowed
             logger: Logger instance for tracking
+            llm_tenant: Tenant of a shared LLMScheduler, or None
+            prompt_dir: Directory of the prompt templates (forward_slicer.json and
+                backward_slicer.json), or None for prompt/<language>/slicescan
         """
-        super().__init__(model_name, temperature, language, max_query_num, logger)
-        self.backward_prompt_file = (
-            f"{BASE_PATH}/prompt/{language}/slicescan/backward_slicer.json"
-        )
-        self.forward_prompt_file = (
-            f"{BASE_PATH}/prompt/{language}/slicescan/forward_slicer.json"
+        super().__init__(
+            model_name, temperature, language, max_query_num, logger, llm_tenant
         )
+        if prompt_dir is None:
+            prompt_dir = f"{BASE_PATH}/prompt/{language}/slicescan"
+        self.backward_prompt_file = f"{prompt_dir}/backward_slicer.json"
+        self.forward_prompt_file = f"{prompt_dir}/forward_slicer.json"
 
     def _get_prompt(self, input: IntraSlicerInput) -> str:
         """Generate prompt for LLM.
@@ -193,9 +271,17 @@ class IntraSlicer(LLMTool[IntraSlicerInput, IntraSlicerOutput]):
         question = prompt_template_dict["question_template"].replace(
             "<SEED_DESCRIPTION>", f"{input.seed_description}"
         )
+        # Custom templates without the hole are used as they are
+        if input.api_descriptions and "api_effects_template" in prompt_template_dict:
+            api_effects = "\n".join(
+                f"  - {description}" for description in input.api_descriptions
+            )
+            question += "\n" + prompt_template_dict["api_effects_template"].replace(
+                "<API_EFFECTS>", api_effects
+            )
         answer_format = "\n".join(prompt_template_dict["answer_format_cot"])
 
-        prompt = prompt.replace("<FUNCTION>", input.function.lined_code)
+        prompt = prompt.replace("<FUNCTION>", input.get_lined_code())
         prompt = prompt.replace("<QUESTION>", question)
         prompt = prompt.replace("<ANSWER>", answer_format)
 
@@ -228,7 +314,6 @@ class IntraSlicer(LLMTool[IntraSlicerInput, IntraSlicerOutput]):
         Raises:
             RATypeError: If input is not IntraSlicerInput
         """
-        print("Response: \n", response, "\n")
         if not isinstance(input, IntraSlicerInput):
             raise RATypeError(
                 f"Input type {type(input)} is not supported. Expected IntraSlicerInput."
@@ -8,7 +8,13 @@ from typing import Any, Dict, List, Optional, Set, Tuple
 from memory.IR.IR import IR
 from tree_sitter import Node
 from memory.utils.function import Function
-from memory.utils.api import API
+from memory.utils.api import API, APIModel
+from memory.IR.U6IR_store import (
+    DEFAULT_FUNCTION_CACHE_SIZE,
+    StoredEdgeMap,
+    StoredFunctionEnv,
+    U6IRStore,
+)
 
 
 class Parenthesis(Enum):
@@ -151,6 +157,115 @@ class U6IR(IR):
         self.api_callee_function_caller_map_lock = threading.Lock()
         self.api_env_lock = threading.Lock()
 
+        # On-disk store backing the functions and the call graph once the IR is
+        # offloaded (see offload), or None while they are held in memory
+        self.ir_store: Optional[U6IRStore] = None
+
+    def offload(
+        self, store_path: str, cache_size: int = DEFAULT_FUNCTION_CACHE_SIZE
+    ) -> None:
+        """
+        Move the functions and the call graph of the analyzed IR to an on-disk store.
+
+        The functions, their values and the call graph edges are written to an
+        SQLite database, and function_env and the call graph maps are replaced by
+        read-only mappings backed by it, keeping the cache_size most recently used
+        Function objects in memory. The tree-sitter nodes and the file contents
+        only used by the analysis are released. The accessors keep working, but the
+        call site nodes of the functions become StoredCallSite objects.
+
+        The store is written from the whole IR in memory, once the analysis is
+        done, so the offload lowers the memory held during slicing, but not the
+        peak memory of the analysis.
+
+        Args:
+            store_path: Path of the database file
+            cache_size: Maximum number of Function objects kept in memory
+        """
+        # The store is written under a temporary name and renamed, so that another
+        # run never opens a partial snapshot
+        tmp_store_path = f"{store_path}.{os.getpid()}.{threading.get_ident()}.tmp"
+        store = U6IRStore(tmp_store_path)
+        store.write(self)
+        os.replace(tmp_store_path, store_path)
+        store.db_path = store_path
+        self.attach_store(store, cache_size)
+        self.functionRawDataDic = {}
+        self.fileContentDic = {}
+
+    def load(
+        self, store_path: str, cache_size: int = DEFAULT_FUNCTION_CACHE_SIZE
+    ) -> None:
+        """
+        Load the functions and the call graph from a store written by offload,
+        instead of analyzing the source files again.
+
+        Args:
+            store_path: Path of the database file
+            cache_size: Maximum number of Function objects kept in memory
+        """
+        store = U6IRStore(store_path, is_new=False)
+        self.api_env = store.load_apis()
+        self.attach_store(store, cache_size)
+
+    def attach_api_models(self, api_models: Dict[str, APIModel]) -> None:
+        """
+        Attach the models of the library APIs to the APIs of the U6IR.
+
+        The models are not stored in the snapshots, so they are attached to the
+        analyzed and loaded U6IRs alike.
+
+        Args:
+            api_models: Dictionary mapping the API names to their models
+        """
+        for api in self.api_env.values():
+            api.model = api_models.get(api.api_name)
+
+    def attach_store(self, store: U6IRStore, cache_size: int) -> None:
+        """
+        Replace function_env and the call graph maps by mappings backed by a store.
+
+        Args:
+            store: Store holding the functions and the call graph
+            cache_size: Maximum number of Function objects kept in memory
+        """
+        self.ir_store = store
+        self.function_env = StoredFunctionEnv(store, cache_size)
+        self.function_caller_callee_map = StoredEdgeMap(store, "call_edges", True)
+        self.function_callee_caller_map = StoredEdgeMap(store, "call_edges", False)
+        self.function_caller_api_callee_map = StoredEdgeMap(store, "api_edges", True)
+        self.api_callee_function_caller_map = StoredEdgeMap(store, "api_edges", False)
+
+    # Helper functions for function lookup
+    def get_function_by_line(
+        self, file_path: str, line_number: int
+    ) -> Optional[Function]:
+        """
+        Get the function containing a line of a file.
+
+        Args:
+            file_path: Path of the file
+            line_number: Line number in the file
+
+        Returns:
+            The function with the lowest id containing the line, or None
+        """
+        if self.ir_store is not None:
+            function_id = self.ir_store.find_function_id_by_line(
+                file_path, line_number
+            )
+            return None if function_id is None else self.function_env[function_id]
+        for function_id in sorted(self.function_env):
+            function = self.function_env[function_id]
+            if (
+                function.file_path == file_path
+                and function.start_line_number
+                <= line_number
+                <= function.end_line_number
+            ):
+                return function
+        return None
+
     #################################################
     # Helper functions for caller/callee retrieval  #
     #################################################
@@ -212,6 +327,25 @@ class U6IR(IR):
                     api_callees.append(self.api_env[callee_api_id])
         return api_callees
 
+    def get_callee_apis_by_call_site(self, function: Function) -> Dict[int, API]:
+        """
+        Get the APIs called by the given function, keyed by call site id.
+
+        Args:
+            function: Function to analyze
+
+        Returns:
+            Dictionary mapping the call site ids to the called APIs
+        """
+        callee_apis: Dict[int, API] = {}
+        for call_site_id, callee_api_ids in self.function_caller_api_callee_map.get(
+            function.function_id, {}
+        ).items():
+            # A call site calls a single API, identified by name and arity
+            for callee_api_id in callee_api_ids:
+                callee_apis[call_site_id] = self.api_env[callee_api_id]
+        return callee_apis
+
     # Helper functions retrieving callees (user-defined functions) by call site
     def get_callee_functions_by_callsite(
         self, function: Function, call_site_node: Node
@@ -350,6 +484,98 @@ class U6IR(IR):
                 results.append(single_call_site_node)
         return results
 
+    # Helper functions for the strongly connected components of the call graph
+    def get_call_graph_sccs(self) -> List[List[int]]:
+        """
+        Compute the strongly connected components (SCCs) of the call graph.
+
+        The SCCs are computed with an iterative version of Tarjan's algorithm, so that
+        deep call chains do not hit the recursion limit. Tarjan's algorithm emits an
+        SCC after all the SCCs reachable from it, so the reversed emission order is a
+        topological order of the condensation of the call graph.
+
+        Returns:
+            List of SCCs (each a sorted list of function ids) in topological order,
+            i.e., the SCC of a caller precedes the SCCs of its callees
+        """
+
+        def get_callee_ids(function_id: int) -> List[int]:
+            callee_ids: Set[int] = set()
+            call_site_callee_ids = self.function_caller_callee_map.get(function_id, {})
+            for site_callee_ids in call_site_callee_ids.values():
+                callee_ids.update(site_callee_ids)
+            return sorted(callee_ids)
+
+        indices: Dict[int, int] = {}
+        lowlinks: Dict[int, int] = {}
+        scc_stack: List[int] = []
+        on_scc_stack: Set[int] = set()
+        sccs: List[List[int]] = []
+
+        for root_id in sorted(self.function_env):
+            if root_id in indices:
+                continue
+            indices[root_id] = lowlinks[root_id] = len(indices)
+            scc_stack.append(root_id)
+            on_scc_stack.add(root_id)
+            dfs_stack = [(root_id, iter(get_callee_ids(root_id)))]
+
+            while dfs_stack:
+                function_id, callee_id_iter = dfs_stack[-1]
+                is_descended = False
+                for callee_id in callee_id_iter:
+                    if callee_id not in indices:
+                        indices[callee_id] = lowlinks[callee_id] = len(indices)
+                        scc_stack.append(callee_id)
+                        on_scc_stack.add(callee_id)
+                        dfs_stack.append((callee_id, iter(get_callee_ids(callee_id))))
+                        is_descended = True
+                        break
+                    if callee_id in on_scc_stack:
+                        lowlinks[function_id] = min(
+                            lowlinks[function_id], indices[callee_id]
+                        )
+                if is_descended:
+                    continue
+
+                dfs_stack.pop()
+                if dfs_stack:
+                    caller_id = dfs_stack[-1][0]
+                    lowlinks[caller_id] = min(
+                        lowlinks[caller_id], lowlinks[function_id]
+                    )
+
+                if lowlinks[function_id] == indices[function_id]:
+                    scc: List[int] = []
+                    while True:
+                        member_id = scc_stack.pop()
+                        on_scc_stack.discard(member_id)
+                        scc.append(member_id)
+                        if member_id == function_id:
+                            break
+                    sccs.append(sorted(scc))
+
+        sccs.reverse()
+        return sccs
+
+    def is_recursive_scc(self, scc: List[int]) -> bool:
+        """
+        Check whether an SCC of the call graph contains recursion.
+
+        Args:
+            scc: Function ids of the SCC
+
+        Returns:
+            True if the SCC has several functions or a function calling itself
+        """
+        if len(scc) > 1:
+            return True
+        function_id = scc[0]
+        for callee_ids in self.function_caller_callee_map.get(function_id, {}).values():
+            if function_id in callee_ids:
+                return True
+        return False
+
     ##############################################
     # Helper functions for control flow analysis #
     ##############################################
@@ -0,0 +1,622 @@
+"""On-disk store of the functions, values and call graph of a U6IR.
+
+Once the analysis of a project is done, its U6IR can be offloaded to an embedded
+SQLite database (see U6IR.offload), so that the IR of a large project does not have
+to fit in memory during slicing. The analysis itself still builds the whole IR in
+memory before it is offloaded, so the peak memory of a run analyzing a project is
+not lowered; only the runs reusing the snapshot never hold the whole IR. The tables
+are indexed by the keys of the accessor APIs of U6IR: functions by id, name and
+file, values and call sites by function, and the call edges by caller and by
+callee.
+
+The dict attributes of the U6IR are then replaced by read-only mappings backed by
+the store, so that the existing accessors keep working:
+- StoredFunctionEnv rebuilds the Function objects from the store and keeps the hot
+  ones in an LRU cache.
+- StoredEdgeMap answers the lookups of the call graph maps with indexed queries.
+
+The tree-sitter nodes are not stored. The call sites of the rebuilt functions are
+identified by StoredCallSite objects, which compare equal across reloads, in place
+of their nodes.
+
+A store is also a snapshot of the analyzed IR: named by get_snapshot_key, it is
+reused by the later runs (e.g., the distributed workers) on the same sources at
+the same paths instead of analyzing them again (see U6IR.load). The functions
+are stored with their absolute file paths, so a checkout of the same sources at
+another path gets a snapshot of its own.
+"""
+
+import hashlib
+import json
+import sqlite3
+import threading
+from collections import OrderedDict
+from collections.abc import Mapping
+from typing import TYPE_CHECKING, Dict, Iterator, List, Optional, Set, Tuple
+
+from memory.utils.api import API
+from memory.utils.function import Function
+from memory.utils.identifier_index import IdentifierIndex
+from memory.utils.value import Value, ValueLabel
+from utility.errors import RAValueError
+
+if TYPE_CHECKING:
+    from memory.IR.U6IR import U6IR
+
+# Default number of Function objects kept in memory by StoredFunctionEnv
+DEFAULT_FUNCTION_CACHE_SIZE = 1024
+
+# Number of rows inserted per executemany call when writing the store
+WRITE_BATCH_SIZE = 10000
+
+# Version of the schema, changing the keys of the snapshots written before
+STORE_VERSION = 2
+
+SCHEMA = """
+CREATE TABLE functions (
+    function_id INTEGER PRIMARY KEY,
+    function_name TEXT NOT NULL,
+    function_code TEXT NOT NULL,
+    file_path TEXT NOT NULL,
+    start_line_number INTEGER NOT NULL,
+    end_line_number INTEGER NOT NULL,
+    if_statements TEXT NOT NULL,
+    loop_statements TEXT NOT NULL,
+    identifier_index TEXT NOT NULL
+);
+CREATE INDEX functions_by_name ON functions (function_name);
+CREATE INDEX functions_by_file ON functions (file_path, start_line_number);
+
+CREATE TABLE call_sites (
+    function_id INTEGER NOT NULL,
+    call_site_id INTEGER NOT NULL,
+    callee_name TEXT NOT NULL,
+    start_line INTEGER NOT NULL,
+    end_line INTEGER NOT NULL,
+    is_api INTEGER NOT NULL,
+    PRIMARY KEY (function_id, call_site_id)
+);
+
+CREATE TABLE function_values (
+    function_id INTEGER NOT NULL,
+    kind TEXT NOT NULL,
+    call_site_id INTEGER NOT NULL,
+    name TEXT NOT NULL,
+    label TEXT NOT NULL,
+    file_path TEXT NOT NULL,
+    line_number_in_file INTEGER NOT NULL,
+    line_number_in_function INTEGER NOT NULL,
+    value_index INTEGER NOT NULL,
+    comment TEXT
+);
+CREATE INDEX function_values_by_function ON function_values (function_id);
+
+CREATE TABLE call_edges (
+    caller_id INTEGER NOT NULL,
+    call_site_id INTEGER NOT NULL,
+    callee_id INTEGER NOT NULL
+);
+CREATE INDEX call_edges_by_caller ON call_edges (caller_id, call_site_id);
+CREATE INDEX call_edges_by_callee ON call_edges (callee_id);
+
+CREATE TABLE api_edges (
+    caller_id INTEGER NOT NULL,
+    call_site_id INTEGER NOT NULL,
+    callee_id INTEGER NOT NULL
+);
+CREATE INDEX api_edges_by_caller ON api_edges (caller_id, call_site_id);
+CREATE INDEX api_edges_by_callee ON api_edges (callee_id);
+
+CREATE TABLE apis (
+    api_id INTEGER PRIMARY KEY,
+    api_name TEXT NOT NULL,
+    api_para_num INTEGER NOT NULL
+);
+"""
+
+TABLES = [
+    "functions",
+    "call_sites",
+    "function_values",
+    "call_edges",
+    "api_edges",
+    "apis",
+]
+
+# Kinds of the rows of function_values
+PARA_KIND = "para"
+RETVAL_KIND = "retval"
+ARG_KIND = "arg"
+OUTVAL_KIND = "outval"
+
+
+def get_snapshot_key(
+    code_in_files: Dict[str, str],
+    language: str,
+    file_scopes: Optional[Dict[str, Set[str]]] = None,
+) -> str:
+    """Get the key of the IR snapshot of a set of source files.
+
+    Args:
+        code_in_files: Dictionary mapping file paths to their source code content
+        language: Programming language of the files
+        file_scopes: Scopes of the files resolving the calls, if any
+
+    Returns:
+        Hex digest identifying the files, their contents, their scopes and the
+        store version. The files are identified by their absolute paths, which
+        the stored functions refer to, so the key differs between checkouts of
+        the same sources at different paths.
+    """
+    digest = hashlib.sha256(f"{STORE_VERSION}\n{language}\n".encode("utf-8"))
+    for file_path in sorted(code_in_files):
+        digest.update(file_path.encode("utf-8") + b"\0")
+        digest.update(hashlib.sha256(code_in_files[file_path].encode("utf-8")).digest())
+    # The scopes change the call edges, but not the keys of the unscoped IRs
+    if file_scopes is not None:
+        for file_path in sorted(file_scopes):
+            digest.update(
+                "\0".join([file_path] + sorted(file_scopes[file_path])).encode("utf-8")
+                + b"\n"
+            )
+    return digest.hexdigest()
+
+
+class StoredCallSite:
+    """Call site of a function rebuilt from the store, in place of its node."""
+
+    __slots__ = ("function_id", "call_site_id")
+
+    def __init__(self, function_id: int, call_site_id: int) -> None:
+        self.function_id = function_id
+        self.call_site_id = call_site_id
+
+    def __eq__(self, other: object) -> bool:
+        if not isinstance(other, StoredCallSite):
+            return NotImplemented
+        return (self.function_id, self.call_site_id) == (
+            other.function_id,
+            other.call_site_id,
+        )
+
+    def __hash__(self) -> int:
+        return hash((self.function_id, self.call_site_id))
+
+    def __repr__(self) -> str:
+        return f"StoredCallSite({self.function_id}, {self.call_site_id})"
+
+
+class U6IRStore:
+    """SQLite database holding the functions, values and call graph of a U6IR.
+
+    One connection is shared by the threads of the agents and serialized by a lock,
+    as the store is only read after it is written.
+    """
+
+    def __init__(self, db_path: str, is_new: bool = True) -> None:
+        """Open the store.
+
+        Args:
+            db_path: Path of the database file, or ":memory:"
+            is_new: Whether to replace any database at the path with an empty
+                store, rather than open an existing store
+        """
+        self.db_path = db_path
+        self._lock = threading.Lock()
+        self._connection = sqlite3.connect(db_path, check_same_thread=False)
+        if not is_new:
+            return
+        with self._connection:
+            for table in TABLES:
+                self._connection.execute(f"DROP TABLE IF EXISTS {table}")
+            self._connection.executescript(SCHEMA)
+
+    def query(self, sql: str, parameters: Tuple = ()) -> List[Tuple]:
+        """Run a query on the store.
+
+        Args:
+            sql: SQL statement
+            parameters: Parameters of the statement
+
+        Returns:
+            The rows of the result
+        """
+        with self._lock:
+            return self._connection.execute(sql, parameters).fetchall()
+
+    def write(self, u6ir: "U6IR") -> None:
+        """Write the functions and the call graph of an in-memory U6IR.
+
+        Args:
+            u6ir: IR whose attributes are still the in-memory dicts
+        """
+        function_rows: List[Tuple] = []
+        call_site_rows: List[Tuple] = []
+        value_rows: List[Tuple] = []
+
+        def add_value(function_id: int, kind: str, call_site_id: int, value: Value):
+            value_rows.append(
+                (
+                    function_id,
+                    kind,
+                    call_site_id,
+                    value.name,
+                    str(value.label),
+                    value.file_path,
+                    value.line_number_in_file,
+                    value.line_number_in_function,
+                    value.index,
+                    value.comment,
+                )
+            )
+
+        with self._lock, self._connection:
+            for function_id, function in u6ir.function_env.items():
+                function_rows.append(
+                    (
+                        function_id,
+                        function.function_name,
+                        function.function_code,
+                        function.file_path,
+                        function.start_line_number,
+                        function.end_line_number,
+                        json.dumps(list(function.if_statements.items())),
+                        json.dumps(list(function.loop_statements.items())),
+                        json.dumps(function.identifier_index.to_dict()),
+                    )
+                )
+                for call_site_id, (_, callee_name, start_line, end_line) in (
+                    function.all_call_site_nodes.items()
+                ):
+                    is_api = call_site_id in function.api_call_site_nodes
+                    call_site_rows.append(
+                        (
+                            function_id,
+                            call_site_id,
+                            callee_name,
+                            start_line,
+                            end_line,
+                            int(is_api),
+                        )
+                    )
+                for para in function._paras:
+                    add_value(function_id, PARA_KIND, -1, para)
+                for retval in function._retvals:
+                    add_value(function_id, RETVAL_KIND, -1, retval)
+                for call_site_id, args in function._args.items():
+                    for arg in args:
+                        add_value(function_id, ARG_KIND, call_site_id, arg)
+                for call_site_id, outval in function._outvals.items():
+                    add_value(function_id, OUTVAL_KIND, call_site_id, outval)
+
+                if len(value_rows) >= WRITE_BATCH_SIZE:
+                    self._insert_rows(function_rows, call_site_rows, value_rows)
+
+            self._insert_rows(function_rows, call_site_rows, value_rows)
+            for table, edge_map in (
+                ("call_edges", u6ir.function_caller_callee_map),
+                ("api_edges", u6ir.function_caller_api_callee_map),
+            ):
+                self._connection.executemany(
+                    f"INSERT INTO {table} VALUES (?, ?, ?)",
+                    (
+                        (caller_id, call_site_id, callee_id)
+                        for caller_id, call_site_callee_ids in edge_map.items()
+                        for call_site_id, callee_ids in call_site_callee_ids.items()
+                        for callee_id in callee_ids
+                    ),
+                )
+            self._connection.executemany(
+                "INSERT INTO apis VALUES (?, ?, ?)",
+                (
+                    (api_id, api.api_name, api.api_para_num)
+                    for api_id, api in u6ir.api_env.items()
+                ),
+            )
+            self._connection.execute("ANALYZE")
+
+    def _insert_rows(
+        self,
+        function_rows: List[Tuple],
+        call_site_rows: List[Tuple],
+        value_rows: List[Tuple],
+    ) -> None:
+        """Insert and clear the pending rows of the functions."""
+        self._connection.executemany(
+            "INSERT INTO functions VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)", function_rows
+        )
+        self._connection.executemany(
+            "INSERT INTO call_sites VALUES (?, ?, ?, ?, ?, ?)", call_site_rows
+        )
+        self._connection.executemany(
+            "INSERT INTO function_values VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+            value_rows,
+        )
+        function_rows.clear()
+        call_site_rows.clear()
+        value_rows.clear()
+
+    def load_function(self, function_id: int) -> Optional[Function]:
+        """Rebuild a function from the store.
+
+        Args:
+            function_id: Id of the function
+
+        Returns:
+            The function, without its tree-sitter nodes, or None if it is not stored
+        """
+        rows = self.query(
+            "SELECT function_name, function_code, file_path, start_line_number, "
+            "end_line_number, if_statements, loop_statements, identifier_index "
+            "FROM functions WHERE function_id = ?",
+            (function_id,),
+        )
+        if not rows:
+            return None
+        (
+            function_name,
+            function_code,
+            file_path,
+            start_line_number,
+            end_line_number,
+            if_statements,
+            loop_statements,
+            identifier_index,
+        ) = rows[0]
+        function = Function(
+            function_id,
+            function_name,
+            function_code,
+            start_line_number,
+            end_line_number,
+            None,
+            file_path,
+        )
+        # JSON turns the tuples of the statements into lists
+        for (start_line, end_line), (
+            header_start,
+            header_end,
+            condition,
+            true_branch,
+            else_branch,
+        ) in json.loads(if_statements):
+            function.if_statements[(start_line, end_line)] = (
+                header_start,
+                header_end,
+                condition,
+                tuple(true_branch),
+                tuple(else_branch),
+            )
+        for (start_line, end_line), loop_statement in json.loads(loop_statements):
+            function.loop_statements[(start_line, end_line)] = tuple(loop_statement)
+        function.identifier_index = IdentifierIndex.from_dict(
+            json.loads(identifier_index)
+        )
+
+        for call_site_id, callee_name, start_line, end_line, is_api in self.query(
+            "SELECT call_site_id, callee_name, start_line, end_line, is_api "
+            "FROM call_sites WHERE function_id = ? ORDER BY call_site_id",
+            (function_id,),
+        ):
+            call_site = (
+                StoredCallSite(function_id, call_site_id),
+                callee_name,
+                start_line,
+                end_line,
+            )
+            function.all_call_site_nodes[call_site_id] = call_site
+            if is_api:
+                function.api_call_site_nodes[call_site_id] = call_site
+            else:
+                function.function_call_site_nodes[call_site_id] = call_site
+
+        for (
+            kind,
+            call_site_id,
+            name,
+            label,
+            value_file_path,
+            line_number_in_file,
+            line_number_in_function,
+            index,
+            comment,
+        ) in self.query(
+            "SELECT kind, call_site_id, name, label, file_path, line_number_in_file, "
+            "line_number_in_function, value_index, comment "
+            "FROM function_values WHERE function_id = ?",
+            (function_id,),
+        ):
+            value = Value(
+                name,
+                ValueLabel.from_str(label),
+                value_file_path,
+                line_number_in_file,
+                function_id,
+                function_name,
+                line_number_in_function,
+                index,
+                comment,
+            )
+            if kind == PARA_KIND:
+                function.add_para(value)
+            elif kind == RETVAL_KIND:
+                function.add_retval(value)
+            elif kind == ARG_KIND:
+                function.add_arg(call_site_id, value)
+            elif kind == OUTVAL_KIND:
+                function.add_outval(call_site_id, value)
+            else:
+                raise RAValueError(f"Invalid value kind in the IR store: {kind}")
+        return function
+
+    def load_apis(self) -> Dict[int, API]:
+        """Load the APIs called by the functions of the store.
+
+        Returns:
+            Dictionary mapping the API ids to the APIs
+        """
+        return {
+            api_id: API(api_id, api_name, api_para_num)
+            for api_id, api_name, api_para_num in self.query(
+                "SELECT api_id, api_name, api_para_num FROM apis"
+            )
+        }
+
+    def find_function_id_by_line(
+        self, file_path: str, line_number: int
+    ) -> Optional[int]:
+        """Find the function containing a line of a file.
+
+        Args:
+            file_path: Path of the file
+            line_number: Line number in the file
+
+        Returns:
+            Id of the function with the lowest id containing the line, or None
+        """
+        rows = self.query(
+            "SELECT function_id FROM functions WHERE file_path = ? "
+            "AND start_line_number <= ? AND end_line_number >= ? "
+            "ORDER BY function_id LIMIT 1",
+            (file_path, line_number, line_number),
+        )
+        return rows[0][0] if rows else None
+
+    def close(self) -> None:
+        """Close the connection of the store."""
+        with self._lock:
+            self._connection.close()
+
+
+class StoredFunctionEnv(Mapping):
+    """Read-only function_env backed by a U6IRStore, with an LRU of hot functions."""
+
+    def __init__(
+        self, store: U6IRStore, cache_size: int = DEFAULT_FUNCTION_CACHE_SIZE
+    ) -> None:
+        """Initialize the function env.
+
+        Args:
+            store: Store holding the functions
+            cache_size: Maximum number of Function objects kept in memory
+        """
+        if cache_size < 1:
+            raise RAValueError(
+                f"The function cache size must be positive: {cache_size}"
+            )
+        self.store = store
+        self.cache_size = cache_size
+        self.hit_num = 0
+        self.miss_num = 0
+        self._cache: "OrderedDict[int, Function]" = OrderedDict()
+        self._lock = threading.Lock()
+        self._function_num = store.query("SELECT COUNT(*) FROM functions")[0][0]
+
+    def __getitem__(self, function_id: int) -> Function:
+        with self._lock:
+            function = self._cache.get(function_id)
+            if function is not None:
+                self._cache.move_to_end(function_id)
+                self.hit_num += 1
+                return function
+        function = self.store.load_function(function_id)
+        if function is None:
+            raise KeyError(function_id)
+        with self._lock:
+            self.miss_num += 1
+            # Another thread may have loaded the function meanwhile
+            function = self._cache.setdefault(function_id, function)
+            self._cache.move_to_end(function_id)
+            while len(self._cache) > self.cache_size:
+                self._cache.popitem(last=False)
+        return function
+
+    def __contains__(self, function_id: object) -> bool:
+        with self._lock:
+            if function_id in self._cache:
+                return True
+        return bool(
+            self.store.query(
+                "SELECT 1 FROM functions WHERE function_id = ?", (function_id,)
+            )
+        )
+
+    def __iter__(self) -> Iterator[int]:
+        for (function_id,) in self.store.query(
+            "SELECT function_id FROM functions ORDER BY function_id"
+        ):
+            yield function_id
+
+    def __len__(self) -> int:
+        return self._function_num
+
+    def cached_values(self) -> List[Function]:
+        """Get the functions currently held in memory."""
+        with self._lock:
+            return list(self._cache.values())
+
+
+class StoredEdgeMap(Mapping):
+    """Read-only call graph map of a U6IR backed by an edge table of a U6IRStore.
+
+    A forward map (keyed by caller) maps a caller id to {call_site_id -> {callee
+    ids}}, and a reverse map (keyed by callee) maps a callee id to {(call_site_id,
+    caller_id)}, as the in-memory maps of U6IR do.
+    """
+
+    def __init__(self, store: U6IRStore, table: str, is_forward: bool) -> None:
+        """Initialize the edge map.
+
+        Args:
+            store: Store holding the edges
+            table: Edge table, "call_edges" or "api_edges"
+            is_forward: Whether the map is keyed by caller rather than by callee
+        """
+        if table not in ("call_edges", "api_edges"):
+            raise RAValueError(f"Invalid edge table: {table}")
+        self.store = store
+        self.table = table
+        self.is_forward = is_forward
+        self.key_column = "caller_id" if is_forward else "callee_id"
+
+    def __getitem__(self, key: int):
+        if self.is_forward:
+            rows = self.store.query(
+                f"SELECT call_site_id, callee_id FROM {self.table} "
+                "WHERE caller_id = ?",
+                (key,),
+            )
+            if not rows:
+                raise KeyError(key)
+            call_site_callee_ids: Dict[int, Set[int]] = {}
+            for call_site_id, callee_id in rows:
+                call_site_callee_ids.setdefault(call_site_id, set()).add(callee_id)
+            return call_site_callee_ids
+
+        rows = self.store.query(
+            f"SELECT call_site_id, caller_id FROM {self.table} WHERE callee_id = ?",
+            (key,),
+        )
+        if not rows:
+            raise KeyError(key)
+        return {(call_site_id, caller_id) for call_site_id, caller_id in rows}
+
+    def __contains__(self, key: object) -> bool:
+        return bool(
+            self.store.query(
+                f"SELECT 1 FROM {self.table} WHERE {self.key_column} = ? LIMIT 1",
+                (key,),
+            )
+        )
+
+    def __iter__(self) -> Iterator[int]:
+        for (key,) in self.store.query(
+            f"SELECT DISTINCT {self.key_column} FROM {self.table} "
+            f"ORDER BY {self.key_column}"
+        ):
+            yield key
+
+    def __len__(self) -> int:
+        return self.store.query(
+            f"SELECT COUNT(DISTINCT {self.key_column}) FROM {self.table}"
+        )[0][0]
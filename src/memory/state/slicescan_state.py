@@ -1,4 +1,4 @@
-from typing import Dict, List, Tuple, Optional
+from typing import Dict, Iterable, List, Optional, Set, Tuple
 import threading
 
 from memory.state.state import State
@@ -15,13 +15,21 @@ class SliceScanState(State):
 
     def __init__(self) -> None:
         self._slicing_request_id: str = ""
-        self._seed_function: Optional[Function] = None
-        self._seed_value: Optional[Value] = None
+        self._seed_functions: List[Function] = []
+        self._seed_values: List[Value] = []
         self._call_depth: int = 1
         self._is_backward: bool = True
 
         # Slicing results
-        self._relevant_function_names_to_line_numbers: Dict[str, List[int]] = {}
+        # Maps function_id -> bitset of relevant line numbers (bit i <=> line i)
+        self._relevant_function_ids_to_line_bitsets: Dict[int, int] = {}
+        # Maps function_id -> function_name, used to render the results in to_dict
+        self._relevant_function_ids_to_names: Dict[int, str] = {}
+        # Maps seed index -> function_id -> bitset of the lines attributed to the seed
+        self._seed_attributed_line_bitsets: Dict[int, Dict[int, int]] = {}
+        # Maps SCC rank -> names of the functions and number of the work items
+        # dropped from the SCC once its rounds ran out, which makes the slice partial
+        self._truncated_sccs: Dict[int, Tuple[Set[str], int]] = {}
 
         # TODO: Add your implementation here.
         # You can define any other attributes as you need.
@@ -30,8 +38,8 @@ class SliceScanState(State):
     def initialize_slicescan_state(
         self,
         slicing_request_id: str,
-        seed_function: Function,
-        seed_value: Value,
+        seed_functions: List[Function],
+        seed_values: List[Value],
         call_depth: int = 1,
         is_backward: bool = True,
     ) -> None:
@@ -39,37 +47,148 @@ class SliceScanState(State):
 
         Args:
             slicing_request_id: The ID of the slicing request
-            seed_function: Function containing the slicing seeds
-            seed_value: Seed value to start slicing from
+            seed_functions: Functions containing the slicing seeds (one per seed)
+            seed_values: Seed values to start slicing from
             call_depth: Maximum call depth for interprocedural slicing
             is_backward: Whether to perform backward slicing
         """
         self._slicing_request_id = slicing_request_id
-        self._seed_function = seed_function
-        self._seed_value = seed_value
+        self._seed_functions = seed_functions
+        self._seed_values = seed_values
         self._call_depth = call_depth
         self._is_backward = is_backward
 
     def update_relevant_function_names_to_line_numbers(
-        self, function_name: str, line_numbers: List[int]
+        self, function: Function, line_numbers: List[int], seed_mask: int = 1
     ) -> None:
-        """Update the relevant function names to line numbers.
+        """Update the relevant line numbers of a function.
+
+        The line numbers are stored as a bitset keyed by the function id, so that
+        repeated updates of the same function only cost a word-wise union.
 
         Args:
-            function_name: The name of the function
+            function: The function containing the line numbers
             line_numbers: The line numbers of the function
+            seed_mask: Bitmask of the indices of the seeds the lines are attributed to
         """
-        dedup_sorted = sorted(set(line_numbers))
-        if function_name not in self._relevant_function_names_to_line_numbers:
-            self._relevant_function_names_to_line_numbers[function_name] = dedup_sorted
+        line_bitset = 0
+        for line_number in line_numbers:
+            if line_number > 0:
+                line_bitset |= 1 << line_number
+
+        function_id = function.function_id
+        if function_id not in self._relevant_function_ids_to_line_bitsets:
+            self._relevant_function_ids_to_line_bitsets[function_id] = line_bitset
+            self._relevant_function_ids_to_names[function_id] = function.function_name
         else:
-            combined = (
-                self._relevant_function_names_to_line_numbers[function_name]
-                + line_numbers
+            self._relevant_function_ids_to_line_bitsets[function_id] |= line_bitset
+
+        for seed_index in range(seed_mask.bit_length()):
+            if not (seed_mask >> seed_index) & 1:
+                continue
+            seed_line_bitsets = self._seed_attributed_line_bitsets.setdefault(
+                seed_index, {}
             )
-            self._relevant_function_names_to_line_numbers[function_name] = sorted(
-                set(combined)
+            seed_line_bitsets[function_id] = (
+                seed_line_bitsets.get(function_id, 0) | line_bitset
+            )
+
+    def add_truncated_scc_items(
+        self, scc_rank: int, function_names: Iterable[str], dropped_item_num: int
+    ) -> None:
+        """Record the work items dropped from a recursive SCC of the call graph.
+
+        Args:
+            scc_rank: Rank of the SCC in the topological order of the call graph
+            function_names: Names of the functions of the dropped items
+            dropped_item_num: Number of the dropped items
+        """
+        names, item_num = self._truncated_sccs.get(scc_rank, (set(), 0))
+        names.update(function_names)
+        self._truncated_sccs[scc_rank] = (names, item_num + dropped_item_num)
+
+    def is_truncated(self) -> bool:
+        """Check whether work items were dropped, i.e., the slice is partial."""
+        return len(self._truncated_sccs) > 0
+
+    @staticmethod
+    def bitset_to_line_numbers(line_bitset: int) -> List[int]:
+        """Convert a line bitset into a sorted list of line numbers.
+
+        Args:
+            line_bitset: The bitset to convert
+
+        Returns:
+            Sorted list of the line numbers whose bits are set
+        """
+        bits = bin(line_bitset)[:1:-1]
+        return [line_number for line_number, bit in enumerate(bits) if bit == "1"]
+
+    def get_relevant_function_names_to_line_numbers(
+        self, seed_index: Optional[int] = None
+    ) -> Dict[str, List[int]]:
+        """Get the relevant line numbers grouped by function name.
+
+        Functions sharing the same name (e.g., static functions in different files)
+        are merged, which is the format expected by the judger.
+
+        Args:
+            seed_index: Index of the seed whose slice is returned, or None for the
+                union of the slices of all the seeds
+
+        Returns:
+            Dictionary mapping function names to sorted line numbers
+        """
+        function_names_to_line_bitsets: Dict[str, int] = {}
+        if seed_index is None:
+            line_bitsets = self._relevant_function_ids_to_line_bitsets
+        else:
+            line_bitsets = self._seed_attributed_line_bitsets.get(seed_index, {})
+        for function_id, line_bitset in line_bitsets.items():
+            function_name = self._relevant_function_ids_to_names[function_id]
+            function_names_to_line_bitsets[function_name] = (
+                function_names_to_line_bitsets.get(function_name, 0) | line_bitset
             )
+        return {
+            function_name: SliceScanState.bitset_to_line_numbers(line_bitset)
+            for function_name, line_bitset in function_names_to_line_bitsets.items()
+        }
+
+    @staticmethod
+    def diff(base_state: "SliceScanState", head_state: "SliceScanState") -> Dict:
+        """Compute the per-function difference between two slicing results.
+
+        Line numbers are relative to the function start, so a function whose
+        slice only moved within the file does not show up in the difference.
+
+        Args:
+            base_state: The slicing state of the base revision
+            head_state: The slicing state of the head revision
+
+        Returns:
+            Dictionary mapping each function name whose slice changed to its base,
+            head, added and removed line numbers
+        """
+        base_lines = base_state.get_relevant_function_names_to_line_numbers()
+        head_lines = head_state.get_relevant_function_names_to_line_numbers()
+
+        function_diffs = {}
+        for function_name in sorted(set(base_lines) | set(head_lines)):
+            base_line_numbers = base_lines.get(function_name, [])
+            head_line_numbers = head_lines.get(function_name, [])
+            if base_line_numbers == head_line_numbers:
+                continue
+            function_diffs[function_name] = {
+                "base_line_numbers": base_line_numbers,
+                "head_line_numbers": head_line_numbers,
+                "added_line_numbers": sorted(
+                    set(head_line_numbers) - set(base_line_numbers)
+                ),
+                "removed_line_numbers": sorted(
+                    set(base_line_numbers) - set(head_line_numbers)
+                ),
+            }
+        return function_diffs
 
     def to_dict(self) -> dict:
         """Convert state to dictionary representation.
@@ -77,10 +196,34 @@ class SliceScanState(State):
         Returns:
             Dictionary containing slicing configuration and results
         """
+        relevant_function_names_to_line_numbers = (
+            self.get_relevant_function_names_to_line_numbers()
+        )
+        seed_attributions = [
+            {
+                "seed": seed_value.to_dict(),
+                "relevant_function_names_to_line_numbers": (
+                    self.get_relevant_function_names_to_line_numbers(seed_index)
+                ),
+            }
+            for seed_index, seed_value in enumerate(self._seed_values)
+        ]
         return {
             # TODO: Add your implementation here.
             # You can add any other information you need to record.
             # But we only check the key "relevant_function_names_to_line_numbers" to judge your implementation.
             "slicing_request_id": self._slicing_request_id,
-            "relevant_function_names_to_line_numbers": self._relevant_function_names_to_line_numbers,
+            "relevant_function_names_to_line_numbers": relevant_function_names_to_line_numbers,
+            "seed_attributions": seed_attributions,
+            "is_truncated": self.is_truncated(),
+            "truncated_sccs": [
+                {
+                    "scc_rank": scc_rank,
+                    "function_names": sorted(names),
+                    "dropped_item_num": item_num,
+                }
+                for scc_rank, (names, item_num) in sorted(
+                    self._truncated_sccs.items()
+                )
+            ],
         }
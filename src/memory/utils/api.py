@@ -1,5 +1,182 @@
+import json
+from typing import Dict, List, Optional, Union
+
 import tree_sitter
 
+from utility.errors import RAValueError
+
+# Argument indices in an API model: an index, or "i+" for the arguments from index
+# i on (e.g., the variadic arguments of printf)
+ArgumentSpec = Union[int, str]
+
+# Kinds of the I/O of an API model
+IO_INPUT = "input"
+IO_OUTPUT = "output"
+
+API_MODEL_KEYS = ["reads", "writes", "returns", "io", "noreturn"]
+
+
+class APIModel:
+    """Side effects and dataflow of a library API."""
+
+    def __init__(
+        self,
+        reads: List[ArgumentSpec],
+        writes: List[ArgumentSpec],
+        returns: List[ArgumentSpec],
+        io: Optional[str] = None,
+        is_noreturn: bool = False,
+    ) -> None:
+        """Initialize an API model.
+
+        Args:
+            reads: Arguments whose values (or pointees) the API reads
+            writes: Arguments whose pointees the API writes
+            returns: Arguments the return value depends on
+            io: IO_INPUT if the API reads from the environment (e.g., files and
+                consoles), in which case its return value and written arguments
+                also depend on it, IO_OUTPUT if it only writes to the
+                environment, or None
+            is_noreturn: Whether the API does not return (e.g., exit)
+        """
+        self.reads = reads
+        self.writes = writes
+        self.returns = returns
+        self.io = io
+        self.is_noreturn = is_noreturn
+
+    @staticmethod
+    def get_indices(specs: List[ArgumentSpec], para_num: int) -> List[int]:
+        """Get the argument indices of a call with para_num arguments."""
+        indices = set()
+        for spec in specs:
+            if isinstance(spec, int):
+                indices.add(spec)
+            else:
+                indices.update(range(int(spec.rstrip("+")), para_num))
+        return sorted(index for index in indices if index < para_num)
+
+    def is_effect_free(self) -> bool:
+        """Check whether a call whose return value is discarded affects no value.
+
+        Output to the environment (e.g., printf) affects no value of the program,
+        unlike the input consumed from it (e.g., getchar) or a call not returning.
+        """
+        return not self.writes and self.io != IO_INPUT and not self.is_noreturn
+
+    def description(self, api_name: str, para_num: int) -> str:
+        """Describe the effects of a call of the API in a prompt.
+
+        Args:
+            api_name: Name of the API
+            para_num: Number of arguments of the call
+
+        Returns:
+            One-line description of the effects
+        """
+        effects: List[str] = []
+        for verb, specs in (("reads", self.reads), ("writes", self.writes)):
+            indices = APIModel.get_indices(specs, para_num)
+            if indices:
+                effects.append(f"{verb} the arguments at indices {indices}")
+        if para_num > 0 and not APIModel.get_indices(self.writes, para_num):
+            effects.append("does not modify its arguments")
+        return_indices = APIModel.get_indices(self.returns, para_num)
+        if return_indices:
+            effects.append(
+                f"returns a value depending on the arguments at indices "
+                f"{return_indices}"
+            )
+        if self.io == IO_INPUT:
+            effects.append("reads input from the environment")
+        elif self.io == IO_OUTPUT:
+            effects.append("writes output to the environment")
+        if self.is_noreturn:
+            effects.append("does not return")
+        return f"{api_name}: " + "; ".join(effects) + "."
+
+    @staticmethod
+    def from_dict(model_dict: Dict) -> "APIModel":
+        """Create an API model from an entry of a model table.
+
+        Args:
+            model_dict: Entry with the optional keys "reads", "writes", "returns"
+                (lists of argument specs), "io" ("input" or "output") and
+                "noreturn" (boolean)
+
+        Returns:
+            The API model
+
+        Raises:
+            RAValueError: If the entry is invalid
+        """
+        unknown_keys = set(model_dict) - set(API_MODEL_KEYS)
+        if unknown_keys:
+            raise RAValueError(
+                f"Unknown keys in the API model: {sorted(unknown_keys)}"
+            )
+        io = model_dict.get("io")
+        if io not in (None, IO_INPUT, IO_OUTPUT):
+            raise RAValueError(f"Invalid I/O kind in the API model: {io}")
+        specs: Dict[str, List[ArgumentSpec]] = {}
+        for key in ("reads", "writes", "returns"):
+            specs[key] = list(model_dict.get(key, []))
+            for spec in specs[key]:
+                if not isinstance(spec, int) and not (
+                    isinstance(spec, str) and spec.endswith("+") and spec[:-1].isdigit()
+                ):
+                    raise RAValueError(
+                        f"Invalid argument spec in the API model: {spec}"
+                    )
+        return APIModel(
+            specs["reads"],
+            specs["writes"],
+            specs["returns"],
+            io,
+            bool(model_dict.get("noreturn", False)),
+        )
+
+    def to_dict(self) -> Dict:
+        """Convert the API model to an entry of a model table."""
+        return {
+            "reads": self.reads,
+            "writes": self.writes,
+            "returns": self.returns,
+            "io": self.io,
+            "noreturn": self.is_noreturn,
+        }
+
+
+def load_api_models(api_model_paths: List[str]) -> Dict[str, APIModel]:
+    """Load API model tables, the later ones overriding the earlier ones.
+
+    A table is a JSON object mapping the API names to their models (see
+    APIModel.from_dict).
+
+    Args:
+        api_model_paths: Paths of the tables
+
+    Returns:
+        Dictionary mapping the API names to their models
+
+    Raises:
+        RAValueError: If a table is invalid
+    """
+    api_models: Dict[str, APIModel] = {}
+    for api_model_path in api_model_paths:
+        with open(api_model_path, "r") as f:
+            table = json.load(f)
+        if not isinstance(table, dict):
+            raise RAValueError(
+                f"The API model table must be a JSON object: {api_model_path}"
+            )
+        for api_name, model_dict in table.items():
+            # Keys starting with "//" are comments
+            if api_name.startswith("//"):
+                continue
+            api_models[api_name] = APIModel.from_dict(model_dict)
+    return api_models
+
 
 class API:
     """Class representing a library API function with its metadata."""
@@ -9,6 +186,7 @@ class API:
         api_id: int,
         api_name: str,
         api_para_num: int,
+        model: Optional[APIModel] = None,
     ) -> None:
         """Initialize an API object with basic metadata.
 
@@ -16,10 +194,12 @@ class API:
             api_id: Unique identifier for the API
             api_name: Name of the API function
             api_para_num: Number of parameters the API function accepts
+            model: Side effects and dataflow of the API, if modeled
         """
         self.api_id = api_id
         self.api_name = api_name
         self.api_para_num = api_para_num
+        self.model = model
 
     def __str__(self) -> str:
         """Generate string representation of the API.
@@ -64,4 +244,11 @@ class API:
             "api_id": self.api_id,
             "api_name": self.api_name,
             "api_para_num": self.api_para_num,
+            "model": self.model.to_dict() if self.model is not None else None,
         }
+
+    def description(self) -> Optional[str]:
+        """Describe the effects of the API in a prompt, if modeled."""
+        if self.model is None:
+            return None
+        return self.model.description(self.api_name, self.api_para_num)
@@ -1,7 +1,9 @@
 from typing import Dict, List, Optional, Set, Tuple
 import copy
+import hashlib
 from tree_sitter import Node
 
+from memory.utils.identifier_index import IdentifierIndex
 from memory.utils.value import Value, ValueLabel
 from utility.errors import RAAnalysisError
 
@@ -48,6 +50,7 @@ class Function:
         self.file_path = file_path
         self.lined_code = self.attach_relative_line_number()
         self.parse_tree_root_node = function_node
+        self._content_hash: Optional[str] = None
 
         # Call site tracking
         self.function_call_site_nodes: Dict[int, Tuple[Node, str, int, int]] = {}
@@ -66,6 +69,9 @@ class Function:
         self.if_statements: Dict[Scope, IfStatement] = {}
         self.loop_statements: Dict[Scope, LoopStatement] = {}
 
+        # Occurrences of the identifiers
+        self.identifier_index = IdentifierIndex()
+
     def add_para(self, para: Value) -> None:
         """Add a parameter to the function.
 
@@ -233,6 +239,20 @@ class Function:
                 return site_id
         return -1
 
+    def content_hash(self) -> str:
+        """Get the content hash of the function.
+
+        The hash only depends on the function name and code, so that the same
+        function in two revisions (or at shifted locations) gets the same hash.
+
+        Returns:
+            Hex digest of the function content
+        """
+        if self._content_hash is None:
+            content = f"{self.function_name}\n{self.function_code}"
+            self._content_hash = hashlib.sha256(content.encode()).hexdigest()
+        return self._content_hash
+
     def file_line2function_line(self, file_line: int) -> int:
         """Convert file line number to function-relative line number.
 
@@ -298,6 +318,34 @@ class Function:
             )
         )
 
+    def __eq__(self, other: object) -> bool:
+        """Check equality with another function.
+
+        Functions are equal if they have the same id and identifying attributes,
+        so that the copies of a function reloaded from an offloaded U6IR are equal.
+
+        Args:
+            other: Object to compare with
+
+        Returns:
+            True if the functions are equal, False otherwise
+        """
+        if not isinstance(other, Function):
+            return NotImplemented
+        return self.function_id == other.function_id and (
+            self.function_name,
+            self.function_code,
+            self.file_path,
+            self.start_line_number,
+            self.end_line_number,
+        ) == (
+            other.function_name,
+            other.function_code,
+            other.file_path,
+            other.start_line_number,
+            other.end_line_number,
+        )
+
     def __str__(self) -> str:
         """Generate string representation of function.
 
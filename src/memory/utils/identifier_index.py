@@ -0,0 +1,122 @@
+from bisect import bisect_left, bisect_right, insort
+from enum import Enum
+from typing import Dict, Iterable, List, Optional, Tuple
+
+
+class IdentifierRole(str, Enum):
+    """Role of an occurrence of an identifier in a function."""
+
+    DEF = "def"  # Declared, assigned or updated (e.g., x in x = 1 or x++)
+    USE = "use"  # Read in any other expression
+    ARG = "arg"  # Read in an argument of a call
+    PARA = "para"  # Declared as a parameter
+    RET = "ret"  # Read in a return statement
+
+
+# An occurrence is (line number in the function, start byte, end byte, role), the
+# byte range being relative to the start of the function code
+Occurrence = Tuple[int, int, int, IdentifierRole]
+
+
+class IdentifierIndex:
+    """Index of the occurrences of the identifiers in a function.
+
+    The occurrences of each identifier are sorted by position, so the occurrences
+    in a line range are found by binary search, without walking the AST again.
+    """
+
+    def __init__(self) -> None:
+        # Maps identifier names -> their occurrences sorted by position
+        self._occurrences: Dict[str, List[Occurrence]] = {}
+
+    def add(
+        self,
+        name: str,
+        line_number: int,
+        start_byte: int,
+        end_byte: int,
+        role: IdentifierRole,
+    ) -> None:
+        """Add an occurrence of an identifier.
+
+        Args:
+            name: Name of the identifier
+            line_number: Line number in the function
+            start_byte: Start of the occurrence in the function code
+            end_byte: End of the occurrence in the function code
+            role: Role of the occurrence
+        """
+        insort(
+            self._occurrences.setdefault(name, []),
+            (line_number, start_byte, end_byte, role),
+        )
+
+    def names(self) -> List[str]:
+        """Get the names of the indexed identifiers."""
+        return sorted(self._occurrences)
+
+    def get_occurrences(
+        self,
+        name: str,
+        start_line: Optional[int] = None,
+        end_line: Optional[int] = None,
+        roles: Optional[Iterable[IdentifierRole]] = None,
+    ) -> List[Occurrence]:
+        """Get the occurrences of an identifier, in O(log n) plus the output size.
+
+        Args:
+            name: Name of the identifier
+            start_line: First line of the occurrences, or None for no lower bound
+            end_line: Last line of the occurrences, or None for no upper bound
+            roles: Roles of the occurrences, or None for all roles
+
+        Returns:
+            The matching occurrences sorted by position
+        """
+        occurrences = self._occurrences.get(name, [])
+        # A 1-tuple sorts before the occurrences of its line
+        start = 0 if start_line is None else bisect_left(occurrences, (start_line,))
+        end = (
+            len(occurrences)
+            if end_line is None
+            else bisect_right(occurrences, (end_line + 1,))
+        )
+        if roles is None:
+            return occurrences[start:end]
+        role_set = set(roles)
+        return [
+            occurrence
+            for occurrence in occurrences[start:end]
+            if occurrence[3] in role_set
+        ]
+
+    def is_mentioned(self, name: str, line_number: int) -> bool:
+        """Check whether an identifier occurs at a line of the function."""
+        return len(self.get_occurrences(name, line_number, line_number)) > 0
+
+    def __len__(self) -> int:
+        return sum(len(occurrences) for occurrences in self._occurrences.values())
+
+    def to_dict(self) -> Dict[str, List[List]]:
+        """Convert the index to a JSON-serializable dictionary.
+
+        Returns:
+            Dictionary mapping the names to their occurrences as lists
+        """
+        return {
+            name: [[line, start, end, role.value] for line, start, end, role in occs]
+            for name, occs in self._occurrences.items()
+        }
+
+    @staticmethod
+    def from_dict(index_dict: Dict[str, List[List]]) -> "IdentifierIndex":
+        """Create an index from the dictionary returned by to_dict."""
+        index = IdentifierIndex()
+        index._occurrences = {
+            name: [
+                (line, start, end, IdentifierRole(role))
+                for line, start, end, role in occurrences
+            ]
+            for name, occurrences in index_dict.items()
+        }
+        return index
@@ -1,24 +1,190 @@
 import argparse
 from ast import Continue
+import concurrent.futures
 import json
+import logging
 import os
 import sys
+import tempfile
+import threading
 import time
 from pathlib import Path
-from typing import List, Dict, Tuple
+from typing import List, Dict, Optional, Set, Tuple
 
 from agent.slicescan import SliceScanAgent
+from llmtool.LLM_scheduler import LLMScheduler
+from llmtool.LLM_cache import LLM_CACHE
+from llmtool.LLM_trace import LLM_TRACE
+from llmtool.slicescan.intra_slicer import IntraSlicer
+from memory.state.slicescan_state import SliceScanState
 from memory.IR.U6IR import U6IR
+from memory.IR.U6IR_store import DEFAULT_FUNCTION_CACHE_SIZE, get_snapshot_key
 
 from tstool.analyzer.TS_analyzer import *
 from tstool.analyzer.Cpp_TS_analyzer import *
+from utility.call_neighborhood import get_call_neighborhood_files
+from utility.compile_commands import collect_build_files
 from utility.errors import *
+from utility.include_graph import get_include_scopes
+from utility.logger import set_default_log_levels
 from utility.request import *
+from utility.revision import checkout_revision, get_line_mapper
+from utility.memory_profiler import MEMORY_PROFILER
+from utility.metrics import METRICS, MetricsExporter
+from utility.pipeline_stage import pipeline_stage
+from utility.stage_timer import STAGE_TIMER, get_peak_rss_bytes
+from utility.tracer import TRACER
 
 
 BASE_PATH = Path(__file__).resolve().parents[1]
 
 
+def collect_source_files(project_path: str, suffixes: List[str]) -> Dict[str, str]:
+    """Traverse a project directory and read its source code files.
+
+    Args:
+        project_path: Root path of the project to analyze
+        suffixes: List of file extensions to include (without dots)
+
+    A file reached through several paths (e.g., a header linked into several
+    directories) is read once, under its real path if in the project.
+
+    Returns:
+        Dictionary mapping the absolute file paths to their contents
+    """
+    project_root = Path(project_path)
+
+    if not project_root.exists():
+        raise RAValueError(f"Project path does not exist: {project_path}")
+
+    if not project_root.is_dir():
+        raise RAValueError(f"Project path is not a directory: {project_path}")
+
+    code_in_files: Dict[str, str] = {}
+    real_paths: Set[str] = set()
+    real_root = os.path.join(os.path.realpath(project_root), "")
+
+    # Traverse all files recursively
+    for file_path in sorted(project_root.rglob("*")):
+        if file_path.is_file():
+            # Check if file has a matching suffix
+            if any(file_path.name.endswith(f".{suffix}") for suffix in suffixes):
+                real_path = os.path.realpath(file_path)
+                if real_path in real_paths or (
+                    file_path.is_symlink() and real_path.startswith(real_root)
+                ):
+                    continue
+                real_paths.add(real_path)
+                try:
+                    # Read file content
+                    with open(file_path, "r", encoding="utf-8", errors="ignore") as f:
+                        content = f.read()
+
+                    # Store with absolute path as key
+                    code_in_files[str(file_path.absolute())] = content
+
+                except (OSError, IOError) as e:
+                    print(f"Warning: Could not read file {file_path}: {e}")
+                    continue
+
+    if not code_in_files:
+        print(
+            f"Warning: No source files found with extensions {suffixes} in {project_path}"
+        )
+    return code_in_files
+
+
+def collect_project_files(
+    project_path: str, suffixes: List[str], compile_commands_path: Optional[str]
+) -> Tuple[Dict[str, str], Dict[str, Set[str]]]:
+    """Collect the files of a project to analyze.
+
+    Args:
+        project_path: Root path of the project to analyze
+        suffixes: List of file extensions to include (without dots)
+        compile_commands_path: Path of the compile_commands.json file of the
+            project, or None to analyze all its source files
+
+    Returns:
+        Tuple of (dictionary mapping the absolute file paths to their contents, and
+        the scopes of the files resolving the calls)
+    """
+    if compile_commands_path is None:
+        code_in_files = collect_source_files(project_path, suffixes)
+        return code_in_files, get_include_scopes(project_path, code_in_files)
+    return collect_build_files(project_path, compile_commands_path)
+
+
+def get_ir_store_path(
+    ir_store_dir: str,
+    code_in_files: Dict[str, str],
+    language: str,
+    file_scopes: Optional[Dict[str, Set[str]]] = None,
+) -> str:
+    """Get the path of the U6IR snapshot of a set of source files.
+
+    The stores are named after the sources and their paths, so that an unchanged
+    project at the same path reuses the snapshot of its U6IR.
+
+    Args:
+        ir_store_dir: Directory of the U6IR snapshots
+        code_in_files: Dictionary mapping file paths to their source code content
+        language: Programming language of the files
+        file_scopes: Scopes of the files resolving the calls, if any
+
+    Returns:
+        Path of the snapshot, which may not exist yet
+    """
+    os.makedirs(ir_store_dir, exist_ok=True)
+    snapshot_key = get_snapshot_key(code_in_files, language, file_scopes)
+    return os.path.join(ir_store_dir, f"u6ir_{snapshot_key}.sqlite")
+
+
+def build_workspace_ir(
+    project_path: str,
+    language: str,
+    suffixes: List[str],
+    max_symbolic_workers: int,
+    ir_store_dir: str,
+    compile_commands_path: Optional[str] = None,
+) -> Tuple[str, str, bool, float]:
+    """Build the U6IR snapshot of a workspace project, run by a builder process.
+
+    The U6IR holds tree-sitter nodes, which cannot be sent back to the main
+    process, so it is offloaded to its snapshot, which the main process loads.
+
+    Args:
+        project_path: Root path of the project
+        language: Programming language of the project
+        suffixes: List of file extensions to include (without dots)
+        max_symbolic_workers: Max symbolic workers for parsing-based analysis
+        ir_store_dir: Directory of the U6IR snapshots
+        compile_commands_path: Path of a compile_commands.json file listing the
+            TUs of the project, if any
+
+    Returns:
+        Tuple of (project path, snapshot path, whether an existing snapshot is
+        reused, seconds the build took)
+    """
+    start_time = time.perf_counter()
+    code_in_files, file_scopes = collect_project_files(
+        project_path, suffixes, compile_commands_path
+    )
+    ir_store_path = get_ir_store_path(
+        ir_store_dir, code_in_files, language, file_scopes
+    )
+    is_reused = os.path.exists(ir_store_path)
+    if not is_reused:
+        Cpp_TSAnalyzer(
+            code_in_files,
+            language,
+            max_symbolic_workers,
+            ir_store_path,
+            file_scopes=file_scopes,
+        ).run()
+    return project_path, ir_store_path, is_reused, time.perf_counter() - start_time
+
+
 class RepoSlice:
     def __init__(
         self,
@@ -30,19 +196,38 @@ class RepoSlice:
         # argument format check
         self.args = args
 
-        self.slice_request_path = args.slice_request_path
+        self.slice_request_paths = args.slice_request_path
         self.language = args.language
         self.max_symbolic_workers = args.max_symbolic_workers
         self.max_query_num = args.max_query_num
         self.audit_model_name = args.audit_model_name
         self.temperature = args.temperature
         self.call_depth = args.call_depth
+        self.max_scc_iterations = args.max_scc_iterations
         self.is_backward = args.is_backward
-
-        with open(self.slice_request_path, "r") as f:
-            self.slice_request = SliceRequest.from_dict(json.load(f))
-
-        print(self.slice_request.description())
+        self.base_revision = args.base_revision
+        self.head_revision = args.head_revision
+        self.max_llm_workers = args.max_llm_workers
+        self.tenant_config_path = args.tenant_config
+        self.prompt_dir = args.prompt_dir
+        self.max_chunk_lines = args.max_chunk_lines
+        self.ir_store_dir = args.ir_store_dir
+        self.ir_cache_size = args.ir_cache_size
+        self.compile_commands_path = args.compile_commands
+        # The models of the C standard library APIs, overridden by the custom ones
+        self.api_models = load_api_models([DEFAULT_API_MODEL_PATH] + args.api_models)
+        self.workspace_project_paths: List[str] = args.workspace_projects or []
+        self.workspace_workers = args.workspace_workers
+        self.workspace_tmp_dir: Optional[tempfile.TemporaryDirectory] = None
+
+        self.slice_requests: List[SliceRequest] = []
+        for slice_request_path in self.slice_request_paths:
+            with open(slice_request_path, "r") as f:
+                self.slice_requests.append(SliceRequest.from_dict(json.load(f)))
+        self.slice_request = self.slice_requests[0]
+
+        for slice_request in self.slice_requests:
+            print(slice_request.description())
 
         # Extract project path and name from slice request
         self.project_path = str(Path(self.slice_request.project_path))
@@ -51,17 +236,114 @@ class RepoSlice:
         # Initialize code storage
         self.code_in_files: Dict[str, str] = {}
 
+        # The agents run by the current mode
+        self.agents: List[SliceScanAgent] = []
+
         assert self.language == "Cpp", "Only Cpp is supported for now."
-        suffixs = ["cpp", "cc", "hpp", "c", "h"]
-        self.traverse_files(self.project_path, suffixs)
+        self.suffixs = ["cpp", "cc", "hpp", "c", "h"]
+
+        # The U6IRs built for the batch and workspace modes, keyed by the absolute
+        # project paths
+        self.u6irs: Dict[str, U6IR] = {}
+
+        # In the diff mode, the U6IRs are built from the checked out revisions, and
+        # in the batch and workspace modes, one U6IR is built per project
+        if (
+            self.base_revision is None
+            and len(self.slice_requests) == 1
+            and not self.workspace_project_paths
+        ):
+            self.ts_analyzer = self.build_ts_analyzer(self.project_path)
+
+    def build_ts_analyzer(
+        self, project_path: str, slice_request: Optional[SliceRequest] = None
+    ) -> Cpp_TSAnalyzer:
+        """Collect the source files of a project and create its analyzer.
+
+        Args:
+            project_path: Root path of the project to analyze
+            slice_request: Request whose call neighborhood the analysis is
+                restricted to (see utility/call_neighborhood.py), or None to
+                analyze the whole project
+
+        Returns:
+            The analyzer building the U6IR of the project
+        """
+        with pipeline_stage("traverse_files", "reposlice", project_path=project_path):
+            if self.compile_commands_path is None:
+                self.traverse_files(project_path, self.suffixs)
+                file_scopes = get_include_scopes(project_path, self.code_in_files)
+            else:
+                self.code_in_files, file_scopes = collect_build_files(
+                    project_path, self.compile_commands_path
+                )
+                print(
+                    f"{len(self.code_in_files)} files of {project_path} are "
+                    f"in the build of {self.compile_commands_path}"
+                )
+
+        if slice_request is not None:
+            self.restrict_to_call_neighborhood(slice_request, file_scopes)
+
+        ir_store_path = None
+        if self.ir_store_dir is not None:
+            ir_store_path = get_ir_store_path(
+                self.ir_store_dir, self.code_in_files, self.language, file_scopes
+            )
 
         # Build the U6IR of the project
-        self.ts_analyzer = Cpp_TSAnalyzer(
+        return Cpp_TSAnalyzer(
             self.code_in_files,
             self.language,
             self.max_symbolic_workers,
+            ir_store_path,
+            self.ir_cache_size,
+            file_scopes,
+            self.api_models,
         )
 
+    def restrict_to_call_neighborhood(
+        self, slice_request: SliceRequest, file_scopes: Dict[str, Set[str]]
+    ) -> None:
+        """Keep the files of the call neighborhood of a request and their headers.
+
+        The scopes are computed on all the files beforehand, so the calls are
+        still resolved to the definitions visible in the whole project.
+
+        Args:
+            slice_request: Request whose seeds the neighborhood is computed from
+            file_scopes: Maps each file to its scope, restricted in place
+        """
+        neighborhood_files = get_call_neighborhood_files(
+            self.code_in_files,
+            [(seed.file_path, seed.seed_line_number) for seed in slice_request.seeds],
+            self.call_depth,
+        )
+        if neighborhood_files is None:
+            print(
+                "Warning: A seed is outside of the functions found by the scan. "
+                "Analyzing all the files."
+            )
+            return
+        kept_files: Set[str] = set()
+        for file_path in neighborhood_files:
+            kept_files.update(file_scopes.get(file_path, {file_path}))
+        print(
+            f"{len(kept_files)} of {len(self.code_in_files)} files are in the call "
+            f"neighborhood of {slice_request.slicing_request_id}"
+        )
+        # Start from a fresh dict, as analyzers built earlier keep a reference
+        self.code_in_files = {
+            file_path: source_code
+            for file_path, source_code in self.code_in_files.items()
+            if file_path in kept_files
+        }
+        for file_path in list(file_scopes):
+            if file_path in kept_files:
+                file_scopes[file_path] &= kept_files
+            else:
+                del file_scopes[file_path]
+
     def traverse_files(self, project_path: str, suffixes: List[str]) -> None:
         """Traverse the project directory and collect source code files.
 
@@ -69,40 +351,8 @@ class RepoSlice:
             project_path: Root path of the project to analyze
             suffixes: List of file extensions to include (without dots)
         """
-        project_root = Path(project_path)
-
-        if not project_root.exists():
-            raise RAValueError(f"Project path does not exist: {project_path}")
-
-        if not project_root.is_dir():
-            raise RAValueError(f"Project path is not a directory: {project_path}")
-
-        # Clear existing files
-        self.code_in_files.clear()
-
-        # Traverse all files recursively
-        for file_path in project_root.rglob("*"):
-            if file_path.is_file():
-                # Check if file has a matching suffix
-                if any(file_path.name.endswith(f".{suffix}") for suffix in suffixes):
-                    try:
-                        # Read file content
-                        with open(
-                            file_path, "r", encoding="utf-8", errors="ignore"
-                        ) as f:
-                            content = f.read()
-
-                        # Store with absolute path as key
-                        self.code_in_files[str(file_path.absolute())] = content
-
-                    except (OSError, IOError) as e:
-                        print(f"Warning: Could not read file {file_path}: {e}")
-                        continue
-
-        if not self.code_in_files:
-            print(
-                f"Warning: No source files found with extensions {suffixes} in {project_path}"
-            )
+        # Start from a fresh dict, as analyzers built earlier keep a reference
+        self.code_in_files = collect_source_files(project_path, suffixes)
 
     def run(self):
         self.ts_analyzer.run()
@@ -116,9 +366,305 @@ class RepoSlice:
             self.max_query_num,
             self.slice_request,
             self.call_depth,
+            self.max_scc_iterations,
+            max_llm_workers=self.max_llm_workers,
+            prompt_dir=self.prompt_dir,
+            max_chunk_lines=self.max_chunk_lines,
         )
+        self.agents = [self.slice_scan_agent]
         self.slice_scan_agent.run()
 
+    def load_tenant_config(self) -> Dict[str, Dict]:
+        """Load the weights and rate limits of the tenants.
+
+        The config maps a tenant name to an object with the optional keys "weight"
+        (default: 1.0) and "max_queries_per_second" (default: no limit).
+
+        Returns:
+            Dictionary mapping tenant names to their configurations
+        """
+        if self.tenant_config_path is None:
+            return {}
+        with open(self.tenant_config_path, "r") as f:
+            tenant_config = json.load(f)
+        if not isinstance(tenant_config, dict):
+            raise RAValueError(
+                f"The tenant config must be a JSON object: {self.tenant_config_path}"
+            )
+        return tenant_config
+
+    def build_workspace(self) -> None:
+        """Build the U6IRs of the workspace projects concurrently.
+
+        The projects are analyzed by a pool of builder processes, each loading the
+        tree-sitter grammar once for all its projects. The U6IRs are offloaded to
+        their snapshots in ir_store_dir (a temporary directory if not set), and
+        loaded side by side by the main process, so that the slice requests
+        against any of the projects are served without analyzing it again. The
+        snapshots of unchanged projects are reused by the later runs.
+        """
+        ir_store_dir = self.ir_store_dir
+        if ir_store_dir is None:
+            self.workspace_tmp_dir = tempfile.TemporaryDirectory()
+            ir_store_dir = self.workspace_tmp_dir.name
+
+        # Processes forked after the grammar is loaded inherit it
+        get_language(self.language)
+        with pipeline_stage(
+            "build_workspace",
+            "reposlice",
+            project_num=len(self.workspace_project_paths),
+        ):
+            with concurrent.futures.ProcessPoolExecutor(
+                max_workers=self.workspace_workers,
+                initializer=get_language,
+                initargs=(self.language,),
+            ) as executor:
+                futures = [
+                    executor.submit(
+                        build_workspace_ir,
+                        project_path,
+                        self.language,
+                        self.suffixs,
+                        self.max_symbolic_workers,
+                        ir_store_dir,
+                        self.compile_commands_path,
+                    )
+                    for project_path in self.workspace_project_paths
+                ]
+                for future in concurrent.futures.as_completed(futures):
+                    project_path, ir_store_path, is_reused, build_time = future.result()
+                    # The file contents stay in the builder processes
+                    u6ir = U6IR({})
+                    u6ir.load(ir_store_path, self.ir_cache_size)
+                    u6ir.attach_api_models(self.api_models)
+                    self.u6irs[os.path.abspath(project_path)] = u6ir
+                    print(
+                        f"The U6IR of {project_path} is "
+                        f"{'reused' if is_reused else 'built'} in "
+                        f"{build_time:.1f}s ({len(u6ir.function_env)} functions)"
+                    )
+
+    def run_batch(self) -> None:
+        """Run several slice requests concurrently with fair sharing of the LLM.
+
+        All the agents run in their own threads and issue their LLM queries through
+        one LLMScheduler, which bounds the total number of in-flight queries by
+        max_llm_workers and admits the queries of the tenants by weighted deficit
+        round-robin. A large request thus cannot starve the small ones.
+
+        Raises:
+            RepoSliceError: If a slice request failed, once all of them are done
+        """
+        tenant_config = self.load_tenant_config()
+        scheduler = LLMScheduler(self.max_llm_workers)
+
+        # Build the U6IR of each project once, unless built with the workspace
+        for slice_request in self.slice_requests:
+            project_path = str(Path(slice_request.project_path))
+            if os.path.abspath(project_path) not in self.u6irs:
+                ts_analyzer = self.build_ts_analyzer(project_path)
+                ts_analyzer.run()
+                self.u6irs[os.path.abspath(project_path)] = ts_analyzer.u6ir
+
+        agents: List[SliceScanAgent] = []
+        for slice_request in self.slice_requests:
+            config = tenant_config.get(slice_request.tenant, {})
+            llm_tenant = scheduler.register_tenant(
+                slice_request.tenant,
+                config.get("weight", 1.0),
+                config.get("max_queries_per_second"),
+            )
+            project_path = str(Path(slice_request.project_path))
+            agents.append(
+                SliceScanAgent(
+                    project_path,
+                    self.language,
+                    self.u6irs[os.path.abspath(project_path)],
+                    self.audit_model_name,
+                    self.temperature,
+                    self.max_query_num,
+                    slice_request,
+                    self.call_depth,
+                    self.max_scc_iterations,
+                    llm_tenant=llm_tenant,
+                    max_llm_workers=self.max_llm_workers,
+                    prompt_dir=self.prompt_dir,
+                    max_chunk_lines=self.max_chunk_lines,
+                )
+            )
+
+        self.agents = agents
+        errors: Dict[str, BaseException] = {}
+
+        def run_agent(agent: SliceScanAgent, slicing_request_id: str) -> None:
+            try:
+                agent.run()
+            except Exception as e:
+                errors[slicing_request_id] = e
+
+        # The threads are named after the requests, which names them in the trace
+        threads = [
+            threading.Thread(
+                target=run_agent,
+                args=(agent, slice_request.slicing_request_id),
+                name=slice_request.slicing_request_id,
+            )
+            for agent, slice_request in zip(agents, self.slice_requests)
+        ]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+        for tenant in scheduler.get_tenants():
+            print(json.dumps(tenant.to_dict()))
+        for slicing_request_id, error in errors.items():
+            print(
+                f"Slice request {slicing_request_id} failed: {error}", file=sys.stderr
+            )
+        if errors:
+            raise RepoSliceError(
+                f"{len(errors)} of {len(agents)} slice requests failed: "
+                + ", ".join(sorted(errors))
+            )
+
+    def run_diff(self) -> None:
+        """Slice the base and head revisions and report the per-function difference.
+
+        The seeds of the request are lines of the base revision, and are mapped to
+        the head revision through the diff of their files. Each revision is only
+        analyzed in the call neighborhood of its seeds, so the analysis does not
+        grow with the rest of the project.
+
+        Both revisions are sliced with the same intra-procedural slicer. Its cache is
+        keyed by function content, so unchanged functions are answered from the
+        results of the base revision and only changed functions are queried again.
+        """
+        agents: Dict[str, SliceScanAgent] = {}
+        project_paths: Dict[str, str] = {}
+        intra_slicer: Optional[IntraSlicer] = None
+        query_nums: Dict[str, int] = {}
+        map_head_line = get_line_mapper(
+            self.project_path, self.base_revision, self.head_revision
+        )
+
+        with tempfile.TemporaryDirectory() as checkout_dir:
+            for label, revision in (
+                ("base", self.base_revision),
+                ("head", self.head_revision),
+            ):
+                revision_dir = os.path.join(checkout_dir, label)
+                os.makedirs(revision_dir)
+                project_path = checkout_revision(
+                    self.project_path, revision, revision_dir
+                )
+                slice_request = self.slice_request.relocate(
+                    project_path, map_head_line if label == "head" else None
+                )
+                ts_analyzer = self.build_ts_analyzer(project_path, slice_request)
+                ts_analyzer.run()
+
+                agent = SliceScanAgent(
+                    project_path,
+                    self.language,
+                    ts_analyzer.u6ir,
+                    self.audit_model_name,
+                    self.temperature,
+                    self.max_query_num,
+                    slice_request,
+                    self.call_depth,
+                    self.max_scc_iterations,
+                    intra_slicer,
+                    prompt_dir=self.prompt_dir,
+                    max_chunk_lines=self.max_chunk_lines,
+                )
+                prior_query_num = agent.intra_slicer.total_query_num
+                agent.run()
+                query_nums[label] = (
+                    agent.intra_slicer.total_query_num - prior_query_num
+                )
+                intra_slicer = agent.intra_slicer
+                agents[label] = agent
+                project_paths[label] = project_path
+                self.agents.append(agent)
+
+        # Functions are keyed by file and name, as static functions of different
+        # files may have the same name
+        def get_function_key(function: Function, label: str) -> Tuple[str, str]:
+            return (
+                os.path.relpath(function.file_path, project_paths[label]),
+                function.function_name,
+            )
+
+        base_function_hashes: Dict[Tuple[str, str], Set[str]] = {}
+        for function in agents["base"].u6ir.function_env.values():
+            base_function_hashes.setdefault(
+                get_function_key(function, "base"), set()
+            ).add(function.content_hash())
+        changed_functions = sorted(
+            {
+                get_function_key(function, "head")
+                for function in agents["head"].u6ir.function_env.values()
+                if function.content_hash()
+                not in base_function_hashes.get(
+                    get_function_key(function, "head"), set()
+                )
+            }
+        )
+
+        slice_diff = {
+            "slicing_request_id": self.slice_request.slicing_request_id,
+            "base_revision": self.base_revision,
+            "head_revision": self.head_revision,
+            "changed_functions": [
+                {"file_path": file_path, "function_name": function_name}
+                for file_path, function_name in changed_functions
+            ],
+            "llm_query_num": query_nums,
+            "function_diffs": SliceScanState.diff(
+                agents["base"].state, agents["head"].state
+            ),
+        }
+
+        head_agent = agents["head"]
+        slice_diff_path = (
+            f"{head_agent.res_dir_path}/slice_diff_"
+            f"{self.slice_request.slicing_request_id}.json"
+        )
+        with open(slice_diff_path, "w") as slice_diff_file:
+            json.dump(slice_diff, slice_diff_file, indent=4)
+        head_agent.logger.print_console("The slice diff is saved in " + slice_diff_path)
+
+    def export_trace(self) -> None:
+        """Export the trace of the run next to the agent.log of each agent run.
+
+        The spans of all the agents are recorded on one timeline, so the agents of
+        one run get the same trace.
+        """
+        for agent in self.agents:
+            trace_path = f"{agent.log_dir_path}/trace.json"
+            TRACER.export(trace_path)
+            agent.logger.print_console("The trace is saved in " + trace_path)
+
+    def export_memory_profile(self) -> None:
+        """Export the memory profile of the run to the result directory of each agent.
+
+        The profile ends with the memory retained after the slicing, measured on
+        the U6IRs of all the agents.
+        """
+        if self.agents:
+            MEMORY_PROFILER.checkpoint(
+                "slice_scan", *(agent.u6ir for agent in self.agents)
+            )
+        for agent in self.agents:
+            memory_profile_path = f"{agent.res_dir_path}/memory_profile.json"
+            with open(memory_profile_path, "w") as memory_profile_file:
+                json.dump(MEMORY_PROFILER.to_dict(), memory_profile_file, indent=4)
+            agent.logger.print_console(
+                "The memory profile is saved in " + memory_profile_path
+            )
+
 
 def configure_args():
     parser = argparse.ArgumentParser(
@@ -128,7 +674,8 @@ def configure_args():
     parser.add_argument(
         "--slice-request-path",
         required=True,
-        help="A json file containing the slice request",
+        nargs="+",
+        help="Json files containing the slice requests (several run concurrently)",
     )
     parser.add_argument("--language", required=True, help="Programming language")
 
@@ -154,20 +701,285 @@ def configure_args():
         "--temperature", type=float, default=0.5, help="Temperature for inference"
     )
     parser.add_argument("--call-depth", type=int, default=3, help="Call depth setting")
+    parser.add_argument(
+        "--max-scc-iterations",
+        type=int,
+        default=5,
+        help=(
+            "Maximum number of rounds over a recursive SCC of the call graph, after "
+            "which its work items are dropped and the slice is marked as truncated"
+        ),
+    )
 
     # Parameters for slicescan
     parser.add_argument(
         "--is-backward", action="store_true", help="Flag for backward slicing"
     )
+    parser.add_argument(
+        "--prompt-dir",
+        default=None,
+        help="Directory of the prompt templates (default: prompt/<language>/slicescan)",
+    )
+    parser.add_argument(
+        "--max-chunk-lines",
+        type=int,
+        default=None,
+        help="Slice the functions longer than this by chunks of at most this many "
+        "lines (default: slice every function whole)",
+    )
+
+    # Parameters for offloading the U6IR of large projects
+    parser.add_argument(
+        "--ir-store-dir",
+        default=None,
+        help="Directory of the SQLite snapshots the analyzed U6IRs are offloaded to, "
+        "reused by the runs on the same sources (default: kept in memory). A U6IR is "
+        "offloaded once it is fully built, so the peak memory of its analysis is not "
+        "lowered",
+    )
+    parser.add_argument(
+        "--ir-cache-size",
+        type=int,
+        default=DEFAULT_FUNCTION_CACHE_SIZE,
+        help="Maximum number of functions of an offloaded U6IR kept in memory",
+    )
+    parser.add_argument(
+        "--compile-commands",
+        default=None,
+        help="A compile_commands.json file: only its TUs in the project and the "
+        "headers they include are analyzed, and the calls are resolved to the "
+        "definitions visible from the caller's TU",
+    )
+
+    parser.add_argument(
+        "--api-models",
+        nargs="+",
+        default=[],
+        help="JSON tables of library API models (see api_model/Cpp/libc.json), "
+        "overriding the models of the C standard library",
+    )
+
+    # Parameters for the workspace mode
+    parser.add_argument(
+        "--workspace-projects",
+        nargs="+",
+        default=None,
+        help="Root paths of the projects of a workspace, whose U6IRs are built "
+        "concurrently before serving the slice requests against any of them",
+    )
+    parser.add_argument(
+        "--workspace-workers",
+        type=int,
+        default=os.cpu_count(),
+        help="Number of processes building the U6IRs of the workspace projects",
+    )
+
+    # Parameters for the cross-revision diff mode
+    parser.add_argument(
+        "--base-revision",
+        default=None,
+        help=(
+            "Git revision to diff the slice against (requires --head-revision). "
+            "The seed lines of the request refer to this revision"
+        ),
+    )
+    parser.add_argument(
+        "--head-revision",
+        default=None,
+        help="Git revision whose slice is diffed against --base-revision",
+    )
+
+    # Parameters for running several slice requests concurrently
+    parser.add_argument(
+        "--max-llm-workers",
+        type=int,
+        default=1,
+        help="Maximum number of concurrent LLM queries of all the slice requests",
+    )
+    parser.add_argument(
+        "--tenant-config",
+        default=None,
+        help="A json file mapping tenants to their weights and rate limits",
+    )
+
+    # Parameters for recording and replaying the LLM answers
+    parser.add_argument(
+        "--llm-record-path",
+        default=None,
+        help="A JSONL file the LLM answers of the run are appended to",
+    )
+    parser.add_argument(
+        "--llm-replay-path",
+        default=None,
+        help="A JSONL file of recorded LLM answers replayed instead of querying LLMs "
+        "(with --llm-record-path, the missing answers are queried and recorded)",
+    )
+    parser.add_argument(
+        "--llm-replay-latency",
+        action="store_true",
+        help="Wait for the recorded latency of each replayed LLM answer",
+    )
+    parser.add_argument(
+        "--llm-cache-dir",
+        default=None,
+        help="Directory of a content-addressed LLM answer cache shared by the runs "
+        "(e.g., by the distributed workers on a shared file system)",
+    )
+
+    # Parameters for logging
+    parser.add_argument(
+        "--log-level",
+        default="DEBUG",
+        choices=["DEBUG", "INFO", "WARNING"],
+        help=(
+            "Level of agent.log (DEBUG keeps the bounded per-call logs of the LLM "
+            "tools; the full prompts and responses are in llm_interactions.jsonl "
+            "and the llm_blobs.jsonl.gz blob store)"
+        ),
+    )
+    parser.add_argument(
+        "--console-log-level",
+        default="INFO",
+        choices=["DEBUG", "INFO", "WARNING"],
+        help=(
+            "Level of the console output (DEBUG prints the bounded per-call logs "
+            "of the LLM tools; the full prompts are in llm_interactions.jsonl and "
+            "the llm_blobs.jsonl.gz blob store)"
+        ),
+    )
+
+    # Parameters for benchmarking
+    parser.add_argument(
+        "--stage-timing-output",
+        default=None,
+        help="A json file receiving the wall/CPU time of each stage and the peak RSS",
+    )
+    parser.add_argument(
+        "--trace",
+        action="store_true",
+        help="Export a Chrome trace of the run (trace.json next to agent.log)",
+    )
+    parser.add_argument(
+        "--metrics-textfile",
+        default=None,
+        help="A Prometheus textfile periodically rewritten with the live metrics",
+    )
+    parser.add_argument(
+        "--metrics-interval",
+        type=float,
+        default=15.0,
+        help="Seconds between two rewrites of the metrics textfile",
+    )
+    parser.add_argument(
+        "--metrics-port",
+        type=int,
+        default=None,
+        help="Local port serving the live metrics on /metrics",
+    )
+    parser.add_argument(
+        "--memory-profile",
+        action="store_true",
+        help="Export the memory of each stage (memory_profile.json in the result dir)",
+    )
+    parser.add_argument(
+        "--memory-profile-top-n",
+        type=int,
+        default=10,
+        help="Number of top allocation sites reported per stage",
+    )
 
     args = parser.parse_args()
+    if args.ir_cache_size < 1:
+        parser.error("--ir-cache-size must be positive")
+    if args.compile_commands is not None and args.base_revision is not None:
+        # The database lists the files of the project, not of its checkouts
+        parser.error("--compile-commands cannot be used in the diff mode")
+    if args.workspace_projects and args.base_revision is not None:
+        parser.error("--workspace-projects cannot be used in the diff mode")
+    if args.workspace_workers is not None and args.workspace_workers < 1:
+        parser.error("--workspace-workers must be positive")
+    if (args.base_revision is None) != (args.head_revision is None):
+        parser.error("--base-revision and --head-revision must be used together")
+    if args.base_revision is not None and len(args.slice_request_path) > 1:
+        parser.error("The diff mode supports a single slice request")
+    if args.max_llm_workers < 1:
+        parser.error("--max-llm-workers must be positive")
+    if args.max_chunk_lines is not None and args.max_chunk_lines < 1:
+        parser.error("--max-chunk-lines must be positive")
     return args
 
 
 def main() -> None:
     args = configure_args()
+    set_default_log_levels(
+        getattr(logging, args.log_level), getattr(logging, args.console_log_level)
+    )
+    if args.stage_timing_output is not None:
+        STAGE_TIMER.enable()
+    if args.trace:
+        TRACER.enable()
+    if args.memory_profile:
+        MEMORY_PROFILER.enable(args.memory_profile_top_n)
+    if args.llm_record_path is not None:
+        LLM_TRACE.start_recording(args.llm_record_path)
+    if args.llm_replay_path is not None:
+        LLM_TRACE.start_replaying(args.llm_replay_path, args.llm_replay_latency)
+    if args.llm_cache_dir is not None:
+        LLM_CACHE.enable(args.llm_cache_dir)
+    metrics_exporter = MetricsExporter(
+        METRICS, args.metrics_textfile, args.metrics_interval, args.metrics_port
+    )
+    metrics_exporter.start()
+    start_wall_time = time.perf_counter()
+    start_cpu_time = time.process_time()
+
     reposlice = RepoSlice(args)
-    reposlice.run()
+    # A failed run still exports its trace, profile and timing before exiting
+    run_error: Optional[RepoSliceError] = None
+    try:
+        if args.base_revision is not None:
+            reposlice.run_diff()
+        elif reposlice.workspace_project_paths:
+            reposlice.build_workspace()
+            reposlice.run_batch()
+        elif len(reposlice.slice_requests) > 1:
+            reposlice.run_batch()
+        else:
+            reposlice.run()
+    except RepoSliceError as e:
+        run_error = e
+    finally:
+        metrics_exporter.stop()
+        LLM_TRACE.stop()
+
+    if args.trace:
+        reposlice.export_trace()
+    if args.memory_profile:
+        reposlice.export_memory_profile()
+
+    if args.stage_timing_output is not None:
+        stage_timing = {
+            "slicing_request_ids": [
+                slice_request.slicing_request_id
+                for slice_request in reposlice.slice_requests
+            ],
+            "audit_model_name": args.audit_model_name,
+            "result_dir_paths": [agent.res_dir_path for agent in reposlice.agents],
+            "wall_time": time.perf_counter() - start_wall_time,
+            "cpu_time": time.process_time() - start_cpu_time,
+            "peak_rss_bytes": get_peak_rss_bytes(),
+            "stages": STAGE_TIMER.to_dict(),
+            "llm_cache": {
+                "hit_num": LLM_CACHE.hit_num,
+                "miss_num": LLM_CACHE.miss_num,
+            },
+        }
+        with open(args.stage_timing_output, "w") as stage_timing_file:
+            json.dump(stage_timing, stage_timing_file, indent=4)
+
+    if run_error is not None:
+        print(f"Error: {run_error}", file=sys.stderr)
+        sys.exit(1)
     return
 
 
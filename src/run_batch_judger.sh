@@ -0,0 +1,78 @@
+#!/bin/bash
+
+# RepoSlice: Batch Slice Result Judger
+# This script scores all the slice results under result/SliceScanAgent against the oracle
+# in parallel, and reports per-request and overall precision, recall, F1 and cost
+
+set -e  # Exit on any error
+
+# Color codes for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+print_info() {
+    echo -e "${BLUE}ℹ️  $1${NC}"
+}
+
+print_success() {
+    echo -e "${GREEN}✅ $1${NC}"
+}
+
+print_error() {
+    echo -e "${RED}❌ $1${NC}"
+}
+
+# Function to show usage
+show_usage() {
+    echo "=========================================="
+    echo "RepoSlice: Batch Slice Result Judger"
+    echo "=========================================="
+    echo ""
+    echo "Usage: $0 [options]"
+    echo ""
+    echo "Options:"
+    echo "  --result-dir <path>       Directory containing result files (default: ../result/SliceScanAgent)"
+    echo "  --oracle-dir <path>       Directory containing oracle files (default: ../oracle)"
+    echo "  --max-workers <n>         Maximum number of worker processes (default: CPU count)"
+    echo "  --latest-only             Only judge the most recent result of each slice request"
+    echo "  --output <path>           Path to write the JSON report to"
+    echo "  --help, -h                Show this help message"
+    echo ""
+}
+
+for arg in "$@"; do
+    if [ "$arg" == "--help" ] || [ "$arg" == "-h" ]; then
+        show_usage
+        exit 0
+    fi
+done
+
+# Header
+echo "=========================================="
+echo "RepoSlice: Batch Slice Result Judger"
+echo "=========================================="
+
+# Check if conda environment should be activated
+if command -v conda &> /dev/null; then
+    print_info "Activating conda environment 'reposlice'..."
+    source "$(conda info --base)/etc/profile.d/conda.sh"
+    conda activate reposlice
+fi
+
+print_info "Starting batch judgment..."
+start_time=$(date)
+
+# Run as a module so that the utility package is importable
+if python -m utility.batch_judger "$@"; then
+    end_time=$(date)
+    echo ""
+    print_success "Batch judgment completed successfully!"
+    echo ""
+    echo "Started at:  $start_time"
+    echo "Finished at: $end_time"
+else
+    print_error "Batch judgment failed!"
+    exit 1
+fi
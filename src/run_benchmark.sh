@@ -0,0 +1,75 @@
+#!/bin/bash
+
+# RepoSlice: Stage Timing Benchmark
+# This script runs reposlice.py on the benchmark/Cpp/slice requests against the deterministic
+# mock LLM, and records the wall/CPU time of each stage and the peak RSS in a JSON report
+
+set -e  # Exit on any error
+
+# Color codes for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+print_info() {
+    echo -e "${BLUE}ℹ️  $1${NC}"
+}
+
+print_success() {
+    echo -e "${GREEN}✅ $1${NC}"
+}
+
+print_error() {
+    echo -e "${RED}❌ $1${NC}"
+}
+
+# Function to show usage
+show_usage() {
+    echo "=========================================="
+    echo "RepoSlice: Stage Timing Benchmark"
+    echo "=========================================="
+    echo ""
+    echo "Usage: $0 [slice_request_path.json ...] [options]"
+    echo ""
+    echo "Arguments:"
+    echo "  slice_request_path.json    Slice requests to run (default: ../benchmark/Cpp/slice/*.json)"
+    echo ""
+    echo "Options:"
+    echo "  --model <model_name>       Mock model: mock or mock-<latency in ms> (default: mock)"
+    echo "  --repeat <num>             Number of runs per slice request (default: 3)"
+    echo "  --call-depth <num>         Call depth (default: 10)"
+    echo "  --max-symbolic-workers <num>  Max symbolic workers (default: 10)"
+    echo "  --output <path>            Path of the JSON report (default: ../result/benchmark/stage_timing_*.json)"
+    echo "  --help, -h                 Show this help message"
+    echo ""
+}
+
+for arg in "$@"; do
+    if [ "$arg" == "--help" ] || [ "$arg" == "-h" ]; then
+        show_usage
+        exit 0
+    fi
+done
+
+# Header
+echo "=========================================="
+echo "RepoSlice: Stage Timing Benchmark"
+echo "=========================================="
+
+# Check if conda environment should be activated
+if command -v conda &> /dev/null; then
+    print_info "Activating conda environment 'reposlice'..."
+    source "$(conda info --base)/etc/profile.d/conda.sh"
+    conda activate reposlice
+fi
+
+print_info "Starting benchmark..."
+
+# Run as a module so that the utility package is importable
+if python -m utility.stage_benchmark "$@"; then
+    print_success "Benchmark completed successfully!"
+else
+    print_error "Benchmark failed!"
+    exit 1
+fi
@@ -0,0 +1,75 @@
+#!/bin/bash
+
+# RepoSlice: IR Query Microbenchmark
+# This script times the U6IR and Function query APIs on in-memory IRs of synthetic projects
+# of increasing size, and records the per-operation latencies and scaling exponents in a JSON report
+
+set -e  # Exit on any error
+
+# Color codes for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+print_info() {
+    echo -e "${BLUE}ℹ️  $1${NC}"
+}
+
+print_success() {
+    echo -e "${GREEN}✅ $1${NC}"
+}
+
+print_error() {
+    echo -e "${RED}❌ $1${NC}"
+}
+
+# Function to show usage
+show_usage() {
+    echo "=========================================="
+    echo "RepoSlice: IR Query Microbenchmark"
+    echo "=========================================="
+    echo ""
+    echo "Usage: $0 [options]"
+    echo ""
+    echo "Options:"
+    echo "  --sizes <num> ...          Sizes of the generated IRs (default: 100 300 1000 3000)"
+    echo "  --dimension <dimension>    Scale the number of functions or their length: functions or length (default: functions)"
+    echo "  --functions <num>          Number of functions when scaling the length (default: 1000)"
+    echo "  --function-length <num>    Lines per function when scaling the functions (default: 30)"
+    echo "  --samples <num>            Inputs per operation and size (default: 200)"
+    echo "  --repeat <num>             Timed passes per operation and size (default: 5)"
+    echo "  --baseline <path>          Previous report to compare the latencies with"
+    echo "  --output <path>            Path of the JSON report (default: ../result/benchmark/ir_benchmark_*.json)"
+    echo "  --help, -h                 Show this help message"
+    echo ""
+}
+
+for arg in "$@"; do
+    if [ "$arg" == "--help" ] || [ "$arg" == "-h" ]; then
+        show_usage
+        exit 0
+    fi
+done
+
+# Header
+echo "=========================================="
+echo "RepoSlice: IR Query Microbenchmark"
+echo "=========================================="
+
+# Check if conda environment should be activated
+if command -v conda &> /dev/null; then
+    print_info "Activating conda environment 'reposlice'..."
+    source "$(conda info --base)/etc/profile.d/conda.sh"
+    conda activate reposlice
+fi
+
+print_info "Starting benchmark..."
+
+# Run as a module so that the utility package is importable
+if python -m utility.ir_benchmark "$@"; then
+    print_success "Benchmark completed successfully!"
+else
+    print_error "Benchmark failed!"
+    exit 1
+fi
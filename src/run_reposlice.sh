@@ -139,7 +139,7 @@ echo ""
 
 # Extract request info for display
 if command -v jq &> /dev/null; then
-    SEED_NAME=$(jq -r '.seed_name' "$SLICE_REQUEST_PATH" 2>/dev/null || echo "unknown")
+    SEED_NAME=$(jq -r '.seed_name // ([.seeds[].seed_name] | join(", "))' "$SLICE_REQUEST_PATH" 2>/dev/null || echo "unknown")
     IS_BACKWARD=$(jq -r '.is_backward' "$SLICE_REQUEST_PATH" 2>/dev/null || echo "unknown")
     SLICE_TYPE=$([ "$IS_BACKWARD" = "true" ] && echo "Backward" || echo "Forward")
     print_info "Slice type: $SLICE_TYPE slice for variable '$SEED_NAME'"
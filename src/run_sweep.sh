@@ -0,0 +1,81 @@
+#!/bin/bash
+
+# RepoSlice: Accuracy-vs-Cost Sweep
+# This script runs a grid of slicing configurations on the benchmark/Cpp/slice requests, scores
+# them with the judger, and reports the Pareto frontier of F1 against tokens, dollars and wall time
+
+set -e  # Exit on any error
+
+# Color codes for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+print_info() {
+    echo -e "${BLUE}ℹ️  $1${NC}"
+}
+
+print_success() {
+    echo -e "${GREEN}✅ $1${NC}"
+}
+
+print_error() {
+    echo -e "${RED}❌ $1${NC}"
+}
+
+# Function to show usage
+show_usage() {
+    echo "=========================================="
+    echo "RepoSlice: Accuracy-vs-Cost Sweep"
+    echo "=========================================="
+    echo ""
+    echo "Usage: $0 [slice_request_path.json ...] [options]"
+    echo ""
+    echo "Arguments:"
+    echo "  slice_request_path.json    Slice requests to run (default: the ../benchmark/Cpp/slice/*.json ones with an oracle)"
+    echo ""
+    echo "Options:"
+    echo "  --models <name ...>        Models to sweep (default: mock)"
+    echo "  --temperatures <t ...>     Temperatures to sweep (default: 0.0)"
+    echo "  --max-query-nums <n ...>   Maximum query numbers to sweep (default: 3)"
+    echo "  --call-depths <n ...>      Call depths to sweep (default: 3)"
+    echo "  --prompt-dirs <path ...>   Prompt template directories to sweep (default: default)"
+    echo "  --trace-dir <path>         Directory of the cached LLM traces (default: ../result/sweep/llm_traces)"
+    echo "  --no-cache                 Query the LLMs for every configuration"
+    echo "  --simulate-latency         Wait for the recorded latency of the cached answers"
+    echo "  --price-file <path>        JSON file of model prices in USD per million tokens"
+    echo "  --min-f1 <f1>              Select the cheapest configuration with at least this F1"
+    echo "  --output <path>            Path of the JSON report (default: ../result/sweep/sweep_*.json)"
+    echo "  --help, -h                 Show this help message"
+    echo ""
+}
+
+for arg in "$@"; do
+    if [ "$arg" == "--help" ] || [ "$arg" == "-h" ]; then
+        show_usage
+        exit 0
+    fi
+done
+
+# Header
+echo "=========================================="
+echo "RepoSlice: Accuracy-vs-Cost Sweep"
+echo "=========================================="
+
+# Check if conda environment should be activated
+if command -v conda &> /dev/null; then
+    print_info "Activating conda environment 'reposlice'..."
+    source "$(conda info --base)/etc/profile.d/conda.sh"
+    conda activate reposlice
+fi
+
+print_info "Starting sweep..."
+
+# Run as a module so that the utility package is importable
+if python -m utility.sweep "$@"; then
+    print_success "Sweep completed successfully!"
+else
+    print_error "Sweep failed!"
+    exit 1
+fi
@@ -5,8 +5,14 @@ import tree_sitter
 
 from .TS_analyzer import *
 from memory.utils.function import *
+from memory.utils.identifier_index import IdentifierRole
 from memory.utils.value import *
 
+# The models of the C standard library APIs
+DEFAULT_API_MODEL_PATH = str(
+    Path(__file__).resolve().parents[2] / "api_model" / "Cpp" / "libc.json"
+)
+
 
 class Cpp_TSAnalyzer(TSAnalyzer):
     """TSAnalyzer for C/C++ source files using tree-sitter.
@@ -20,8 +26,22 @@ class Cpp_TSAnalyzer(TSAnalyzer):
         code_in_files: Dict[str, str],
         language_name: str,
         max_symbolic_workers_num=10,
+        ir_store_path: Optional[str] = None,
+        ir_cache_size: int = DEFAULT_FUNCTION_CACHE_SIZE,
+        file_scopes: Optional[Dict[str, Set[str]]] = None,
+        api_models: Optional[Dict[str, APIModel]] = None,
     ) -> None:
-        super().__init__(code_in_files, language_name, max_symbolic_workers_num)
+        if api_models is None:
+            api_models = load_api_models([DEFAULT_API_MODEL_PATH])
+        super().__init__(
+            code_in_files,
+            language_name,
+            max_symbolic_workers_num,
+            ir_store_path,
+            ir_cache_size,
+            file_scopes,
+            api_models,
+        )
 
     def _extract_function_raw_info(
         self, file_path: str, source_code: str, tree: tree_sitter.Tree
@@ -228,6 +248,90 @@ class Cpp_TSAnalyzer(TSAnalyzer):
                 )
             )
 
+    def _extract_identifier_occurrences(self, current_function: Function) -> None:
+        """Index the occurrences of the identifiers in a function by their roles.
+
+        Args:
+            current_function: Function to analyze
+        """
+        root_node = current_function.parse_tree_root_node
+        root_line = root_node.start_point[0]
+        for id_node in self.u6ir.find_nodes_by_type(root_node, "identifier"):
+            role = self._get_identifier_role(id_node)
+            if role is None:
+                continue
+            current_function.identifier_index.add(
+                id_node.text.decode("utf-8"),
+                id_node.start_point[0] - root_line + 1,
+                id_node.start_byte - root_node.start_byte,
+                id_node.end_byte - root_node.start_byte,
+                role,
+            )
+
+    def _get_identifier_role(
+        self, id_node: tree_sitter.Node
+    ) -> Optional[IdentifierRole]:
+        """Get the role of an identifier from its closest enclosing construct.
+
+        Args:
+            id_node: Identifier node
+
+        Returns:
+            The role, or None if the identifier names a function rather than a
+            variable (the callee of a call or the defined function)
+        """
+        child = id_node
+        parent = id_node.parent
+        # Whether the identifier is the base of the expression, e.g., a in a[i],
+        # rather than i, which is only read
+        is_base = True
+        while parent is not None:
+            if parent.type == "call_expression" and child == parent.child_by_field_name(
+                "function"
+            ):
+                return None if child == id_node else IdentifierRole.USE
+            if (
+                parent.type == "function_declarator"
+                and child == parent.child_by_field_name("declarator")
+                and parent.parent is not None
+                and parent.parent.type in ("function_definition", "pointer_declarator")
+            ):
+                return None
+            if parent.type == "parameter_declaration":
+                return IdentifierRole.PARA
+            if parent.type == "init_declarator":
+                if child == parent.child_by_field_name("declarator"):
+                    return IdentifierRole.DEF
+                return IdentifierRole.USE
+            if parent.type == "declaration":
+                return IdentifierRole.DEF
+            if parent.type == "assignment_expression" and child == (
+                parent.child_by_field_name("left")
+            ):
+                return IdentifierRole.DEF if is_base else IdentifierRole.USE
+            if parent.type == "update_expression":
+                return IdentifierRole.DEF if is_base else IdentifierRole.USE
+            if parent.type == "argument_list":
+                return IdentifierRole.ARG
+            if parent.type == "return_statement":
+                return IdentifierRole.RET
+            if parent.type == "subscript_expression" and child != (
+                parent.child_by_field_name("argument")
+            ):
+                is_base = False
+            if parent.type == "array_declarator" and child != (
+                parent.child_by_field_name("declarator")
+            ):
+                return IdentifierRole.USE
+            if parent.type.endswith("_statement") or parent.type in (
+                "function_definition",
+                "condition_clause",
+            ):
+                break
+            child = parent
+            parent = parent.parent
+        return IdentifierRole.USE
+
     def _extract_arguments_in_single_function_at_callsite(
         self,
         current_function: Function,
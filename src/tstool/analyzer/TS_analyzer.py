@@ -7,6 +7,8 @@ from abc import ABC, abstractmethod
 from enum import Enum
 from pathlib import Path
 import concurrent.futures
+import os
+import re
 import sys
 import threading
 from typing import Dict, List, Optional, Set, Tuple
@@ -18,6 +20,60 @@ from memory.utils.function import *
 from memory.utils.api import *
 from memory.utils.value import *
 from memory.IR.U6IR import *
+from utility.metrics import METRICS
+from utility.pipeline_stage import pipeline_stage
+
+PARSED_FILES = METRICS.counter("reposlice_parsed_files_total", "Source files parsed")
+ANALYZED_FUNCTIONS = METRICS.counter(
+    "reposlice_analyzed_functions_total", "Functions analyzed after parsing"
+)
+PARSE_THROUGHPUT = METRICS.gauge(
+    "reposlice_parse_throughput_per_second",
+    "Throughput of the last parsing stage (files or functions per second)",
+    ["stage"],
+)
+
+# Matches the code of a function definition with internal linkage
+STATIC_FUNCTION_PATTERN = re.compile(r"(?:\w+\s+)*?static\b")
+
+# Maps the language names to the names of their tree-sitter grammars
+GRAMMAR_NAMES = {
+    "C": "c",
+    "Cpp": "cpp",
+    "Java": "java",
+    "Python": "python",
+    "Go": "go",
+}
+
+# The grammars loaded by the process, shared by all its analyzers
+_languages: Dict[str, Language] = {}
+_languages_lock = threading.Lock()
+
+
+def get_language(language_name: str) -> Language:
+    """
+    Get the tree-sitter grammar of a language, loading it on the first call.
+
+    Args:
+        language_name: Programming language name
+
+    Returns:
+        The grammar of the language
+
+    Raises:
+        RAValueError: If the language is not supported
+    """
+    if language_name not in GRAMMAR_NAMES:
+        raise RAValueError("Invalid language setting")
+    with _languages_lock:
+        if language_name not in _languages:
+            language_path = (
+                Path(__file__).resolve().parent / "../../../lib/build/my-languages.so"
+            )
+            _languages[language_name] = Language(
+                str(language_path), GRAMMAR_NAMES[language_name]
+            )
+        return _languages[language_name]
 
 
 class TSAnalyzer(ABC):
@@ -31,6 +87,10 @@ class TSAnalyzer(ABC):
         code_in_files: Dict[str, str],
         language_name: str,
         max_symbolic_workers_num=10,
+        ir_store_path: Optional[str] = None,
+        ir_cache_size: int = DEFAULT_FUNCTION_CACHE_SIZE,
+        file_scopes: Optional[Dict[str, Set[str]]] = None,
+        api_models: Optional[Dict[str, APIModel]] = None,
     ) -> None:
         """
         Initialize the analyzer with source code and configuration.
@@ -39,29 +99,30 @@ class TSAnalyzer(ABC):
             code_in_files: Dict mapping file paths to source contents
             language_name: Programming language name
             max_symbolic_workers_num: Max parallel workers for analysis
+            ir_store_path: Path of the database the analyzed U6IR is offloaded
+                to, or None to keep it in memory. An existing database is loaded
+                instead of analyzing the files, so the path must identify the
+                sources (see get_snapshot_key).
+            ir_cache_size: Maximum number of functions of an offloaded U6IR kept
+                in memory
+            file_scopes: Maps each file to the files it includes transitively and
+                itself (see utility/include_graph.py), to resolve the calls to
+                the visible definitions, or None to resolve them project-wide
+            api_models: Maps the names of the library APIs to their models, which
+                are attached to the APIs of the U6IR
         """
         self.code_in_files = code_in_files
-        cwd = Path(__file__).resolve().parent.absolute()
-        TSPATH = cwd / "../../../lib/build/"
-        language_path = TSPATH / "my-languages.so"
+        self.file_scopes = file_scopes
+        self.api_models = api_models if api_models is not None else {}
+        self.ir_store_path = ir_store_path
+        self.ir_cache_size = ir_cache_size
         self.max_symbolic_workers_num = max_symbolic_workers_num
         self.u6ir = U6IR(code_in_files)
 
         # Initialize tree-sitter parser
         self.parser = Parser()
         self.language_name = language_name
-        if language_name == "C":
-            self.language = Language(str(language_path), "c")
-        elif language_name == "Cpp":
-            self.language = Language(str(language_path), "cpp")
-        elif language_name == "Java":
-            self.language = Language(str(language_path), "java")
-        elif language_name == "Python":
-            self.language = Language(str(language_path), "python")
-        elif language_name == "Go":
-            self.language = Language(str(language_path), "go")
-        else:
-            raise RAValueError("Invalid language setting")
+        self.language = get_language(language_name)
         self.parser.set_language(self.language)
 
     def run(self) -> U6IR:
@@ -71,8 +132,19 @@ class TSAnalyzer(ABC):
         Returns:
             U6IR: The U6IR object containing the analysis results
         """
+        if self.ir_store_path is not None and os.path.exists(self.ir_store_path):
+            # The snapshot of the same sources written by an earlier run
+            with pipeline_stage("load_ir", "analyzer", self.u6ir):
+                self.u6ir.load(self.ir_store_path, self.ir_cache_size)
+                self.u6ir.attach_api_models(self.api_models)
+            return self.u6ir
         self._parse_project()
-        self._analyze_call_graph()
+        with pipeline_stage("analyze_call_graph", "analyzer", self.u6ir):
+            self._analyze_call_graph()
+            self.u6ir.attach_api_models(self.api_models)
+        if self.ir_store_path is not None:
+            with pipeline_stage("offload_ir", "analyzer", self.u6ir):
+                self.u6ir.offload(self.ir_store_path, self.ir_cache_size)
         return self.u6ir
 
     ##################################################
@@ -153,6 +225,7 @@ class TSAnalyzer(ABC):
                 for future in concurrent.futures.as_completed(futures):
                     file_path, source = future.result()
                     self.u6ir.fileContentDic[file_path] = source
+                    PARSED_FILES.inc()
                     pbar.update(1)
                 pbar.close()
 
@@ -173,11 +246,23 @@ class TSAnalyzer(ABC):
                 for future in concurrent.futures.as_completed(futures):
                     func_id, current_function = future.result()
                     self.u6ir.function_env[func_id] = current_function
+                    ANALYZED_FUNCTIONS.inc()
                     pbar.update(1)
                 pbar.close()
 
-        parse_files()
-        parse_functions()
+        with pipeline_stage(
+            "parse_files", "analyzer", file_num=len(self.code_in_files)
+        ) as stage:
+            parse_files()
+        PARSE_THROUGHPUT.labels("parse_files").set(
+            len(self.u6ir.fileContentDic) / max(stage.wall_time, 1e-9)
+        )
+
+        with pipeline_stage("parse_functions", "analyzer", self.u6ir) as stage:
+            parse_functions()
+        PARSE_THROUGHPUT.labels("parse_functions").set(
+            len(self.u6ir.function_env) / max(stage.wall_time, 1e-9)
+        )
         return
 
     def _analyze_call_graph(self) -> None:
@@ -232,6 +317,7 @@ class TSAnalyzer(ABC):
 
         self._extract_parameters_in_single_function(current_function)
         self._extract_return_values_in_single_function(current_function)
+        self._extract_identifier_occurrences(current_function)
         self._extract_if_statements(current_function, file_content)
         self._extract_loop_statements(current_function, file_content)
         return current_function
@@ -477,7 +563,41 @@ class TSAnalyzer(ABC):
             else:
                 if len(callee_paras) <= len(arguments):
                     callee_ids.append(callee_id)
-        return callee_ids
+        return self._scope_callee_ids(current_function, callee_ids)
+
+    def _scope_callee_ids(
+        self, current_function: Function, callee_ids: List[int]
+    ) -> List[int]:
+        """
+        Narrow the candidate callees of a call to the definitions it can reach.
+
+        A definition in the file of the caller or in a header it includes shadows
+        the other candidates. Otherwise, the static functions of the other files
+        are not visible to the caller and are dropped.
+
+        Args:
+            current_function: Function containing the call
+            callee_ids: IDs of the candidate callees
+
+        Returns:
+            IDs of the callees kept
+        """
+        if self.file_scopes is None or len(callee_ids) == 0:
+            return callee_ids
+        scope = self.file_scopes.get(
+            current_function.file_path, {current_function.file_path}
+        )
+        callees = [self.u6ir.function_env[callee_id] for callee_id in callee_ids]
+        visible_callee_ids = [
+            callee.function_id for callee in callees if callee.file_path in scope
+        ]
+        if visible_callee_ids:
+            return visible_callee_ids
+        return [
+            callee.function_id
+            for callee in callees
+            if not STATIC_FUNCTION_PATTERN.match(callee.function_code)
+        ]
 
     ############################################################
     #   Helper functions for para/arg/out/ret value extraction #
@@ -572,6 +692,16 @@ class TSAnalyzer(ABC):
     #        Extractors of branches and loops           #
     # (Only used by the TSAnalyzer class/subclasses)    #
     #####################################################
+    @abstractmethod
+    def _extract_identifier_occurrences(self, current_function: Function) -> None:
+        """
+        Index the occurrences of the identifiers in a function by their roles.
+
+        Args:
+            current_function: Function to analyze
+        """
+        pass
+
     @abstractmethod
     def _extract_if_statements(self, function: Function, source_code: str) -> None:
         """
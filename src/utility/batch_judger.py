@@ -0,0 +1,266 @@
+"""Batch judger scoring all the slice results against the oracle in parallel."""
+
+import json
+import os
+import re
+import sys
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+from utility.judger import judge_slice_result, load_json_file
+
+BASE_PATH = Path(__file__).resolve().parents[2]
+
+SLICE_INFO_PATTERN = re.compile(r"^slice_info_(?P<slice_request_id>.+)\.json$")
+
+
+def discover_result_files(
+    result_dir: str, oracle_dir: str, latest_only: bool = False
+) -> Tuple[List[Tuple[str, str]], List[str]]:
+    """Discover the slice result files and match them to the oracle files.
+
+    Result files are named slice_info_<slice_request_id>.json and matched to
+    <oracle_dir>/<slice_request_id>.json.
+
+    Args:
+        result_dir: Directory searched recursively for result files
+        oracle_dir: Directory containing oracle files
+        latest_only: Keep only the most recent result file of each request
+
+    Returns:
+        Tuple of (list of (slice_request_id, result_json_path) pairs with an oracle,
+        list of result files without an oracle)
+    """
+    matched: Dict[str, List[str]] = {}
+    unmatched: List[str] = []
+    for result_path in sorted(Path(result_dir).rglob("slice_info_*.json")):
+        match = SLICE_INFO_PATTERN.match(result_path.name)
+        if match is None:
+            continue
+        slice_request_id = match.group("slice_request_id")
+        if not (Path(oracle_dir) / f"{slice_request_id}.json").exists():
+            unmatched.append(str(result_path))
+            continue
+        matched.setdefault(slice_request_id, []).append(str(result_path))
+
+    result_files: List[Tuple[str, str]] = []
+    for slice_request_id in sorted(matched):
+        result_paths = sorted(matched[slice_request_id], key=os.path.getmtime)
+        if latest_only:
+            result_paths = result_paths[-1:]
+        for result_path in result_paths:
+            result_files.append((slice_request_id, result_path))
+    return result_files, unmatched
+
+
+def judge_run(slice_request_id: str, result_json_path: str, oracle_dir: str) -> Dict:
+    """Score one result file and collect the cost recorded by the agent.
+
+    Args:
+        slice_request_id: The ID of the slice request
+        result_json_path: Path to the result JSON file
+        oracle_dir: Directory containing oracle files
+
+    Returns:
+        Dictionary containing the overall metrics and the cost of the run
+    """
+    judgment = judge_slice_result(slice_request_id, result_json_path, oracle_dir)
+    cost = load_json_file(result_json_path).get("cost", {})
+    return {
+        "slice_request_id": slice_request_id,
+        "result_json_path": result_json_path,
+        "metrics": judgment["overall_metrics"],
+        "is_truncated": judgment["is_truncated"],
+        "cost": cost,
+    }
+
+
+def compute_metrics(tp: int, fp: int, fn: int) -> Dict:
+    """Compute precision, recall and F1 score from the confusion counts.
+
+    Args:
+        tp: Number of true positives
+        fp: Number of false positives
+        fn: Number of false negatives
+
+    Returns:
+        Dictionary containing the counts, precision, recall and f1_score
+    """
+    precision = tp / (tp + fp) if (tp + fp) > 0 else 0.0
+    recall = tp / (tp + fn) if (tp + fn) > 0 else 0.0
+    f1 = (
+        2 * precision * recall / (precision + recall)
+        if (precision + recall) > 0
+        else 0.0
+    )
+    return {
+        "true_positives": tp,
+        "false_positives": fp,
+        "false_negatives": fn,
+        "precision": precision,
+        "recall": recall,
+        "f1_score": f1,
+    }
+
+
+def aggregate_runs(runs: List[Dict]) -> Dict:
+    """Aggregate the judged runs into per-request and overall reports.
+
+    The overall precision/recall/F1 are micro-averaged over the confusion counts of
+    all the runs; macro_f1_score is the mean F1 score of the runs.
+
+    Args:
+        runs: Judged runs returned by judge_run
+
+    Returns:
+        Dictionary containing the per-request and overall metrics and costs
+    """
+    cost_keys = ["input_token_cost", "output_token_cost", "llm_query_num", "wall_time"]
+
+    def summarize(group: List[Dict]) -> Dict:
+        counts = [
+            sum(run["metrics"][key] for run in group)
+            for key in ["true_positives", "false_positives", "false_negatives"]
+        ]
+        summary = compute_metrics(*counts)
+        summary["macro_f1_score"] = (
+            sum(run["metrics"]["f1_score"] for run in group) / len(group)
+            if group
+            else 0.0
+        )
+        summary["run_num"] = len(group)
+        summary["cost"] = {
+            key: sum(run["cost"].get(key, 0) for run in group) for key in cost_keys
+        }
+        return summary
+
+    runs_by_request: Dict[str, List[Dict]] = {}
+    for run in runs:
+        runs_by_request.setdefault(run["slice_request_id"], []).append(run)
+
+    return {
+        "overall": summarize(runs),
+        "requests": {
+            slice_request_id: summarize(request_runs)
+            for slice_request_id, request_runs in sorted(runs_by_request.items())
+        },
+        "runs": runs,
+    }
+
+
+def judge_all(
+    result_dir: str,
+    oracle_dir: str,
+    max_workers: Optional[int] = None,
+    latest_only: bool = False,
+) -> Dict:
+    """Score all the result files under a directory in parallel.
+
+    Args:
+        result_dir: Directory searched recursively for result files
+        oracle_dir: Directory containing oracle files
+        max_workers: Maximum number of worker processes (default: CPU count)
+        latest_only: Keep only the most recent result file of each request
+
+    Returns:
+        Aggregate report of all the runs (see aggregate_runs), together with the
+        result files without an oracle and the runs that failed to be judged
+    """
+    result_files, unmatched = discover_result_files(
+        result_dir, oracle_dir, latest_only
+    )
+
+    runs: List[Dict] = []
+    errors: Dict[str, str] = {}
+    with ProcessPoolExecutor(max_workers=max_workers) as executor:
+        futures = [
+            executor.submit(judge_run, slice_request_id, result_path, oracle_dir)
+            for slice_request_id, result_path in result_files
+        ]
+        for (_, result_path), future in zip(result_files, futures):
+            try:
+                runs.append(future.result())
+            except (OSError, KeyError, ValueError) as e:
+                errors[result_path] = str(e)
+
+    report = aggregate_runs(runs)
+    report["unmatched_result_files"] = unmatched
+    report["errors"] = errors
+    return report
+
+
+def main():
+    """Main function for command-line usage."""
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        description="Compare all slice results with oracle data in parallel"
+    )
+    parser.add_argument(
+        "--result-dir",
+        type=str,
+        default=str(BASE_PATH / "result" / "SliceScanAgent"),
+        help="Directory containing result files (default: result/SliceScanAgent)",
+    )
+    parser.add_argument(
+        "--oracle-dir",
+        type=str,
+        default=str(BASE_PATH / "oracle"),
+        help="Directory containing oracle files (default: oracle/ in project root)",
+    )
+    parser.add_argument(
+        "--max-workers",
+        type=int,
+        default=None,
+        help="Maximum number of worker processes (default: CPU count)",
+    )
+    parser.add_argument(
+        "--latest-only",
+        action="store_true",
+        help="Only judge the most recent result file of each slice request",
+    )
+    parser.add_argument(
+        "--output", type=str, default=None, help="Path to write the JSON report to"
+    )
+
+    args = parser.parse_args()
+
+    try:
+        report = judge_all(
+            args.result_dir, args.oracle_dir, args.max_workers, args.latest_only
+        )
+    except Exception as e:
+        print(f"Error: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    # Print the summary table
+    print(
+        f"{'slice_request_id':<32} {'runs':>4} {'P':>6} {'R':>6} {'F1':>6} "
+        f"{'queries':>8} {'tokens':>10} {'time(s)':>8}"
+    )
+    for name, summary in list(report["requests"].items()) + [
+        ("OVERALL", report["overall"])
+    ]:
+        cost = summary["cost"]
+        print(
+            f"{name:<32} {summary['run_num']:>4} {summary['precision']:>6.3f} "
+            f"{summary['recall']:>6.3f} {summary['f1_score']:>6.3f} "
+            f"{cost['llm_query_num']:>8} "
+            f"{cost['input_token_cost'] + cost['output_token_cost']:>10} "
+            f"{cost['wall_time']:>8.1f}"
+        )
+
+    if args.output is not None:
+        with open(args.output, "w", encoding="utf-8") as f:
+            json.dump(report, f, indent=2)
+        print(f"The report is saved in {args.output}")
+    else:
+        print(json.dumps(report, indent=2))
+
+    if report["errors"]:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,248 @@
+"""Call neighborhood of the seeds of a slice request, found by a lexical scan.
+
+A slice reaches the functions within call_depth calls of its seeds, in both
+directions: the callers through the parameters and return values, and the
+callees through the arguments and output values. The diff mode analyzes only
+the files of this neighborhood in each revision, so the cost of its analysis
+grows with the neighborhood of the seeds rather than with the whole project.
+
+The scan blanks the comments, literals and preprocessor lines of each file, and
+finds the function definitions at its top level and the names called in their
+bodies. It over-approximates the call graph of the analyzer: a call is linked to
+every definition of the callee name. A file is kept if it mentions a call of a
+function of the neighborhood, which covers its definitions, its declarations and
+its call sites alike. A definition the scan misses (e.g., one whose signature is
+expanded from a macro) is not followed to its callees, and a seed outside of any
+function the scan finds is not restricted at all.
+"""
+
+import os
+import re
+from bisect import bisect_right
+from typing import Dict, List, Optional, Set, Tuple
+
+# Matches the comments and the string and character literals
+COMMENT_OR_LITERAL_PATTERN = re.compile(
+    r"//[^\n]*|/\*.*?\*/|\"(?:\\.|[^\"\\\n])*\"|'(?:\\.|[^'\\\n])*'", re.DOTALL
+)
+# Matches the preprocessor lines, including their continuation lines
+PREPROCESSOR_PATTERN = re.compile(r"^[ \t]*#(?:[^\n]*\\\n)*[^\n]*", re.MULTILINE)
+# Matches a name followed by an opening parenthesis, i.e., a call or a signature
+CALL_PATTERN = re.compile(r"\b([A-Za-z_]\w*)\s*\(")
+# Matches the text between the parameters of a definition and its body
+SIGNATURE_END_PATTERN = re.compile(r"^(?:\s|\bconst\b|\bnoexcept\b|\boverride\b)*$")
+# Matches the braces that do not open a scope of definitions, e.g., namespace
+TRANSPARENT_SCOPE_PATTERN = re.compile(r"(?:\bnamespace\b[\w\s:]*|\bextern\s*)$")
+# Names followed by a parenthesis that are neither calls nor definitions
+NON_CALL_NAMES = {
+    "if",
+    "for",
+    "while",
+    "switch",
+    "return",
+    "sizeof",
+    "alignof",
+    "_Alignof",
+    "defined",
+    "__attribute__",
+    "decltype",
+    "typeof",
+    "__typeof__",
+}
+
+
+class ScannedFunction:
+    """Function definition found by the lexical scan."""
+
+    def __init__(
+        self, name: str, start_line: int, end_line: int, called_names: Set[str]
+    ) -> None:
+        """Initialize a scanned function.
+
+        Args:
+            name: Name of the function
+            start_line: First line of the definition in the file
+            end_line: Last line of the definition in the file
+            called_names: Names called in the body of the function
+        """
+        self.name = name
+        self.start_line = start_line
+        self.end_line = end_line
+        self.called_names = called_names
+
+
+def blank_non_code(source_code: str) -> str:
+    """Replace the comments, literals and preprocessor lines by spaces.
+
+    The newlines are kept, so the offsets and line numbers are unchanged.
+    """
+
+    def blank(match: "re.Match[str]") -> str:
+        return re.sub(r"[^\n]", " ", match.group(0))
+
+    return PREPROCESSOR_PATTERN.sub(
+        blank, COMMENT_OR_LITERAL_PATTERN.sub(blank, source_code)
+    )
+
+
+def get_called_names(code: str) -> Set[str]:
+    """Get the names followed by a parenthesis in blanked code."""
+    return set(CALL_PATTERN.findall(code)) - NON_CALL_NAMES
+
+
+def get_defined_name(signature: str) -> Optional[str]:
+    """Get the name of the function whose signature precedes a body, if any.
+
+    Args:
+        signature: Blanked code between the previous top-level declaration and
+            the opening brace of the body
+
+    Returns:
+        The name whose parameter list ends the signature, or None if the body is
+        not the body of a function (e.g., of a struct or an initializer)
+    """
+    for match in CALL_PATTERN.finditer(signature):
+        if match.group(1) in NON_CALL_NAMES:
+            continue
+        depth = 0
+        for i in range(match.end() - 1, len(signature)):
+            if signature[i] == "(":
+                depth += 1
+            elif signature[i] == ")":
+                depth -= 1
+                if depth == 0:
+                    if SIGNATURE_END_PATTERN.match(signature[i + 1 :]):
+                        return match.group(1)
+                    break
+    return None
+
+
+def scan_functions(code: str) -> List[ScannedFunction]:
+    """Find the function definitions at the top level of a file.
+
+    Args:
+        code: Content of the file blanked by blank_non_code
+
+    Returns:
+        The definitions found, in order
+    """
+    newline_offsets = [match.start() for match in re.finditer("\n", code)]
+
+    def get_line(offset: int) -> int:
+        return bisect_right(newline_offsets, offset - 1) + 1
+
+    functions: List[ScannedFunction] = []
+    # One flag per open brace: whether it opens a scope of definitions
+    brace_stack: List[bool] = []
+    depth = 0
+    # Start of the code since the last top-level declaration
+    segment_start = 0
+    name: Optional[str] = None
+    header_start = body_start = 0
+    for match in re.finditer(r"[{};]", code):
+        offset = match.start()
+        char = match.group(0)
+        if char == "{":
+            if depth == 0:
+                segment = code[segment_start:offset]
+                if TRANSPARENT_SCOPE_PATTERN.search(segment):
+                    brace_stack.append(False)
+                    segment_start = offset + 1
+                    continue
+                name = get_defined_name(segment)
+                header_start = segment_start + len(segment) - len(segment.lstrip())
+                body_start = offset
+            brace_stack.append(True)
+            depth += 1
+        elif char == "}":
+            if not brace_stack:
+                continue
+            if not brace_stack.pop():
+                segment_start = offset + 1
+                continue
+            depth -= 1
+            if depth == 0:
+                if name is not None:
+                    functions.append(
+                        ScannedFunction(
+                            name,
+                            get_line(header_start),
+                            get_line(offset),
+                            get_called_names(code[body_start:offset]),
+                        )
+                    )
+                name = None
+                segment_start = offset + 1
+        elif depth == 0:
+            segment_start = offset + 1
+    return functions
+
+
+def get_call_neighborhood_files(
+    code_in_files: Dict[str, str],
+    seed_locations: List[Tuple[str, int]],
+    call_depth: int,
+) -> Optional[Set[str]]:
+    """Get the files of the functions within call_depth calls of the seeds.
+
+    Args:
+        code_in_files: Dictionary mapping the file paths to their contents
+        seed_locations: Pairs of the file path and the line number of each seed
+        call_depth: Maximum number of calls between a seed and a function
+
+    Returns:
+        The paths of the files mentioning a call of a function of the
+        neighborhood, or None if a seed is outside of the functions found
+    """
+    blanked_code_in_files = {
+        file_path: blank_non_code(source_code)
+        for file_path, source_code in code_in_files.items()
+    }
+    functions_by_file = {
+        file_path: scan_functions(code)
+        for file_path, code in blanked_code_in_files.items()
+    }
+    # Maps function names -> their definitions
+    definitions: Dict[str, List[ScannedFunction]] = {}
+    # Maps function names -> names of the functions calling them
+    caller_names: Dict[str, Set[str]] = {}
+    for functions in functions_by_file.values():
+        for function in functions:
+            definitions.setdefault(function.name, []).append(function)
+            for called_name in function.called_names:
+                caller_names.setdefault(called_name, set()).add(function.name)
+
+    real_file_paths = {
+        os.path.realpath(file_path): file_path for file_path in code_in_files
+    }
+    neighborhood_names: Set[str] = set()
+    for seed_file_path, seed_line_number in seed_locations:
+        file_path = real_file_paths.get(os.path.realpath(seed_file_path))
+        seed_functions = [
+            function
+            for function in functions_by_file.get(file_path, [])
+            if function.start_line <= seed_line_number <= function.end_line
+        ]
+        if len(seed_functions) == 0:
+            return None
+        neighborhood_names.update(function.name for function in seed_functions)
+
+    frontier = set(neighborhood_names)
+    for _ in range(call_depth):
+        next_frontier: Set[str] = set()
+        for name in frontier:
+            for function in definitions.get(name, []):
+                next_frontier.update(
+                    called_name
+                    for called_name in function.called_names
+                    if called_name in definitions
+                )
+            next_frontier.update(caller_names.get(name, set()))
+        frontier = next_frontier - neighborhood_names
+        neighborhood_names.update(frontier)
+
+    return {
+        file_path
+        for file_path, code in blanked_code_in_files.items()
+        if not get_called_names(code).isdisjoint(neighborhood_names)
+    }
@@ -0,0 +1,150 @@
+"""Source file set of a project derived from its compile_commands.json.
+
+A compilation database lists the translation units (TUs) of a build with their
+compiler arguments. Only those TUs, and the project headers they include, are
+analyzed, instead of every source file under the project: dead, test and
+platform-specific files outside the build are skipped, and their same-named
+functions no longer make the callee resolution ambiguous.
+
+The included headers are found with the include directories of the TUs, and the
+scope of each file is returned along with it (see utility/include_graph.py).
+"""
+
+import json
+import os
+import shlex
+from collections import deque
+from typing import Dict, List, Optional, Set, Tuple
+
+from utility.errors import RAValueError
+from utility.include_graph import IncludeGraph, is_in_project
+
+# Compiler options followed by an include directory, either attached (-Idir) or
+# as the next argument (-I dir)
+INCLUDE_DIR_OPTIONS = ["-I", "-iquote", "-isystem", "-idirafter"]
+
+
+class CompileCommand:
+    """Entry of a compilation database."""
+
+    def __init__(self, file_path: str, directory: str, arguments: List[str]) -> None:
+        """Initialize a compile command.
+
+        Args:
+            file_path: Absolute normalized path of the TU
+            directory: Working directory of the compiler
+            arguments: Compiler arguments
+        """
+        self.file_path = file_path
+        self.directory = directory
+        self.arguments = arguments
+
+    def include_dirs(self) -> List[str]:
+        """Get the include directories of the command, in search order.
+
+        Returns:
+            Absolute normalized paths of the include directories
+        """
+        include_dirs: List[str] = []
+        arguments = iter(self.arguments)
+        for argument in arguments:
+            for option in INCLUDE_DIR_OPTIONS:
+                if not argument.startswith(option):
+                    continue
+                include_dir = argument[len(option) :] or next(arguments, "")
+                if include_dir:
+                    include_dirs.append(
+                        os.path.normpath(os.path.join(self.directory, include_dir))
+                    )
+                break
+        return include_dirs
+
+
+def load_compile_commands(compile_commands_path: str) -> List[CompileCommand]:
+    """Load a compilation database.
+
+    Args:
+        compile_commands_path: Path of the compile_commands.json file
+
+    Returns:
+        The compile commands
+
+    Raises:
+        RAValueError: If the file is not a valid compilation database
+    """
+    with open(compile_commands_path, "r") as f:
+        entries = json.load(f)
+    if not isinstance(entries, list):
+        raise RAValueError(
+            f"The compilation database must be a JSON array: {compile_commands_path}"
+        )
+
+    compile_commands: List[CompileCommand] = []
+    for entry in entries:
+        if "file" not in entry or "directory" not in entry:
+            raise RAValueError(f"Invalid compile command: {entry}")
+        if "arguments" in entry:
+            arguments = list(entry["arguments"])
+        elif "command" in entry:
+            arguments = shlex.split(entry["command"])
+        else:
+            raise RAValueError(f"Compile command without arguments: {entry}")
+        directory = entry["directory"]
+        file_path = os.path.normpath(os.path.join(directory, entry["file"]))
+        compile_commands.append(CompileCommand(file_path, directory, arguments))
+    return compile_commands
+
+
+def read_source_file(file_path: str) -> Optional[str]:
+    """Read a source file, or return None if it cannot be read."""
+    try:
+        with open(file_path, "r", encoding="utf-8", errors="ignore") as f:
+            return f.read()
+    except (OSError, IOError) as e:
+        print(f"Warning: Could not read file {file_path}: {e}")
+        return None
+
+
+def collect_build_files(
+    project_path: str, compile_commands_path: str
+) -> Tuple[Dict[str, str], Dict[str, Set[str]]]:
+    """Collect the TUs of a project in its build and the headers they include.
+
+    Args:
+        project_path: Root path of the project
+        compile_commands_path: Path of the compile_commands.json file, which may
+            list the TUs of other projects too (e.g., of a monorepo)
+
+    Returns:
+        Tuple of (dictionary mapping the absolute file paths to their contents, and
+        dictionary mapping each file to its scope, i.e., the project files it
+        includes transitively and itself)
+    """
+    code_in_files: Dict[str, str] = {}
+    include_graph = IncludeGraph(project_path)
+    for compile_command in load_compile_commands(compile_commands_path):
+        if not is_in_project(compile_command.file_path, include_graph.project_root):
+            continue
+        include_dirs = compile_command.include_dirs()
+        worklist = deque([compile_command.file_path])
+        while worklist:
+            file_path = worklist.popleft()
+            if include_graph.is_scanned(file_path):
+                continue
+            source_code = read_source_file(file_path)
+            if source_code is None:
+                include_graph.add_file(file_path, "", include_dirs)
+                continue
+            code_in_files[file_path] = source_code
+            included_paths = include_graph.add_file(
+                file_path, source_code, include_dirs
+            )
+            worklist.extend(included_paths)
+    file_scopes = include_graph.get_file_scopes(code_in_files)
+
+    if not code_in_files:
+        print(
+            f"Warning: No translation unit of {compile_commands_path} is in "
+            f"{project_path}"
+        )
+    return code_in_files, file_scopes
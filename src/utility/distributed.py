@@ -0,0 +1,460 @@
+"""Distributed slicing of a batch of slice requests by a coordinator and workers.
+
+The coordinator puts one task per slice request in a task queue (see
+utility/task_queue.py), returns the tasks of crashed workers to the queue, and
+merges the results of the workers into one output directory: the
+slice_info_<slicing_request_id>.json files of the requests (which the batch judger
+reads) and a summary.json of the run.
+
+Workers on any number of hosts claim the tasks and run reposlice.py on each of them
+in a fresh process, up to --concurrency at a time. The workers share, through
+directories on a shared file system:
+- the content-addressed LLM answer cache (--llm-cache-dir, see
+  llmtool/LLM_cache.py), so that a query asked by any worker is answered once;
+- the U6IR snapshots (--ir-store-dir, see memory/IR/U6IR_store.py), so that a
+  project is analyzed once per content of its sources and checkout path. The
+  snapshots record the absolute file paths, so they are only shared by workers
+  whose checkouts of a project are at the same path.
+
+Example:
+    python -m utility.distributed coordinator --queue-dir /shared/queue \\
+        --slice-request-path requests/*.json --output-dir merged
+    python -m utility.distributed worker --queue-dir /shared/queue \\
+        --concurrency 8 --llm-cache-dir /shared/llm_cache \\
+        --ir-store-dir /shared/ir -- --audit-model-name gpt-5-mini
+"""
+
+import json
+import os
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+from pathlib import Path
+from typing import Dict, List, Optional
+
+from utility.errors import RAValueError, RepoSliceError
+from utility.request import SliceRequest
+from utility.task_queue import FileTaskQueue, TaskQueue
+
+BASE_PATH = Path(__file__).resolve().parents[2]
+SRC_PATH = BASE_PATH / "src"
+
+
+def enqueue_requests(
+    task_queue: TaskQueue, slice_request_paths: List[str]
+) -> List[str]:
+    """Put one task per slice request in the queue, and close it.
+
+    Args:
+        task_queue: Queue of the run
+        slice_request_paths: Paths of the slice request JSON files
+
+    Returns:
+        Ids of the tasks, i.e., the slicing request ids
+
+    Raises:
+        RARequestError: If a slice request is invalid
+        RAValueError: If the queue holds tasks of an earlier run, or two slice
+            requests have the same id
+    """
+    # Stale results would finish the new tasks of the same ids at once, and a
+    # stale close would stop the idle workers before the tasks are added
+    if not task_queue.is_empty():
+        raise RAValueError(
+            "The task queue holds tasks of an earlier run; remove them or use "
+            "another queue directory"
+        )
+    task_ids: List[str] = []
+    for slice_request_path in slice_request_paths:
+        with open(slice_request_path, "r") as f:
+            slice_request_dict = json.load(f)
+        # Parse the request, so that an invalid one fails before any work
+        slicing_request_id = SliceRequest.from_dict(
+            slice_request_dict
+        ).slicing_request_id
+        if slicing_request_id in task_ids:
+            raise RAValueError(f"Duplicated slicing request id: {slicing_request_id}")
+        task_queue.put(slicing_request_id, {"slice_request": slice_request_dict})
+        task_ids.append(slicing_request_id)
+    task_queue.close()
+    return task_ids
+
+
+def wait_for_tasks(
+    task_queue: TaskQueue,
+    task_ids: List[str],
+    lease_seconds: float,
+    poll_interval: float,
+) -> None:
+    """Wait until all the tasks are completed or failed.
+
+    Args:
+        task_queue: Queue of the run
+        task_ids: Ids of the tasks to wait for
+        lease_seconds: Seconds after which a task not renewed by its worker is
+            returned to the queue
+        poll_interval: Seconds between two checks of the queue
+    """
+    last_status: Dict[str, int] = {}
+    while True:
+        for task_id in task_queue.requeue_expired(lease_seconds):
+            print(f"The lease of task {task_id} expired; the task is pending again")
+        status = task_queue.get_status()
+        if status != last_status:
+            print(json.dumps(status))
+            last_status = status
+        finished_task_ids = task_queue.get_finished_task_ids()
+        if all(task_id in finished_task_ids for task_id in task_ids):
+            return
+        time.sleep(poll_interval)
+
+
+def merge_results(
+    task_queue: TaskQueue, task_ids: List[str], output_dir: str, wall_time: float
+) -> Dict:
+    """Merge the results of the workers into an output directory.
+
+    Args:
+        task_queue: Queue of the run
+        task_ids: Ids of the tasks of the run
+        output_dir: Directory receiving the slice_info files and summary.json
+        wall_time: Seconds the run took
+
+    Returns:
+        The summary of the run
+    """
+    Path(output_dir).mkdir(parents=True, exist_ok=True)
+    results = task_queue.get_results()
+    errors = task_queue.get_errors()
+
+    requests: Dict[str, Dict] = {}
+    worker_task_nums: Dict[str, int] = {}
+    for task_id in task_ids:
+        if task_id not in results:
+            continue
+        result = results[task_id]
+        slice_info_path = os.path.join(output_dir, f"slice_info_{task_id}.json")
+        with open(slice_info_path, "w") as f:
+            json.dump(result["slice_info"], f, indent=4)
+        requests[task_id] = {
+            key: value for key, value in result.items() if key != "slice_info"
+        }
+        worker_id = result["worker_id"]
+        worker_task_nums[worker_id] = worker_task_nums.get(worker_id, 0) + 1
+
+    summary = {
+        "request_num": len(task_ids),
+        "completed_num": len(requests),
+        "failed_num": sum(1 for task_id in task_ids if task_id in errors),
+        "wall_time": wall_time,
+        "requests_per_minute": 60 * len(requests) / max(wall_time, 1e-9),
+        "worker_task_nums": worker_task_nums,
+        "requests": requests,
+        "errors": {
+            task_id: errors[task_id]["error"]
+            for task_id in task_ids
+            if task_id in errors
+        },
+    }
+    with open(os.path.join(output_dir, "summary.json"), "w") as f:
+        json.dump(summary, f, indent=4)
+    return summary
+
+
+def run_task(payload: Dict, reposlice_args: List[str]) -> Dict:
+    """Run reposlice.py on the slice request of a task in a fresh process.
+
+    Args:
+        payload: Payload of the task
+        reposlice_args: Additional arguments of reposlice.py
+
+    Returns:
+        The slicing result and the timing of the run
+
+    Raises:
+        RuntimeError: If the run fails
+    """
+    slice_request_dict = payload["slice_request"]
+    slicing_request_id = slice_request_dict["slicing_request_id"]
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        slice_request_path = os.path.join(tmp_dir, f"{slicing_request_id}.json")
+        with open(slice_request_path, "w") as f:
+            json.dump(slice_request_dict, f)
+        stage_timing_path = os.path.join(tmp_dir, "stage_timing.json")
+        command = [
+            sys.executable,
+            "reposlice.py",
+            "--slice-request-path",
+            slice_request_path,
+            "--stage-timing-output",
+            stage_timing_path,
+        ] + reposlice_args
+        process = subprocess.run(
+            command, cwd=SRC_PATH, capture_output=True, text=True
+        )
+        if process.returncode != 0:
+            raise RuntimeError(
+                f"reposlice.py failed on {slicing_request_id}:\n{process.stderr}"
+            )
+        with open(stage_timing_path, "r") as f:
+            stage_timing = json.load(f)
+
+    result_dir_path = stage_timing["result_dir_paths"][0]
+    with open(
+        os.path.join(result_dir_path, f"slice_info_{slicing_request_id}.json"), "r"
+    ) as f:
+        slice_info = json.load(f)
+    return {
+        "slice_info": slice_info,
+        "result_dir_path": result_dir_path,
+        "wall_time": stage_timing["wall_time"],
+        "peak_rss_bytes": stage_timing["peak_rss_bytes"],
+        "llm_cache": stage_timing.get("llm_cache", {}),
+    }
+
+
+class Worker:
+    """Worker claiming the tasks of a queue and running them concurrently."""
+
+    def __init__(
+        self,
+        task_queue: TaskQueue,
+        worker_id: str,
+        reposlice_args: List[str],
+        concurrency: int = 1,
+        max_attempt_num: int = 2,
+        poll_interval: float = 2.0,
+        renew_interval: float = 30.0,
+    ) -> None:
+        """Initialize the worker.
+
+        Args:
+            task_queue: Queue of the run
+            worker_id: Id of the worker, unique among the workers of the run
+            reposlice_args: Additional arguments of reposlice.py
+            concurrency: Maximum number of tasks run at a time
+            max_attempt_num: Number of attempts of a task before it is failed
+            poll_interval: Seconds between two claims when no task is pending
+            renew_interval: Seconds between two renewals of the lease of a task,
+                which must be shorter than the lease of the coordinator
+        """
+        self.task_queue = task_queue
+        self.worker_id = worker_id
+        self.reposlice_args = reposlice_args
+        self.concurrency = concurrency
+        self.max_attempt_num = max_attempt_num
+        self.poll_interval = poll_interval
+        self.renew_interval = renew_interval
+        self.completed_num = 0
+        self.failed_num = 0
+        self._lock = threading.Lock()
+
+    def run(self) -> None:
+        """Run tasks until the queue is closed and no task is pending."""
+        threads = [
+            threading.Thread(
+                target=self._run_tasks, name=f"{self.worker_id}-{index}", daemon=True
+            )
+            for index in range(self.concurrency)
+        ]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+    def _run_tasks(self) -> None:
+        while True:
+            claimed_task = self.task_queue.claim(self.worker_id)
+            if claimed_task is None:
+                if self.task_queue.is_closed():
+                    return
+                time.sleep(self.poll_interval)
+                continue
+            task_id, payload = claimed_task
+            self._run_task(task_id, payload)
+
+    def _run_task(self, task_id: str, payload: Dict) -> None:
+        is_finished = threading.Event()
+
+        def renew_lease() -> None:
+            while not is_finished.wait(self.renew_interval):
+                self.task_queue.renew(task_id)
+
+        renew_thread = threading.Thread(target=renew_lease, daemon=True)
+        renew_thread.start()
+        start_time = time.perf_counter()
+        error: Optional[Exception] = None
+        try:
+            result = run_task(payload, self.reposlice_args)
+        except Exception as e:
+            error = e
+        finally:
+            is_finished.set()
+            renew_thread.join()
+        if error is not None:
+            is_failed = self.task_queue.fail(task_id, str(error), self.max_attempt_num)
+            with self._lock:
+                self.failed_num += int(is_failed)
+            print(f"Task {task_id} failed: {error}", file=sys.stderr)
+            return
+        result["worker_id"] = self.worker_id
+        result["host"] = socket.gethostname()
+        self.task_queue.complete(task_id, result)
+        with self._lock:
+            self.completed_num += 1
+        print(
+            f"Task {task_id} completed by {self.worker_id} in "
+            f"{time.perf_counter() - start_time:.1f}s"
+        )
+
+
+def main() -> None:
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        description="Distributed slicing of a batch of slice requests"
+    )
+    subparsers = parser.add_subparsers(dest="role", required=True)
+
+    coordinator_parser = subparsers.add_parser(
+        "coordinator", help="Enqueue the slice requests and merge the results"
+    )
+    coordinator_parser.add_argument(
+        "--queue-dir",
+        required=True,
+        help="Directory of the task queue, which must be new or empty",
+    )
+    coordinator_parser.add_argument(
+        "--slice-request-path",
+        required=True,
+        nargs="+",
+        help="Json files containing the slice requests",
+    )
+    coordinator_parser.add_argument(
+        "--output-dir",
+        required=True,
+        help="Directory receiving the merged results and summary.json",
+    )
+    coordinator_parser.add_argument(
+        "--lease-seconds",
+        type=float,
+        default=300.0,
+        help="Seconds after which a task not renewed by its worker is requeued",
+    )
+    coordinator_parser.add_argument(
+        "--poll-interval",
+        type=float,
+        default=2.0,
+        help="Seconds between two checks of the task queue",
+    )
+
+    worker_parser = subparsers.add_parser(
+        "worker", help="Run the tasks of the queue with reposlice.py"
+    )
+    worker_parser.add_argument(
+        "--queue-dir", required=True, help="Directory of the task queue"
+    )
+    worker_parser.add_argument(
+        "--worker-id",
+        default=None,
+        help="Id of the worker (default: <host>-<pid>)",
+    )
+    worker_parser.add_argument(
+        "--concurrency",
+        type=int,
+        default=1,
+        help="Maximum number of reposlice.py processes run at a time",
+    )
+    worker_parser.add_argument(
+        "--max-attempt-num",
+        type=int,
+        default=2,
+        help="Number of attempts of a task before it is failed",
+    )
+    worker_parser.add_argument(
+        "--poll-interval",
+        type=float,
+        default=2.0,
+        help="Seconds between two claims when no task is pending",
+    )
+    worker_parser.add_argument(
+        "--renew-interval",
+        type=float,
+        default=30.0,
+        help="Seconds between two renewals of the lease of a running task",
+    )
+    worker_parser.add_argument(
+        "--llm-cache-dir",
+        default=None,
+        help="Directory of the LLM answer cache shared by the workers",
+    )
+    worker_parser.add_argument(
+        "--ir-store-dir",
+        default=None,
+        help=(
+            "Directory of the U6IR snapshots shared by the workers whose checkouts "
+            "are at the same paths"
+        ),
+    )
+    worker_parser.add_argument(
+        "reposlice_args",
+        nargs="*",
+        help="Additional arguments of reposlice.py, after -- "
+        "(default language: Cpp)",
+    )
+    args = parser.parse_args()
+
+    task_queue = FileTaskQueue(args.queue_dir)
+    if args.role == "coordinator":
+        start_time = time.perf_counter()
+        try:
+            task_ids = enqueue_requests(task_queue, args.slice_request_path)
+        except RepoSliceError as e:
+            parser.error(str(e))
+        print(f"{len(task_ids)} tasks are enqueued in {args.queue_dir}")
+        wait_for_tasks(task_queue, task_ids, args.lease_seconds, args.poll_interval)
+        summary = merge_results(
+            task_queue, task_ids, args.output_dir, time.perf_counter() - start_time
+        )
+        print(
+            f"{summary['completed_num']}/{summary['request_num']} requests completed "
+            f"({summary['requests_per_minute']:.1f} per minute); the results are "
+            f"merged in {args.output_dir}"
+        )
+        if summary["failed_num"] > 0:
+            for task_id, error in summary["errors"].items():
+                print(f"Slice request {task_id} failed: {error}", file=sys.stderr)
+            sys.exit(1)
+        return
+
+    if args.concurrency < 1:
+        parser.error("--concurrency must be positive")
+    reposlice_args = list(args.reposlice_args)
+    if "--language" not in reposlice_args:
+        reposlice_args += ["--language", "Cpp"]
+    if args.llm_cache_dir is not None:
+        reposlice_args += ["--llm-cache-dir", args.llm_cache_dir]
+    if args.ir_store_dir is not None:
+        reposlice_args += ["--ir-store-dir", args.ir_store_dir]
+    worker_id = args.worker_id or f"{socket.gethostname()}-{os.getpid()}"
+    worker = Worker(
+        task_queue,
+        worker_id,
+        reposlice_args,
+        args.concurrency,
+        args.max_attempt_num,
+        args.poll_interval,
+        args.renew_interval,
+    )
+    worker.run()
+    print(
+        f"Worker {worker_id} exits: {worker.completed_num} tasks completed, "
+        f"{worker.failed_num} failed"
+    )
+
+
+if __name__ == "__main__":
+    main()
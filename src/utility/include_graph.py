@@ -0,0 +1,187 @@
+"""Include graph of the source files of a project.
+
+The graph links each file to the project files it includes. It yields the scope
+of each file, i.e., the file and the project headers it includes transitively,
+which the analyzer uses to resolve a call to the definitions visible from the
+caller (see TSAnalyzer._scope_callee_ids).
+
+The #include directives are followed regardless of the preprocessor conditions
+around them, which may keep a few headers of disabled configurations. Headers
+outside the project (system and third-party ones) are not followed.
+"""
+
+import os
+import re
+from collections import deque
+from typing import Dict, Iterable, List, Optional, Set
+
+INCLUDE_PATTERN = re.compile(r'^\s*#\s*include\s*([<"])([^>"]+)[>"]', re.MULTILINE)
+
+
+def is_in_project(file_path: str, project_root: str) -> bool:
+    """Check whether a normalized path is under a project root."""
+    return file_path == project_root or file_path.startswith(project_root + os.sep)
+
+
+def resolve_include(
+    include_name: str,
+    is_quoted: bool,
+    including_dir: str,
+    include_dirs: List[str],
+) -> Optional[str]:
+    """Resolve an #include directive to a file.
+
+    Args:
+        include_name: Name in the directive
+        is_quoted: Whether the name is quoted rather than angle-bracketed
+        including_dir: Directory of the including file
+        include_dirs: Include directories of the TU
+
+    Returns:
+        Absolute normalized path of the included file, or None if not found
+    """
+    search_dirs = ([including_dir] if is_quoted else []) + include_dirs
+    for search_dir in search_dirs:
+        include_path = os.path.normpath(os.path.join(search_dir, include_name))
+        if os.path.isfile(include_path):
+            return include_path
+    return None
+
+
+class IncludeGraph:
+    """Graph of the #include directives between the files of a project."""
+
+    def __init__(self, project_path: str) -> None:
+        """Initialize an empty graph.
+
+        Args:
+            project_path: Root path of the project
+        """
+        self.project_root = os.path.normpath(os.path.abspath(project_path))
+        # Maps file paths -> project files they include directly
+        self.direct_includes: Dict[str, Set[str]] = {}
+        # Maps file name suffixes (e.g., "util/log.h") -> project files ending with
+        # them, to resolve the directives without the include directories
+        self.suffix_index: Dict[str, List[str]] = {}
+
+    def index_files(self, file_paths: Iterable[str]) -> None:
+        """Index project files to resolve the directives by their path suffixes.
+
+        Without the include directories of a build, <util/log.h> is resolved to
+        the only project file whose path ends with util/log.h, if any.
+
+        Args:
+            file_paths: Absolute normalized paths of the files
+        """
+        for file_path in file_paths:
+            parts = os.path.relpath(file_path, self.project_root).split(os.sep)
+            for i in range(len(parts)):
+                suffix = "/".join(parts[i:])
+                self.suffix_index.setdefault(suffix, []).append(file_path)
+
+    def _resolve_by_suffix(self, include_name: str) -> Optional[str]:
+        include_paths = self.suffix_index.get(
+            os.path.normpath(include_name).replace(os.sep, "/"), []
+        )
+        # An ambiguous name is not resolved rather than guessed
+        return include_paths[0] if len(include_paths) == 1 else None
+
+    def is_scanned(self, file_path: str) -> bool:
+        """Check whether the directives of a file are in the graph."""
+        return file_path in self.direct_includes
+
+    def add_file(
+        self, file_path: str, source_code: str, include_dirs: List[str]
+    ) -> Set[str]:
+        """Add the directives of a file, unless already added.
+
+        A header included by several TUs is resolved with the include
+        directories of the first one.
+
+        Args:
+            file_path: Absolute normalized path of the file
+            source_code: Content of the file
+            include_dirs: Include directories of the TU, searched before the
+                suffix index
+
+        Returns:
+            The project files the file includes directly
+        """
+        if file_path in self.direct_includes:
+            return self.direct_includes[file_path]
+        included_paths: Set[str] = set()
+        for delimiter, include_name in INCLUDE_PATTERN.findall(source_code):
+            include_path = resolve_include(
+                include_name,
+                delimiter == '"',
+                os.path.dirname(file_path),
+                include_dirs,
+            )
+            if include_path is None:
+                include_path = self._resolve_by_suffix(include_name)
+            if include_path is not None and is_in_project(
+                include_path, self.project_root
+            ):
+                included_paths.add(include_path)
+        self.direct_includes[file_path] = included_paths
+        return included_paths
+
+    def get_file_scopes(self, file_paths: Iterable[str]) -> Dict[str, Set[str]]:
+        """Get the scopes of files.
+
+        Args:
+            file_paths: Files whose scopes are computed, which are also the only
+                files kept in the scopes
+
+        Returns:
+            Dictionary mapping each file to the files it includes transitively
+            and itself
+        """
+        file_path_set = set(file_paths)
+        file_scopes: Dict[str, Set[str]] = {}
+        for file_path in file_path_set:
+            scope = {file_path}
+            worklist = deque([file_path])
+            while worklist:
+                for include_path in self.direct_includes.get(worklist.popleft(), ()):
+                    if include_path not in scope and include_path in file_path_set:
+                        scope.add(include_path)
+                        worklist.append(include_path)
+            file_scopes[file_path] = scope
+        return file_scopes
+
+
+def get_include_scopes(
+    project_path: str, code_in_files: Dict[str, str]
+) -> Dict[str, Set[str]]:
+    """Get the scopes of the source files of a project without a build.
+
+    The quoted directives are resolved against the including directory, and the
+    others against the project files by their path suffixes.
+
+    Args:
+        project_path: Root path of the project
+        code_in_files: Dictionary mapping the absolute file paths to their contents
+
+    Returns:
+        Dictionary mapping each file to the files it includes transitively and
+        itself
+    """
+    # The graph is keyed by the normalized paths, unlike code_in_files
+    file_paths = {os.path.normpath(file_path): file_path for file_path in code_in_files}
+    # Maps the real paths -> normalized paths, to follow the directives through
+    # symbolic links to the files read under other paths
+    real_paths = {os.path.realpath(path): path for path in file_paths}
+    include_graph = IncludeGraph(project_path)
+    include_graph.index_files(file_paths)
+    for norm_file_path, file_path in file_paths.items():
+        included_paths = include_graph.add_file(
+            norm_file_path, code_in_files[file_path], []
+        )
+        include_graph.direct_includes[norm_file_path] = {
+            real_paths.get(os.path.realpath(path), path) for path in included_paths
+        }
+    return {
+        file_paths[norm_file_path]: {file_paths[path] for path in scope}
+        for norm_file_path, scope in include_graph.get_file_scopes(file_paths).items()
+    }
@@ -0,0 +1,207 @@
+"""Structured log of the LLM interactions of an agent.
+
+Each query (or cache hit) of an LLM tool is written as one JSON record to
+llm_interactions.jsonl. The prompts and responses are not written in the records:
+they are split into paragraphs, and each distinct paragraph is stored once in the
+gzip-compressed, content-addressed store llm_blobs.jsonl.gz, where the records
+reference it by its SHA-256 hash. The rules and examples repeated in every prompt
+are therefore stored once per agent, as long as their hashes stay among the
+MAX_STORED_HASHES most recently used ones; an evicted paragraph is stored again
+when it recurs, which load_blobs deduplicates.
+
+The blob store is flushed before the records, so that the paragraphs referenced by
+a written record are readable even if the run is interrupted.
+
+A prompt is restored by joining its paragraphs with a blank line (see
+load_blobs and restore_text).
+"""
+
+import gzip
+import hashlib
+import json
+import queue
+import threading
+import time
+from pathlib import Path
+from collections import OrderedDict
+from typing import Dict, Iterable, List, Optional
+
+INTERACTION_LOG_NAME = "llm_interactions.jsonl"
+BLOB_STORE_NAME = "llm_blobs.jsonl.gz"
+
+# Maximum number of interactions waiting for the writer thread. When the queue
+# is full, interactions are dropped (and counted) rather than blocking the LLM
+# threads.
+INTERACTION_QUEUE_SIZE = 1000
+
+# Maximum number of paragraph hashes remembered as stored, which bounds the memory
+# of a long-running agent at the cost of storing some evicted paragraphs again
+MAX_STORED_HASHES = 100000
+
+PARAGRAPH_SEPARATOR = "\n\n"
+
+
+def get_blob_hash(text: str) -> str:
+    """Get the hash of a paragraph in the blob store."""
+    return hashlib.sha256(text.encode("utf-8")).hexdigest()
+
+
+class LogBuffer(list):
+    """Bounded buffer of the log messages of a call.
+
+    Messages beyond the maximum number are counted instead of kept, and long
+    messages are truncated, so that a call cannot grow its log without bound.
+    """
+
+    def __init__(self, max_message_num: int = 64, max_message_len: int = 2000):
+        super().__init__()
+        self.max_message_num = max_message_num
+        self.max_message_len = max_message_len
+        self.dropped_num = 0
+
+    def append(self, message: str) -> None:
+        if len(self) >= self.max_message_num:
+            self.dropped_num += 1
+            return
+        if len(message) > self.max_message_len:
+            message = (
+                message[: self.max_message_len]
+                + f"... ({len(message) - self.max_message_len} characters truncated)"
+            )
+        super().append(message)
+
+
+class InteractionLog:
+    """Writer of the LLM interactions of an agent, run by a background thread.
+
+    The hashing, deduplication, compression and writing all happen in the writer
+    thread; logging an interaction only enqueues it.
+    """
+
+    def __init__(self, log_dir_path: str) -> None:
+        """Initialize the interaction log. The files are created on the first write.
+
+        Args:
+            log_dir_path: Directory of the log files
+        """
+        self.log_dir_path = Path(log_dir_path)
+        self.dropped_num = 0
+        self._queue: queue.Queue = queue.Queue(INTERACTION_QUEUE_SIZE)
+        # Hashes of the stored paragraphs, from the least to the most recently used
+        self._stored_hashes: "OrderedDict[str, None]" = OrderedDict()
+        self._lock = threading.Lock()
+        self._writer_thread: Optional[threading.Thread] = None
+
+    def log(self, record: Dict, prompt: str = "", response: str = "") -> None:
+        """Log an interaction.
+
+        Args:
+            record: Fields of the interaction record
+            prompt: Prompt sent to the LLM, stored by reference
+            response: Response of the LLM, stored by reference
+        """
+        with self._lock:
+            if self._writer_thread is None:
+                self._writer_thread = threading.Thread(
+                    target=self._write, name="interaction-log-writer", daemon=True
+                )
+                self._writer_thread.start()
+        try:
+            self._queue.put_nowait((time.time(), record, prompt, response))
+        except queue.Full:
+            self.dropped_num += 1
+
+    def _store_text(self, text: str, blob_file) -> List[str]:
+        """Store the new paragraphs of a text and get the hashes of all of them."""
+        blob_hashes = []
+        for paragraph in text.split(PARAGRAPH_SEPARATOR):
+            blob_hash = get_blob_hash(paragraph)
+            if blob_hash in self._stored_hashes:
+                self._stored_hashes.move_to_end(blob_hash)
+            else:
+                self._stored_hashes[blob_hash] = None
+                if len(self._stored_hashes) > MAX_STORED_HASHES:
+                    self._stored_hashes.popitem(last=False)
+                blob = {"hash": blob_hash, "text": paragraph}
+                blob_file.write((json.dumps(blob) + "\n").encode("utf-8"))
+            blob_hashes.append(blob_hash)
+        return blob_hashes
+
+    def _write(self) -> None:
+        self.log_dir_path.mkdir(parents=True, exist_ok=True)
+        with open(self.log_dir_path / INTERACTION_LOG_NAME, "a") as record_file:
+            # Appending gzip members keeps the store readable as one stream
+            with gzip.open(self.log_dir_path / BLOB_STORE_NAME, "ab") as blob_file:
+                while True:
+                    item = self._queue.get()
+                    if item is None:
+                        break
+                    timestamp, record, prompt, response = item
+                    record = {
+                        "time": time.strftime(
+                            "%Y-%m-%d %H:%M:%S", time.localtime(timestamp)
+                        ),
+                        **record,
+                    }
+                    if prompt:
+                        record["prompt_hashes"] = self._store_text(prompt, blob_file)
+                    if response:
+                        record["response_hashes"] = self._store_text(
+                            response, blob_file
+                        )
+                    record_file.write(json.dumps(record) + "\n")
+                    if self._queue.empty():
+                        # The blobs first, so that no flushed record references a
+                        # blob that is not flushed yet
+                        blob_file.flush()
+                        record_file.flush()
+                if self.dropped_num > 0:
+                    record_file.write(
+                        json.dumps({"dropped_interaction_num": self.dropped_num})
+                        + "\n"
+                    )
+
+    def close(self) -> None:
+        """Write the queued interactions and stop the writer thread."""
+        with self._lock:
+            writer_thread = self._writer_thread
+            self._writer_thread = None
+        if writer_thread is None:
+            return
+        self._queue.put(None)
+        writer_thread.join()
+
+
+def load_blobs(log_dir_path: str) -> Dict[str, str]:
+    """Load the blob store of an interaction log.
+
+    Args:
+        log_dir_path: Directory of the log files
+
+    Returns:
+        Dictionary mapping the hashes to the paragraphs
+    """
+    blobs: Dict[str, str] = {}
+    with gzip.open(Path(log_dir_path) / BLOB_STORE_NAME, "rt", encoding="utf-8") as f:
+        try:
+            for line in f:
+                blob = json.loads(line)
+                blobs[blob["hash"]] = blob["text"]
+        except EOFError:
+            # The last member is not closed yet (a running or interrupted agent),
+            # but its flushed blobs are read
+            pass
+    return blobs
+
+
+def restore_text(blob_hashes: Iterable[str], blobs: Dict[str, str]) -> str:
+    """Restore a prompt or response from the hashes of its paragraphs.
+
+    Args:
+        blob_hashes: Hashes of the paragraphs, in order
+        blobs: Blob store returned by load_blobs
+
+    Returns:
+        The text
+    """
+    return PARAGRAPH_SEPARATOR.join(blobs[blob_hash] for blob_hash in blob_hashes)
@@ -0,0 +1,751 @@
+"""Microbenchmarks of the U6IR and Function query APIs.
+
+The IRs are built in memory from synthetic projects (see
+utility/synthetic_project.py) of increasing size, without parsing: the Function
+objects, call sites, values, control structures and call graph maps are filled
+in the way the tree-sitter analyzers fill them, over stand-in AST nodes that
+mirror the node types the analyzers query. The benchmark thus isolates the cost
+of the query APIs themselves, and the fitted scaling exponents show whether an
+IR change alters their complexity.
+
+The operations walking the AST nodes (SYNTHETIC_NODE_OPERATION_NAMES) are timed
+on the stand-in nodes, which are plain Python objects, whereas the child lists of
+parsed tree-sitter nodes are built by the C library on each access. Their
+latencies are labeled as synthetic and reported apart from the IR costs, as they
+only show how the walks scale, not what they cost on parsed trees.
+"""
+
+import json
+import math
+import random
+import statistics
+import sys
+import time
+from pathlib import Path
+from typing import Callable, Dict, List, Optional, Tuple
+
+from memory.IR.U6IR import U6IR
+from memory.utils.api import API
+from memory.utils.function import Function
+from memory.utils.value import Value, ValueLabel
+from utility.synthetic_project import (
+    SyntheticFunction,
+    SyntheticProjectConfig,
+    SyntheticProjectGenerator,
+    SyntheticStatement,
+)
+
+BASE_PATH = Path(__file__).resolve().parents[2]
+
+OPERATION_NAMES = [
+    "function_args",
+    "function_paras",
+    "function_outvals",
+    "get_all_caller_functions",
+    "get_all_transitive_caller_functions",
+    "get_callsites_by_callee_name",
+    "check_control_order",
+    "value_hash",
+]
+# Operations walking the stand-in AST nodes, whose latencies are synthetic
+SYNTHETIC_NODE_OPERATION_NAMES = [
+    "get_call_site_id",
+    "find_nodes_by_type",
+]
+
+
+class SyntheticNode:
+    """Stand-in for a tree-sitter node, with the attributes the IR queries use."""
+
+    def __init__(self, node_type: str, children: Optional[List] = None) -> None:
+        """Initialize a node.
+
+        Args:
+            node_type: Tree-sitter type of the node
+            children: Child nodes
+        """
+        self.type = node_type
+        self.children: List[SyntheticNode] = children or []
+
+
+class SyntheticIRBuilder:
+    """Builder of a U6IR from the functions of a synthetic project."""
+
+    def __init__(self, generator: SyntheticProjectGenerator, project_path: str) -> None:
+        """Initialize the builder.
+
+        Args:
+            generator: Generator whose functions have been generated
+            project_path: Pseudo project path prefixing the file paths
+        """
+        self.generator = generator
+        self.project_path = project_path
+        self.file_lines = generator.layout_files()
+        self.u6ir = U6IR(
+            {
+                f"{project_path}/{file_name}": "\n".join(lines) + "\n"
+                for file_name, lines in self.file_lines.items()
+            }
+        )
+        self.function_ids: Dict[str, int] = {
+            function.name: function_id
+            for function_id, function in enumerate(generator.functions, start=1)
+        }
+
+    @staticmethod
+    def _get_call_arguments(statement: SyntheticStatement) -> List[str]:
+        """Get the arguments of a call statement, or of the printf of a print."""
+        if statement.kind == "call":
+            return statement.args
+        format_string = statement.code[len("printf(") : statement.code.rfind(",")]
+        return [format_string] + sorted(statement.uses)
+
+    def _build_node_tree(
+        self, synthetic_function: SyntheticFunction
+    ) -> Tuple[SyntheticNode, Dict[int, SyntheticNode]]:
+        """Build the stand-in AST of a function.
+
+        Args:
+            synthetic_function: Function to build the AST of
+
+        Returns:
+            The root node, and a dictionary mapping the indices of the call and
+            print statements to their call_expression nodes
+        """
+        root = SyntheticNode("function_definition")
+        statement_nodes: Dict[int, SyntheticNode] = {}
+        call_nodes: Dict[int, SyntheticNode] = {}
+        for index, statement in enumerate(synthetic_function.statements):
+            if statement.kind == "signature":
+                parameter_nodes = [
+                    SyntheticNode(
+                        "parameter_declaration", [SyntheticNode("identifier")]
+                    )
+                    for _ in synthetic_function.params
+                ]
+                node = SyntheticNode(
+                    "function_declarator",
+                    [
+                        SyntheticNode("identifier"),
+                        SyntheticNode("parameter_list", parameter_nodes),
+                    ],
+                )
+            elif statement.kind in ("call", "print"):
+                argument_nodes = [
+                    SyntheticNode("identifier")
+                    for _ in self._get_call_arguments(statement)
+                ]
+                call_nodes[index] = SyntheticNode(
+                    "call_expression",
+                    [
+                        SyntheticNode("identifier"),
+                        SyntheticNode("argument_list", argument_nodes),
+                    ],
+                )
+                node = SyntheticNode("expression_statement", [call_nodes[index]])
+            elif statement.kind == "assign":
+                node = SyntheticNode(
+                    "expression_statement", [SyntheticNode("assignment_expression")]
+                )
+            elif statement.kind == "decl":
+                node = SyntheticNode("declaration", [SyntheticNode("init_declarator")])
+            elif statement.kind == "if":
+                node = SyntheticNode(
+                    "if_statement",
+                    [
+                        SyntheticNode("condition_clause"),
+                        SyntheticNode("compound_statement"),
+                    ],
+                )
+            elif statement.kind == "else":
+                node = SyntheticNode(
+                    "else_clause", [SyntheticNode("compound_statement")]
+                )
+            elif statement.kind == "for":
+                node = SyntheticNode("for_statement", [SyntheticNode("block")])
+            elif statement.kind == "return":
+                node = SyntheticNode("return_statement")
+            else:
+                continue
+
+            statement_nodes[index] = node
+            if statement.parent is None:
+                root.children.append(node)
+            else:
+                # The body of an if/for block, or the else clause of an if
+                parent_node = statement_nodes[statement.parent]
+                if statement.kind == "else":
+                    parent_node.children.append(node)
+                else:
+                    parent_node.children[-1].children.append(node)
+        return root, call_nodes
+
+    def _add_control_statements(
+        self, function: Function, synthetic_function: SyntheticFunction
+    ) -> None:
+        """Fill the if and loop statements of a function (absolute line numbers)."""
+        start_line_number = synthetic_function.start_line_number
+        open_blocks: List[int] = []
+        else_indices: Dict[int, int] = {}
+        for index, statement in enumerate(synthetic_function.statements):
+            line_number = start_line_number + index
+            if statement.kind in ("if", "for"):
+                open_blocks.append(index)
+            elif statement.kind == "else":
+                else_indices[statement.parent] = index
+            elif statement.kind == "close" and open_blocks:
+                header = open_blocks.pop()
+                header_line_number = start_line_number + header
+                header_code = synthetic_function.statements[header].code
+                condition = header_code[
+                    header_code.find("(") : header_code.rfind(")") + 1
+                ]
+                if synthetic_function.statements[header].kind == "for":
+                    function.loop_statements[(header_line_number, line_number)] = (
+                        header_line_number,
+                        header_line_number,
+                        condition[1:-1],
+                        header_line_number + 1,
+                        line_number - 1,
+                    )
+                    continue
+                else_scope = (0, 0)
+                true_end_line_number = line_number
+                if header in else_indices:
+                    else_line_number = start_line_number + else_indices[header]
+                    else_scope = (else_line_number, line_number)
+                    true_end_line_number = else_line_number
+                function.if_statements[(header_line_number, line_number)] = (
+                    header_line_number,
+                    header_line_number,
+                    condition,
+                    (header_line_number, true_end_line_number),
+                    else_scope,
+                )
+
+    def _add_function(self, synthetic_function: SyntheticFunction) -> Function:
+        """Create the Function object of a synthetic function and its values."""
+        u6ir = self.u6ir
+        function_id = self.function_ids[synthetic_function.name]
+        file_path = f"{self.project_path}/{synthetic_function.file_name}"
+        code_lines = synthetic_function.render()
+        start_line_number = synthetic_function.start_line_number
+        root, call_nodes = self._build_node_tree(synthetic_function)
+        function = Function(
+            function_id,
+            synthetic_function.name,
+            "\n".join(code_lines),
+            start_line_number,
+            start_line_number + len(code_lines) - 1,
+            root,
+            file_path,
+        )
+
+        for index, param in enumerate(synthetic_function.params):
+            function.add_para(
+                Value(
+                    param,
+                    ValueLabel.PARA,
+                    file_path,
+                    start_line_number,
+                    function_id,
+                    function.function_name,
+                    1,
+                    index,
+                )
+            )
+
+        for index, statement in enumerate(synthetic_function.statements):
+            line_number = start_line_number + index
+            if statement.kind == "return" and synthetic_function.level > 0:
+                function.add_retval(
+                    Value(
+                        statement.code[len("return") : -1].strip(),
+                        ValueLabel.RET,
+                        file_path,
+                        line_number,
+                        function_id,
+                        function.function_name,
+                        index + 1,
+                        0,
+                    )
+                )
+            if index not in call_nodes:
+                continue
+
+            call_site_id = len(function.all_call_site_nodes)
+            callee_name = statement.callee_name or "printf"
+            call_site = (call_nodes[index], callee_name, index + 1, index + 1)
+            function.all_call_site_nodes[call_site_id] = call_site
+            call_code = statement.code[statement.code.find(callee_name) : -1]
+            arguments = self._get_call_arguments(statement)
+            for arg_index, argument in enumerate(arguments):
+                function.add_arg(
+                    call_site_id,
+                    Value(
+                        argument,
+                        ValueLabel.ARG,
+                        file_path,
+                        line_number,
+                        function_id,
+                        function.function_name,
+                        index + 1,
+                        arg_index,
+                    ),
+                )
+            function.add_outval(
+                call_site_id,
+                Value(
+                    call_code,
+                    ValueLabel.OUT,
+                    file_path,
+                    line_number,
+                    function_id,
+                    function.function_name,
+                    index + 1,
+                    -1,
+                ),
+            )
+
+            if statement.callee_name is not None:
+                callee_id = self.function_ids[statement.callee_name]
+                function.function_call_site_nodes[call_site_id] = call_site
+                u6ir.function_caller_callee_map.setdefault(function_id, {})[
+                    call_site_id
+                ] = {callee_id}
+                u6ir.function_callee_caller_map.setdefault(callee_id, set()).add(
+                    (call_site_id, function_id)
+                )
+            else:
+                function.api_call_site_nodes[call_site_id] = call_site
+                if not u6ir.api_env:
+                    u6ir.api_env[1] = API(1, "printf", 2)
+                u6ir.function_caller_api_callee_map.setdefault(function_id, {})[
+                    call_site_id
+                ] = {1}
+                u6ir.api_callee_function_caller_map.setdefault(1, set()).add(
+                    (call_site_id, function_id)
+                )
+
+        self._add_control_statements(function, synthetic_function)
+        u6ir.functionRawDataDic[function_id] = (
+            root,
+            function.function_name,
+            function.start_line_number,
+            function.end_line_number,
+        )
+        u6ir.functionNameToId.setdefault(function.function_name, set()).add(
+            function_id
+        )
+        u6ir.functionToFile[function_id] = file_path
+        u6ir.function_env[function_id] = function
+        return function
+
+    def build(self) -> U6IR:
+        """Build the U6IR of the project.
+
+        Returns:
+            The U6IR, with the function ids numbered from 1 in generation order
+        """
+        for synthetic_function in self.generator.functions:
+            self._add_function(synthetic_function)
+        return self.u6ir
+
+
+def build_synthetic_ir(config: SyntheticProjectConfig) -> U6IR:
+    """Generate a synthetic project and build its U6IR in memory.
+
+    Args:
+        config: Parameters of the project
+
+    Returns:
+        The U6IR of the project
+    """
+    generator = SyntheticProjectGenerator(config)
+    generator.generate()
+    return SyntheticIRBuilder(generator, f"/synthetic/seed_{config.seed}").build()
+
+
+def create_operations(
+    u6ir: U6IR, sample_num: int, seed: int
+) -> Dict[str, Tuple[Callable, List[Tuple]]]:
+    """Create the benchmarked operations and their sampled inputs.
+
+    The inputs are sampled once per IR, so that all the operations of a size are
+    timed on the same functions, and the same seed gives the same samples.
+
+    Args:
+        u6ir: IR to query
+        sample_num: Number of inputs per operation
+        seed: Seed of the sampling
+
+    Returns:
+        Dictionary mapping the operation names to the operation and its inputs
+    """
+    rng = random.Random(seed)
+    functions = [u6ir.function_env[key] for key in sorted(u6ir.function_env)]
+    callers = [function for function in functions if function.function_call_site_nodes]
+    leaves = [
+        function
+        for function in functions
+        if function.function_id not in u6ir.function_caller_callee_map
+    ] or functions
+
+    call_sites = []
+    for _ in range(sample_num):
+        caller = rng.choice(callers)
+        call_site_id = rng.choice(sorted(caller.function_call_site_nodes))
+        call_sites.append((caller, *caller.function_call_site_nodes[call_site_id]))
+
+    line_pairs = []
+    for _ in range(sample_num):
+        function = rng.choice(functions)
+        line_pairs.append(
+            (
+                function,
+                rng.randint(function.start_line_number, function.end_line_number),
+                rng.randint(function.start_line_number, function.end_line_number),
+            )
+        )
+
+    values = []
+    for _ in range(sample_num):
+        function = rng.choice(callers)
+        call_site_id = rng.choice(sorted(function.all_call_site_nodes))
+        values.extend(function.args(call_site_id=call_site_id))
+        values.append(function.outval(call_site_id))
+    values = values[:sample_num]
+
+    sampled_functions = [rng.choice(functions) for _ in range(sample_num)]
+    sampled_leaves = [rng.choice(leaves) for _ in range(sample_num)]
+    return {
+        "function_args": (
+            lambda caller, _, callee_name, line_number, __: caller.args(
+                line_number, callee_name, 0
+            ),
+            call_sites,
+        ),
+        "function_paras": (
+            lambda function: function.paras(),
+            [(function,) for function in sampled_functions],
+        ),
+        "function_outvals": (
+            lambda caller, _, callee_name, line_number, __: caller.outvals(
+                line_number, callee_name
+            ),
+            call_sites,
+        ),
+        "get_call_site_id": (
+            lambda caller, node, *_: caller.get_call_site_id(node),
+            call_sites,
+        ),
+        "get_all_caller_functions": (
+            u6ir.get_all_caller_functions,
+            [(function,) for function in sampled_functions],
+        ),
+        "get_all_transitive_caller_functions": (
+            u6ir.get_all_transitive_caller_functions,
+            [(function,) for function in sampled_leaves],
+        ),
+        "get_callsites_by_callee_name": (
+            lambda caller, _, callee_name, *__: u6ir.get_callsites_by_callee_name(
+                caller, callee_name
+            ),
+            call_sites,
+        ),
+        "check_control_order": (u6ir.check_control_order, line_pairs),
+        "value_hash": (hash, [(value,) for value in values]),
+        "find_nodes_by_type": (
+            lambda function: u6ir.find_nodes_by_type(
+                function.parse_tree_root_node, "call_expression"
+            ),
+            [(function,) for function in sampled_functions],
+        ),
+    }
+
+
+def time_operation(operation: Callable, inputs: List[Tuple], repeat: int) -> Dict:
+    """Time an operation over its inputs.
+
+    Args:
+        operation: Operation to time
+        inputs: Argument tuples of the calls
+        repeat: Number of timed passes over the inputs
+
+    Returns:
+        Dictionary containing the median and minimum per-call latency over the
+        passes (in microseconds), and the number of calls per pass
+    """
+    # One untimed pass warms up the caches of the interpreter
+    for arguments in inputs:
+        operation(*arguments)
+
+    latencies = []
+    for _ in range(repeat):
+        start_time = time.perf_counter()
+        for arguments in inputs:
+            operation(*arguments)
+        latencies.append((time.perf_counter() - start_time) / len(inputs) * 1e6)
+    return {
+        "median_us": statistics.median(latencies),
+        "min_us": min(latencies),
+        "call_num": len(inputs),
+    }
+
+
+def fit_scaling_exponent(sizes: List[int], latencies: List[float]) -> Optional[float]:
+    """Fit latency ~ size^k by least squares in log-log space.
+
+    Args:
+        sizes: Sizes of the IRs
+        latencies: Latencies of an operation on the IRs
+
+    Returns:
+        The exponent k (about 0 for constant time, 1 for linear time), or None if
+        there are fewer than two usable points
+    """
+    points = [
+        (math.log(size), math.log(latency))
+        for size, latency in zip(sizes, latencies)
+        if size > 0 and latency > 0
+    ]
+    if len(points) < 2:
+        return None
+    mean_x = statistics.fmean(x for x, _ in points)
+    mean_y = statistics.fmean(y for _, y in points)
+    variance = sum((x - mean_x) ** 2 for x, _ in points)
+    if variance == 0:
+        return None
+    return sum((x - mean_x) * (y - mean_y) for x, y in points) / variance
+
+
+def run_ir_benchmark(
+    sizes: List[int],
+    dimension: str = "functions",
+    base_config: Optional[SyntheticProjectConfig] = None,
+    sample_num: int = 200,
+    repeat: int = 5,
+) -> Dict:
+    """Run the microbenchmarks on IRs of increasing size.
+
+    Args:
+        sizes: Sizes of the IRs, in the unit of the dimension
+        dimension: "functions" to scale the number of functions, or "length" to
+            scale the length of the functions
+        base_config: Parameters of the projects besides the scaled one
+        sample_num: Number of inputs per operation and size
+        repeat: Number of timed passes per operation and size
+
+    Returns:
+        Report with the latency of each operation at each size and the fitted
+        scaling exponents, the operations on the stand-in AST nodes being in
+        separate synthetic sections
+    """
+    assert dimension in ("functions", "length"), "invalid dimension"
+    base_config = base_config or SyntheticProjectConfig()
+    points: List[Dict] = []
+    for size in sizes:
+        config = SyntheticProjectConfig(**base_config.to_dict())
+        if dimension == "functions":
+            config.function_num = size
+        else:
+            config.function_length = size
+
+        build_start_time = time.perf_counter()
+        u6ir = build_synthetic_ir(config)
+        build_time = time.perf_counter() - build_start_time
+
+        operations = create_operations(u6ir, sample_num, config.seed)
+        points.append(
+            {
+                "size": size,
+                "function_num": len(u6ir.function_env),
+                "line_num": sum(
+                    content.count("\n") for content in u6ir.code_in_files.values()
+                ),
+                "build_time": build_time,
+                "operations": {
+                    name: time_operation(*operations[name], repeat)
+                    for name in OPERATION_NAMES
+                },
+                "synthetic_node_operations": {
+                    name: time_operation(*operations[name], repeat)
+                    for name in SYNTHETIC_NODE_OPERATION_NAMES
+                },
+            }
+        )
+
+    def fit_section(section: str, names: List[str]) -> Dict[str, Optional[float]]:
+        return {
+            name: fit_scaling_exponent(
+                [point["size"] for point in points],
+                [point[section][name]["median_us"] for point in points],
+            )
+            for name in names
+        }
+    return {
+        "timestamp": time.strftime("%Y-%m-%d-%H-%M-%S", time.localtime()),
+        "python_version": sys.version.split()[0],
+        "dimension": dimension,
+        "base_config": base_config.to_dict(),
+        "sample_num": sample_num,
+        "repeat": repeat,
+        "points": points,
+        "scaling_exponents": fit_section("operations", OPERATION_NAMES),
+        "synthetic_node_scaling_exponents": fit_section(
+            "synthetic_node_operations", SYNTHETIC_NODE_OPERATION_NAMES
+        ),
+    }
+
+
+def compare_reports(report: Dict, baseline: Dict) -> Dict[str, Dict[int, float]]:
+    """Compare the latencies of a report with those of a baseline report.
+
+    Args:
+        report: Report of the current run
+        baseline: Report of the baseline run
+
+    Returns:
+        Dictionary mapping the names of the IR operations to the speedups over
+        the baseline at the sizes measured by both reports (none if they scale
+        different dimensions)
+    """
+    if baseline.get("dimension") != report["dimension"]:
+        return {name: {} for name in OPERATION_NAMES}
+    baseline_points = {point["size"]: point for point in baseline["points"]}
+    speedups: Dict[str, Dict[int, float]] = {name: {} for name in OPERATION_NAMES}
+    for point in report["points"]:
+        baseline_point = baseline_points.get(point["size"])
+        if baseline_point is None:
+            continue
+        for name in OPERATION_NAMES:
+            baseline_operation = baseline_point["operations"].get(name)
+            latency = point["operations"][name]["median_us"]
+            if baseline_operation is not None and latency > 0:
+                speedups[name][point["size"]] = (
+                    baseline_operation["median_us"] / latency
+                )
+    return speedups
+
+
+def print_latency_table(
+    report: Dict, section: str, exponent_section: str, names: List[str]
+) -> None:
+    """Print the median microseconds per call and the exponents of operations.
+
+    Args:
+        report: Report returned by run_ir_benchmark
+        section: Section of the points holding the latencies of the operations
+        exponent_section: Section of the report holding their exponents
+        names: Names of the operations
+    """
+    sizes = [point["size"] for point in report["points"]]
+    print(f"{'operation':<38}" + "".join(f"{size:>10}" for size in sizes) + "     k")
+    for name in names:
+        latencies = "".join(
+            f"{point[section][name]['median_us']:>10.2f}" for point in report["points"]
+        )
+        exponent = report[exponent_section][name]
+        exponent_str = f"{exponent:>6.2f}" if exponent is not None else "     -"
+        print(f"{name:<38}{latencies}{exponent_str}")
+
+
+def main():
+    """Main function for command-line usage."""
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        description="Microbenchmark the U6IR and Function query APIs"
+    )
+    parser.add_argument(
+        "--sizes",
+        type=int,
+        nargs="+",
+        default=[100, 300, 1000, 3000],
+        help="Sizes of the generated IRs (default: 100 300 1000 3000)",
+    )
+    parser.add_argument(
+        "--dimension",
+        choices=["functions", "length"],
+        default="functions",
+        help="Scale the number of functions or the length of the functions",
+    )
+    parser.add_argument(
+        "--functions",
+        type=int,
+        default=1000,
+        help="Number of functions when scaling the length",
+    )
+    parser.add_argument(
+        "--function-length",
+        type=int,
+        default=30,
+        help="Lines per function when scaling the functions",
+    )
+    parser.add_argument("--call-depth", type=int, default=4, help="Call levels")
+    parser.add_argument("--fan-out", type=int, default=3, help="Calls per caller")
+    parser.add_argument("--fan-in", type=int, default=2, help="Callers per callee")
+    parser.add_argument("--seed", type=int, default=0, help="Random seed")
+    parser.add_argument(
+        "--samples", type=int, default=200, help="Inputs per operation and size"
+    )
+    parser.add_argument(
+        "--repeat", type=int, default=5, help="Timed passes per operation and size"
+    )
+    parser.add_argument(
+        "--baseline", default=None, help="Report to compare the latencies with"
+    )
+    parser.add_argument(
+        "--output",
+        default=None,
+        help="Path of the JSON report (default: result/benchmark/ir_benchmark_*.json)",
+    )
+    args = parser.parse_args()
+
+    base_config = SyntheticProjectConfig(
+        function_num=max(args.functions, args.call_depth),
+        call_depth=args.call_depth,
+        fan_out=args.fan_out,
+        fan_in=args.fan_in,
+        function_length=args.function_length,
+        seed=args.seed,
+    )
+    report = run_ir_benchmark(
+        args.sizes, args.dimension, base_config, args.samples, args.repeat
+    )
+
+    output: Optional[str] = args.output
+    if output is None:
+        output_dir = BASE_PATH / "result" / "benchmark"
+        output_dir.mkdir(parents=True, exist_ok=True)
+        output = str(output_dir / f"ir_benchmark_{report['timestamp']}.json")
+    with open(output, "w") as f:
+        json.dump(report, f, indent=4)
+
+    sizes = [point["size"] for point in report["points"]]
+    print_latency_table(report, "operations", "scaling_exponents", OPERATION_NAMES)
+    print("Synthetic: walks of stand-in AST nodes, not of parsed tree-sitter trees")
+    print_latency_table(
+        report,
+        "synthetic_node_operations",
+        "synthetic_node_scaling_exponents",
+        SYNTHETIC_NODE_OPERATION_NAMES,
+    )
+
+    if args.baseline is not None:
+        with open(args.baseline, "r") as f:
+            baseline = json.load(f)
+        print("Speedups over the baseline:")
+        for name, speedups in compare_reports(report, baseline).items():
+            print(
+                f"{name:<38}"
+                + "".join(
+                    f"{speedups[size]:>10.2f}" if size in speedups else f"{'-':>10}"
+                    for size in sizes
+                )
+            )
+    print(f"The benchmark report is saved in {output}")
+
+
+if __name__ == "__main__":
+    main()
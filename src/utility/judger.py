@@ -73,7 +73,8 @@ def judge_slice_result(
         oracle_dir: Directory containing oracle files (default: "oracle" relative to project root)
 
     Returns:
-        Dictionary containing precision, recall, f1_score, and detailed metrics
+        Dictionary containing precision, recall, f1_score, and detailed metrics,
+        and whether the result is truncated (see SliceScanState.to_dict)
 
     Raises:
         FileNotFoundError: If oracle or result file doesn't exist
@@ -154,6 +155,8 @@ def judge_slice_result(
 
     return {
         "slice_request_id": slice_request_id,
+        # A truncated result dropped work items, so its recall is a lower bound
+        "is_truncated": result_data.get("is_truncated", False),
         "overall_metrics": {
             "true_positives": total_tp,
             "false_positives": total_fp,
@@ -1,46 +1,137 @@
+import atexit
 import sys
 import logging
+import queue
 import threading
+from logging.handlers import QueueHandler, QueueListener
 from pathlib import Path
-from typing import Any
+from typing import Any, Dict, List, Optional
+
+from utility.interaction_log import InteractionLog
+
+# Maximum number of messages waiting for the writer thread of a logger. When the
+# queue is full, messages are dropped (and counted, the console ones apart, and
+# reported at close) rather than blocking the worklist and LLM threads.
+LOG_QUEUE_SIZE = 10000
+
+LOG_FORMAT = "%(asctime)s - %(levelname)s - %(message)s"
+
+# Default levels of the file and console outputs of new loggers
+_default_file_level = logging.DEBUG
+_default_console_level = logging.INFO
+
+# The console handler is shared by all the loggers, so that their lines do not
+# interleave
+_console_handler = logging.StreamHandler(sys.stdout)
+_console_handler.setFormatter(logging.Formatter(LOG_FORMAT))
+_console_handler.addFilter(lambda record: getattr(record, "is_console", False))
+
+_active_loggers: List["Logger"] = []
+_active_loggers_lock = threading.Lock()
+
+
+def set_default_log_levels(file_level: int, console_level: int) -> None:
+    """Set the levels of the file and console outputs of the loggers created next.
+
+    Args:
+        file_level: Level of the messages written to the log files
+        console_level: Level of the console messages printed to stdout
+    """
+    global _default_file_level, _default_console_level
+    _default_file_level = file_level
+    _default_console_level = console_level
+
+
+class _BoundedQueueHandler(QueueHandler):
+    """Queue handler dropping the messages that do not fit in its bounded queue."""
+
+    def __init__(self, log_queue: queue.Queue) -> None:
+        super().__init__(log_queue)
+        self._dropped_lock = threading.Lock()
+        self.dropped_num = 0
+        # Dropped messages that were to be printed to the console too
+        self.dropped_console_num = 0
+
+    def prepare(self, record: logging.LogRecord) -> logging.LogRecord:
+        # The messages are already formatted strings, so the formatting is left
+        # to the writer thread
+        return record
+
+    def enqueue(self, record: logging.LogRecord) -> None:
+        try:
+            self.queue.put_nowait(record)
+        except queue.Full:
+            with self._dropped_lock:
+                self.dropped_num += 1
+                if getattr(record, "is_console", False):
+                    self.dropped_console_num += 1
+
+
+class _QueueListener(QueueListener):
+    """Queue listener whose stop waits for room in a full queue."""
+
+    def enqueue_sentinel(self) -> None:
+        self.queue.put(self._sentinel)
 
 
 class Logger:
-    def __init__(self, log_file_path: str, log_level=logging.INFO):
+    def __init__(
+        self,
+        log_file_path: str,
+        log_level: Optional[int] = None,
+        console_level: Optional[int] = None,
+    ):
         """
         Initialize the Logger class.
 
+        Messages are put in a bounded queue and written by a background thread, so
+        that logging never waits for the file or the console.
+
         Args:
             log_file_path (str): Path to the log file.
-            log_level (int, optional): Logging level, defaults to logging.INFO.
+            log_level (int, optional): Level of the messages written to the log file,
+                defaults to the one set by set_default_log_levels (logging.DEBUG).
+            console_level (int, optional): Level of the messages printed to the
+                console, defaults to the one set by set_default_log_levels
+                (logging.INFO).
         """
-        # Initialize thread lock for thread-safe log operations
-        self._log_lock = threading.Lock()
+        if log_level is None:
+            log_level = _default_file_level
+        if console_level is None:
+            console_level = _default_console_level
         self.log_file_path = Path(log_file_path)
         # Ensure the parent directory exists
         self.log_file_path.parent.mkdir(parents=True, exist_ok=True)
 
         # Create a logger instance with a unique name based on the log file path
         self.logger = logging.getLogger(f"RepoSliceLogger-{log_file_path}")
-        self.logger.setLevel(log_level)
+        self.logger.setLevel(min(log_level, console_level))
+        self.logger.propagate = False
         # Clear any existing handlers to avoid duplicate output
         self.logger.handlers.clear()
+        self.console_level = console_level
 
-        # Create a formatter for log messages
-        formatter = logging.Formatter("%(asctime)s - %(levelname)s - %(message)s")
-
-        # Create and add a file handler
+        # Create the file handler, run by the writer thread
         file_handler = logging.FileHandler(
             self.log_file_path, mode="a", encoding="utf-8"
         )
         file_handler.setLevel(log_level)
-        file_handler.setFormatter(formatter)
-        self.logger.addHandler(file_handler)
+        file_handler.setFormatter(logging.Formatter(LOG_FORMAT))
+        self.file_handler = file_handler
 
-        # Prepare a console handler for dynamic use in print_console method
-        self.console_handler = logging.StreamHandler(sys.stdout)
-        self.console_handler.setLevel(log_level)
-        self.console_handler.setFormatter(formatter)
+        self.queue_handler = _BoundedQueueHandler(queue.Queue(LOG_QUEUE_SIZE))
+        self.logger.addHandler(self.queue_handler)
+        self.listener = _QueueListener(
+            self.queue_handler.queue,
+            file_handler,
+            _console_handler,
+            respect_handler_level=True,
+        )
+        self.listener.start()
+        # The LLM interactions are logged next to the log file
+        self.interaction_log = InteractionLog(str(self.log_file_path.parent))
+        with _active_loggers_lock:
+            _active_loggers.append(self)
 
     def print_log(self, *args: Any) -> None:
         """
@@ -49,12 +140,22 @@ class Logger:
         Args:
             *args: Message parts to be logged, which are merged into a single string.
         """
-        with self._log_lock:
-            # Remove the console handler if it exists, so the message is logged only to file
-            if self.console_handler in self.logger.handlers:
-                self.logger.removeHandler(self.console_handler)
-            message = " ".join(map(str, args))
-            self.logger.info(message)
+        self.logger.info(" ".join(map(str, args)))
+
+    def print_debug(self, *args: Any) -> None:
+        """
+        Output verbose messages (e.g., the bounded per-call logs of the LLM tools)
+        to the log file, and to the console only if its level is logging.DEBUG.
+        The full prompts and responses are not logged here, but in
+        llm_interactions.jsonl and its blob store (see utility/interaction_log.py).
+
+        Args:
+            *args: Message parts to be logged, which are merged into a single string.
+        """
+        if not self.logger.isEnabledFor(logging.DEBUG):
+            return
+        is_console = self.console_level <= logging.DEBUG
+        self.logger.debug(" ".join(map(str, args)), extra={"is_console": is_console})
 
     def print_console(self, *args: Any) -> None:
         """
@@ -63,11 +164,55 @@ class Logger:
         Args:
             *args: Message parts to be logged, which are merged into a single string.
         """
-        with self._log_lock:
-            # Add the console handler if it's not already added
-            if self.console_handler not in self.logger.handlers:
-                self.logger.addHandler(self.console_handler)
-            message = " ".join(map(str, args))
-            self.logger.info(message)
-            # Remove the console handler after logging so that default logging goes only to file
-            self.logger.removeHandler(self.console_handler)
+        is_console = self.console_level <= logging.INFO
+        self.logger.info(" ".join(map(str, args)), extra={"is_console": is_console})
+
+    def log_interaction(
+        self, record: Dict, prompt: str = "", response: str = ""
+    ) -> None:
+        """
+        Log an LLM interaction as a structured record, storing the prompt and the
+        response by reference (see utility/interaction_log.py).
+
+        Args:
+            record: Fields of the interaction record
+            prompt: Prompt sent to the LLM
+            response: Response of the LLM
+        """
+        self.interaction_log.log(record, prompt, response)
+
+    def close(self) -> None:
+        """Write the queued messages and stop the writer threads."""
+        with _active_loggers_lock:
+            if self not in _active_loggers:
+                return
+            _active_loggers.remove(self)
+        self.listener.stop()
+        dropped_num = self.queue_handler.dropped_num
+        dropped_console_num = self.queue_handler.dropped_console_num
+        if dropped_num > 0:
+            # Written directly, as the writer thread is stopped
+            warning = logging.makeLogRecord(
+                {
+                    "levelno": logging.WARNING,
+                    "levelname": "WARNING",
+                    "msg": f"{dropped_num} log messages of {self.log_file_path} "
+                    f"({dropped_console_num} of them console messages) were "
+                    "dropped as the log queue was full",
+                    "is_console": dropped_console_num > 0,
+                }
+            )
+            self.file_handler.handle(warning)
+            _console_handler.handle(warning)
+        self.logger.removeHandler(self.queue_handler)
+        self.file_handler.close()
+        self.interaction_log.close()
+
+
+@atexit.register
+def close_all_loggers() -> None:
+    """Write the queued messages of all the loggers before the process exits."""
+    with _active_loggers_lock:
+        loggers = list(_active_loggers)
+    for logger in loggers:
+        logger.close()
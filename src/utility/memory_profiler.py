@@ -0,0 +1,231 @@
+"""Per-stage memory profiling of a run with tracemalloc.
+
+At the end of each stage, a checkpoint records the memory retained by the Python
+allocations and their peak during the stage, the allocation sites that grew the
+most since the previous checkpoint (by diffing tracemalloc snapshots), and the
+numbers of the analysis objects alive. Given U6IRs, it also breaks down the
+strings the IRs retain, e.g., the file contents and the lined code of functions.
+"""
+
+import gc
+import sys
+import threading
+import tracemalloc
+from typing import Dict, List, Optional
+
+from tree_sitter import Node
+
+from memory.IR.U6IR import U6IR
+from memory.utils.function import Function
+from memory.utils.value import Value
+from utility.stage_timer import get_peak_rss_bytes
+
+
+def _get_size_dict(stats: List[tracemalloc.StatisticDiff]) -> List[Dict]:
+    """Convert the statistic diffs of allocation sites to dictionaries."""
+    return [
+        {
+            "site": f"{stat.traceback[0].filename}:{stat.traceback[0].lineno}",
+            "size_bytes": stat.size,
+            "size_diff_bytes": stat.size_diff,
+            "count": stat.count,
+            "count_diff": stat.count_diff,
+        }
+        for stat in stats
+    ]
+
+
+def count_objects() -> Dict[str, int]:
+    """Count the Function, Value and tree-sitter objects alive.
+
+    Returns:
+        Dictionary mapping the type names to the numbers of objects
+    """
+    counts = {"Function": 0, "Value": 0, "Node": 0, "Tree": 0}
+    for obj in gc.get_objects():
+        if isinstance(obj, Function):
+            counts["Function"] += 1
+        elif isinstance(obj, Value):
+            counts["Value"] += 1
+        elif type(obj).__module__ == "tree_sitter" and type(obj).__name__ in counts:
+            counts[type(obj).__name__] += 1
+    return counts
+
+
+def measure_ir_memory(u6ir: U6IR) -> Dict[str, int]:
+    """Measure the objects and strings retained by a U6IR.
+
+    Strings are not tracked by the garbage collector, so they are measured from
+    the IR. File contents shared by code_in_files and fileContentDic are counted
+    once, and the other ones of fileContentDic as duplicated. Of an IR offloaded to
+    an on-disk store, only the functions cached in memory are measured. Only the
+    tree-sitter nodes are counted as retained nodes: the functions rebuilt from a
+    store have no root node and StoredCallSite objects in place of their call
+    site nodes.
+
+    Args:
+        u6ir: IR to measure
+
+    Returns:
+        Dictionary containing the object numbers and string bytes of the IR
+    """
+    file_content_ids = {id(content) for content in u6ir.code_in_files.values()}
+    node_ids = set()
+    value_num = 0
+    function_code_bytes = 0
+    lined_code_bytes = 0
+    value_string_bytes = 0
+    # Only the functions held in memory are measured in an offloaded IR
+    if u6ir.ir_store is not None:
+        functions = u6ir.function_env.cached_values()
+    else:
+        functions = list(u6ir.function_env.values())
+
+    def add_node(node: object) -> None:
+        if isinstance(node, Node):
+            node_ids.add(id(node))
+
+    for function in functions:
+        function_code_bytes += sys.getsizeof(function.function_code)
+        lined_code_bytes += sys.getsizeof(function.lined_code)
+        add_node(function.parse_tree_root_node)
+        for node, _, _, _ in function.all_call_site_nodes.values():
+            add_node(node)
+
+        values = list(function._paras) + list(function._retvals)
+        values += list(function._outvals.values())
+        for args in function._args.values():
+            values += list(args)
+        value_num += len(values)
+        value_string_bytes += sum(sys.getsizeof(value.name) for value in values)
+    for node, _, _, _ in u6ir.functionRawDataDic.values():
+        add_node(node)
+
+    return {
+        "file_num": len(u6ir.code_in_files),
+        "function_num": len(u6ir.function_env),
+        "in_memory_function_num": len(functions),
+        "value_num": value_num,
+        "retained_node_num": len(node_ids),
+        "file_content_bytes": sum(
+            sys.getsizeof(content) for content in u6ir.code_in_files.values()
+        ),
+        "duplicated_file_content_bytes": sum(
+            sys.getsizeof(content)
+            for content in u6ir.fileContentDic.values()
+            if id(content) not in file_content_ids
+        ),
+        "function_code_bytes": function_code_bytes,
+        "lined_code_bytes": lined_code_bytes,
+        "value_string_bytes": value_string_bytes,
+    }
+
+
+class MemoryProfiler:
+    """Recorder of the memory of a run at the end of its stages.
+
+    The profiler is disabled by default, as tracemalloc slows down allocations and
+    the checkpoints walk the heap. Checkpoints of a disabled profiler return
+    immediately.
+    """
+
+    def __init__(self) -> None:
+        self.is_enabled = False
+        self.top_n = 10
+        self._lock = threading.Lock()
+        self._stages: List[Dict] = []
+        self._start_snapshot: Optional[tracemalloc.Snapshot] = None
+        self._last_snapshot: Optional[tracemalloc.Snapshot] = None
+        self._last_retained_bytes = 0
+
+    def enable(self, top_n: int = 10) -> None:
+        """Start tracing the allocations and drop the recorded stages.
+
+        Args:
+            top_n: Number of allocation sites reported per stage
+        """
+        with self._lock:
+            if not tracemalloc.is_tracing():
+                tracemalloc.start()
+            self.top_n = top_n
+            self._stages = []
+            self._start_snapshot = self._take_snapshot()
+            self._last_snapshot = self._start_snapshot
+            self._last_retained_bytes = tracemalloc.get_traced_memory()[0]
+            tracemalloc.reset_peak()
+            self.is_enabled = True
+
+    def disable(self) -> None:
+        """Stop tracing the allocations. The recorded stages are kept."""
+        with self._lock:
+            self.is_enabled = False
+            tracemalloc.stop()
+
+    @staticmethod
+    def _take_snapshot() -> tracemalloc.Snapshot:
+        """Take a snapshot of the allocations, excluding the ones of tracemalloc."""
+        return tracemalloc.take_snapshot().filter_traces(
+            [tracemalloc.Filter(False, tracemalloc.__file__)]
+        )
+
+    def checkpoint(self, stage_name: str, *u6irs: U6IR) -> None:
+        """Record the memory at the end of a stage.
+
+        Args:
+            stage_name: Name of the stage that ends
+            u6irs: IRs whose retained objects and strings are measured, if any. An
+                IR shared by several agents is measured once, and the measures of
+                the IRs are summed.
+        """
+        if not self.is_enabled:
+            return
+        with self._lock:
+            retained_bytes, peak_bytes = tracemalloc.get_traced_memory()
+            snapshot = self._take_snapshot()
+            top_stats = snapshot.compare_to(self._last_snapshot, "lineno")
+            stage = {
+                "stage": stage_name,
+                "retained_bytes": retained_bytes,
+                "retained_diff_bytes": retained_bytes - self._last_retained_bytes,
+                "peak_bytes": peak_bytes,
+                "peak_rss_bytes": get_peak_rss_bytes(),
+                "top_allocation_sites": _get_size_dict(top_stats[: self.top_n]),
+                "object_counts": count_objects(),
+            }
+            # Maps the ids of the IRs -> the IRs, so that a shared IR is measured once
+            distinct_u6irs = {id(u6ir): u6ir for u6ir in u6irs}
+            if distinct_u6irs:
+                ir_memory: Dict[str, int] = {}
+                for u6ir in distinct_u6irs.values():
+                    for name, size in measure_ir_memory(u6ir).items():
+                        ir_memory[name] = ir_memory.get(name, 0) + size
+                stage["ir_memory"] = {"ir_num": len(distinct_u6irs), **ir_memory}
+            self._stages.append(stage)
+
+            self._last_snapshot = snapshot
+            self._last_retained_bytes = retained_bytes
+            # The peak of the next stage starts from the memory retained now
+            tracemalloc.reset_peak()
+
+    def to_dict(self) -> Dict:
+        """Convert the recorded stages to dictionary representation.
+
+        Returns:
+            Dictionary containing the stages in order, and the allocation sites
+            that grew the most over the whole run
+        """
+        with self._lock:
+            top_allocation_sites: List[Dict] = []
+            if self._start_snapshot is not None and self._stages:
+                top_stats = self._last_snapshot.compare_to(
+                    self._start_snapshot, "lineno"
+                )
+                top_allocation_sites = _get_size_dict(top_stats[: self.top_n])
+            return {
+                "stages": list(self._stages),
+                "top_allocation_sites": top_allocation_sites,
+            }
+
+
+# The memory profiler shared by all the profiled stages of a process
+MEMORY_PROFILER = MemoryProfiler()
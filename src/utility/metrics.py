@@ -0,0 +1,388 @@
+"""Live metrics of a run, exposed in the Prometheus text exposition format.
+
+The metrics are registered in one registry per process (METRICS) by the modules
+they measure. A MetricsExporter periodically rewrites them to a textfile (e.g.,
+for the textfile collector of node_exporter) and can serve them over HTTP on a
+local port, so that long-running batch jobs can be scraped while they run.
+"""
+
+import math
+import os
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from typing import Dict, List, Optional, Sequence, Tuple
+
+from utility.errors import RAValueError
+
+# Latency buckets (in seconds) covering cache-speed calls to slow LLM queries
+DEFAULT_LATENCY_BUCKETS = (0.01, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 120)
+
+
+def _escape_label_value(value: str) -> str:
+    """Escape a label value for the text exposition format."""
+    return value.replace("\\", "\\\\").replace("\n", "\\n").replace('"', '\\"')
+
+
+def _format_labels(label_names: Sequence[str], label_values: Sequence[str]) -> str:
+    """Format the labels of a sample, e.g., {model="gpt-5-mini"}."""
+    if not label_names:
+        return ""
+    labels = ",".join(
+        f'{name}="{_escape_label_value(value)}"'
+        for name, value in zip(label_names, label_values)
+    )
+    return "{" + labels + "}"
+
+
+def _format_value(value: float) -> str:
+    """Format a sample value, using the special values of the format."""
+    if math.isinf(value):
+        return "+Inf" if value > 0 else "-Inf"
+    if float(value).is_integer():
+        return str(int(value))
+    return repr(float(value))
+
+
+class Metric:
+    """Base class of the metrics, holding one series per label value tuple."""
+
+    metric_type = ""
+
+    def __init__(self, name: str, help_text: str, label_names: Sequence[str]) -> None:
+        """Initialize a metric.
+
+        Args:
+            name: Name of the metric
+            help_text: Description of the metric
+            label_names: Names of the labels of the series
+        """
+        self.name = name
+        self.help_text = help_text
+        self.label_names = tuple(label_names)
+        self._lock = threading.Lock()
+
+    def labels(self, *label_values: str) -> "MetricSeries":
+        """Get the series of the metric with the given label values.
+
+        Args:
+            label_values: Values of the labels, in the order of the label names
+
+        Returns:
+            The series, whose updates are applied to this metric
+
+        Raises:
+            RAValueError: If the number of label values is wrong
+        """
+        if len(label_values) != len(self.label_names):
+            raise RAValueError(
+                f"Metric {self.name} expects the labels {self.label_names}, "
+                f"but got {tuple(label_values)}"
+            )
+        return MetricSeries(self, tuple(str(value) for value in label_values))
+
+    def render(self) -> List[str]:
+        """Render the metric to lines of the text exposition format."""
+        help_text = self.help_text.replace("\\", "\\\\").replace("\n", "\\n")
+        return [
+            f"# HELP {self.name} {help_text}",
+            f"# TYPE {self.name} {self.metric_type}",
+        ] + self._render_samples()
+
+    def _render_samples(self) -> List[str]:
+        raise NotImplementedError
+
+
+class ScalarMetric(Metric):
+    """Base class of the metrics holding a single value per series."""
+
+    def __init__(self, name: str, help_text: str, label_names: Sequence[str]) -> None:
+        super().__init__(name, help_text, label_names)
+        self._values: Dict[Tuple[str, ...], float] = {}
+
+    def _render_samples(self) -> List[str]:
+        with self._lock:
+            values = dict(self._values)
+        return [
+            f"{self.name}{_format_labels(self.label_names, key)} {_format_value(value)}"
+            for key, value in sorted(values.items())
+        ]
+
+
+class Counter(ScalarMetric):
+    """A monotonically increasing count."""
+
+    metric_type = "counter"
+
+    def inc(self, amount: float = 1) -> None:
+        """Increase the count of the metric without labels."""
+        self.labels().inc(amount)
+
+    def _inc(self, key: Tuple[str, ...], amount: float) -> None:
+        if amount < 0:
+            raise RAValueError(f"Counter {self.name} cannot decrease")
+        with self._lock:
+            self._values[key] = self._values.get(key, 0) + amount
+
+
+class Gauge(ScalarMetric):
+    """A value that can go up and down, e.g., a queue depth."""
+
+    metric_type = "gauge"
+
+    def set(self, value: float) -> None:
+        """Set the value of the metric without labels."""
+        self.labels().set(value)
+
+    def inc(self, amount: float = 1) -> None:
+        """Increase the value of the metric without labels."""
+        self.labels().inc(amount)
+
+    def dec(self, amount: float = 1) -> None:
+        """Decrease the value of the metric without labels."""
+        self.labels().dec(amount)
+
+    def _set(self, key: Tuple[str, ...], value: float) -> None:
+        with self._lock:
+            self._values[key] = value
+
+    def _inc(self, key: Tuple[str, ...], amount: float) -> None:
+        with self._lock:
+            self._values[key] = self._values.get(key, 0) + amount
+
+
+class Histogram(Metric):
+    """A distribution of observations in cumulative buckets."""
+
+    metric_type = "histogram"
+
+    def __init__(
+        self,
+        name: str,
+        help_text: str,
+        label_names: Sequence[str],
+        buckets: Sequence[float] = DEFAULT_LATENCY_BUCKETS,
+    ) -> None:
+        """Initialize a histogram.
+
+        Args:
+            name: Name of the metric
+            help_text: Description of the metric
+            label_names: Names of the labels of the series
+            buckets: Upper bounds of the buckets (+Inf is added)
+        """
+        super().__init__(name, help_text, label_names)
+        self.buckets = tuple(sorted(buckets)) + (math.inf,)
+        # Maps label values -> (bucket counts, sum, count)
+        self._series: Dict[Tuple[str, ...], Tuple[List[int], float, int]] = {}
+
+    def observe(self, value: float) -> None:
+        """Record an observation of the metric without labels."""
+        self.labels().observe(value)
+
+    def _observe(self, key: Tuple[str, ...], value: float) -> None:
+        with self._lock:
+            bucket_counts, value_sum, count = self._series.get(
+                key, ([0] * len(self.buckets), 0.0, 0)
+            )
+            for index, bound in enumerate(self.buckets):
+                if value <= bound:
+                    bucket_counts[index] += 1
+                    break
+            self._series[key] = (bucket_counts, value_sum + value, count + 1)
+
+    def _render_samples(self) -> List[str]:
+        with self._lock:
+            series = {
+                key: (list(bucket_counts), value_sum, count)
+                for key, (bucket_counts, value_sum, count) in self._series.items()
+            }
+        lines = []
+        label_names = self.label_names + ("le",)
+        for key, (bucket_counts, value_sum, count) in sorted(series.items()):
+            cumulative_count = 0
+            for bound, bucket_count in zip(self.buckets, bucket_counts):
+                cumulative_count += bucket_count
+                labels = _format_labels(label_names, key + (_format_value(bound),))
+                lines.append(f"{self.name}_bucket{labels} {cumulative_count}")
+            labels = _format_labels(self.label_names, key)
+            lines.append(f"{self.name}_sum{labels} {_format_value(value_sum)}")
+            lines.append(f"{self.name}_count{labels} {count}")
+        return lines
+
+
+class MetricSeries:
+    """A series of a metric, i.e., the metric with fixed label values."""
+
+    def __init__(self, metric: Metric, key: Tuple[str, ...]) -> None:
+        self.metric = metric
+        self.key = key
+
+    def inc(self, amount: float = 1) -> None:
+        """Increase the value of a counter or gauge series."""
+        self.metric._inc(self.key, amount)  # type: ignore
+
+    def dec(self, amount: float = 1) -> None:
+        """Decrease the value of a gauge series."""
+        self.metric._inc(self.key, -amount)  # type: ignore
+
+    def set(self, value: float) -> None:
+        """Set the value of a gauge series."""
+        self.metric._set(self.key, value)  # type: ignore
+
+    def observe(self, value: float) -> None:
+        """Record an observation in a histogram series."""
+        self.metric._observe(self.key, value)  # type: ignore
+
+
+class MetricsRegistry:
+    """Thread-safe registry of the metrics of a process."""
+
+    def __init__(self) -> None:
+        self._lock = threading.Lock()
+        self._metrics: Dict[str, Metric] = {}
+
+    def _register(self, metric: Metric) -> Metric:
+        """Register a metric, or get the metric registered with the same name.
+
+        Raises:
+            RAValueError: If a metric of another type or labels has the same name
+        """
+        with self._lock:
+            registered_metric = self._metrics.get(metric.name)
+            if registered_metric is None:
+                self._metrics[metric.name] = metric
+                return metric
+            if (
+                type(registered_metric) is not type(metric)
+                or registered_metric.label_names != metric.label_names
+            ):
+                raise RAValueError(f"Metric {metric.name} is registered differently")
+            return registered_metric
+
+    def counter(
+        self, name: str, help_text: str, label_names: Sequence[str] = ()
+    ) -> Counter:
+        """Register a counter (or get the registered one)."""
+        return self._register(Counter(name, help_text, label_names))  # type: ignore
+
+    def gauge(
+        self, name: str, help_text: str, label_names: Sequence[str] = ()
+    ) -> Gauge:
+        """Register a gauge (or get the registered one)."""
+        return self._register(Gauge(name, help_text, label_names))  # type: ignore
+
+    def histogram(
+        self,
+        name: str,
+        help_text: str,
+        label_names: Sequence[str] = (),
+        buckets: Sequence[float] = DEFAULT_LATENCY_BUCKETS,
+    ) -> Histogram:
+        """Register a histogram (or get the registered one)."""
+        return self._register(  # type: ignore
+            Histogram(name, help_text, label_names, buckets)
+        )
+
+    def render(self) -> str:
+        """Render all the metrics in the text exposition format.
+
+        Returns:
+            The metrics, sorted by name
+        """
+        with self._lock:
+            metrics = sorted(self._metrics.values(), key=lambda metric: metric.name)
+        lines: List[str] = []
+        for metric in metrics:
+            lines.extend(metric.render())
+        return "\n".join(lines) + "\n"
+
+
+class MetricsExporter:
+    """Exporter of a registry to a textfile and, optionally, a local HTTP endpoint."""
+
+    def __init__(
+        self,
+        registry: "MetricsRegistry",
+        textfile_path: Optional[str] = None,
+        interval: float = 15.0,
+        http_port: Optional[int] = None,
+    ) -> None:
+        """Initialize the exporter.
+
+        Args:
+            registry: Registry to export
+            textfile_path: Path of the textfile rewritten every interval, or None
+            interval: Seconds between two rewrites of the textfile
+            http_port: Local port serving the metrics on /metrics, or None
+        """
+        self.registry = registry
+        self.textfile_path = textfile_path
+        self.interval = interval
+        self.http_port = http_port
+        self._stop_event = threading.Event()
+        self._writer_thread: Optional[threading.Thread] = None
+        self._http_server: Optional[ThreadingHTTPServer] = None
+
+    def write_textfile(self) -> None:
+        """Rewrite the textfile atomically, so that no scraper reads half of it."""
+        if self.textfile_path is None:
+            return
+        tmp_path = f"{self.textfile_path}.{os.getpid()}.tmp"
+        with open(tmp_path, "w") as f:
+            f.write(self.registry.render())
+        os.replace(tmp_path, self.textfile_path)
+
+    def start(self) -> None:
+        """Start rewriting the textfile and serving the HTTP endpoint."""
+        if self.textfile_path is not None:
+            self.write_textfile()
+            self._writer_thread = threading.Thread(
+                target=self._write_periodically, name="metrics-writer", daemon=True
+            )
+            self._writer_thread.start()
+
+        if self.http_port is not None:
+            registry = self.registry
+
+            class MetricsHandler(BaseHTTPRequestHandler):
+                def do_GET(self) -> None:
+                    if self.path.split("?")[0] != "/metrics":
+                        self.send_error(404)
+                        return
+                    body = registry.render().encode("utf-8")
+                    self.send_response(200)
+                    self.send_header("Content-Type", "text/plain; version=0.0.4")
+                    self.send_header("Content-Length", str(len(body)))
+                    self.end_headers()
+                    self.wfile.write(body)
+
+                def log_message(self, format: str, *args) -> None:
+                    # Scrapes are not worth logging
+                    pass
+
+            self._http_server = ThreadingHTTPServer(
+                ("127.0.0.1", self.http_port), MetricsHandler
+            )
+            threading.Thread(
+                target=self._http_server.serve_forever,
+                name="metrics-http",
+                daemon=True,
+            ).start()
+
+    def _write_periodically(self) -> None:
+        while not self._stop_event.wait(self.interval):
+            self.write_textfile()
+
+    def stop(self) -> None:
+        """Stop the exporter, after a final rewrite of the textfile."""
+        self._stop_event.set()
+        if self._writer_thread is not None:
+            self._writer_thread.join()
+        self.write_textfile()
+        if self._http_server is not None:
+            self._http_server.shutdown()
+            self._http_server.server_close()
+
+
+# The registry shared by all the measured modules of a process
+METRICS = MetricsRegistry()
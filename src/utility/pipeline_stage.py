@@ -0,0 +1,56 @@
+"""Instrumentation of the stages of the analysis pipeline.
+
+A stage of the pipeline (e.g., parsing the files or building the call graph) is
+timed by STAGE_TIMER, recorded as a span by TRACER, and ends with a checkpoint of
+MEMORY_PROFILER. pipeline_stage does the three at once, so that the stages are
+instrumented alike; each of them is a no-op unless it is enabled.
+"""
+
+import time
+from contextlib import contextmanager
+from typing import Any, Iterator, Optional
+
+from memory.IR.U6IR import U6IR
+from utility.memory_profiler import MEMORY_PROFILER
+from utility.stage_timer import STAGE_TIMER
+from utility.tracer import TRACER, TraceSpan
+
+
+class PipelineStage:
+    """Stage being run, whose wall time is set once it ends."""
+
+    def __init__(self, span: TraceSpan) -> None:
+        """Initialize a stage.
+
+        Args:
+            span: Span recording the stage, which arguments can be added to
+        """
+        self.span = span
+        self.wall_time = 0.0
+
+
+@contextmanager
+def pipeline_stage(
+    name: str, category: str, u6ir: Optional[U6IR] = None, **args: Any
+) -> Iterator[PipelineStage]:
+    """Run the enclosed block as a stage of the pipeline.
+
+    The memory checkpoint is taken only if the block completes, as the memory of
+    a failed stage is not representative.
+
+    Args:
+        name: Name of the stage
+        category: Category of the span of the stage
+        u6ir: IR measured by the memory checkpoint at the end of the stage, if any
+        args: Initial arguments of the span
+
+    Yields:
+        The stage, whose wall time is set after the block
+    """
+    start_time = time.perf_counter()
+    with STAGE_TIMER.stage(name):
+        with TRACER.span(name, category, **args) as span:
+            stage = PipelineStage(span)
+            yield stage
+    stage.wall_time = time.perf_counter() - start_time
+    MEMORY_PROFILER.checkpoint(name, *((u6ir,) if u6ir is not None else ()))
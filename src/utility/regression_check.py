@@ -0,0 +1,432 @@
+"""Regression check of the cost and accuracy of slicing against a stored baseline.
+
+The benchmark slice requests are run by reposlice.py while it replays a recorded
+LLM trace (see llmtool/LLM_trace.py), so that the runs are reproducible and do not
+query any LLM. The wall time, LLM queries, tokens, peak RSS and F1 score of each
+request are compared with a baseline JSON file, and the check fails if any metric
+is worse than its baseline by more than its tolerance, or if a request has no
+baseline.
+
+The baseline and the trace are recorded together, with the deterministic mock
+model by default, in an environment with the tree-sitter grammars:
+
+    python -m utility.regression_check --record-trace --update-baseline
+
+and are to be committed together under benchmark/Cpp/regression/. The check fails
+until they are.
+"""
+
+import json
+import os
+import statistics
+import sys
+from pathlib import Path
+from typing import Dict, List
+
+from utility.judger import judge_slice_result, load_json_file
+from utility.stage_benchmark import run_single_benchmark
+
+BASE_PATH = Path(__file__).resolve().parents[2]
+REGRESSION_PATH = BASE_PATH / "benchmark" / "Cpp" / "regression"
+DEFAULT_LLM_TRACE_PATH = "benchmark/Cpp/regression/llm_trace.jsonl"
+
+# Maps the checked metrics to whether a higher value is better
+METRIC_DIRECTIONS = {
+    "wall_time": False,
+    "llm_query_num": False,
+    "input_token_cost": False,
+    "output_token_cost": False,
+    "peak_rss_bytes": False,
+    "f1_score": True,
+}
+
+# A metric regresses if it is worse than its baseline by more than
+# max(relative * |baseline|, absolute). Replayed runs ask the same queries, so
+# the LLM costs and the F1 score have no slack, unlike the timing and memory.
+DEFAULT_TOLERANCES = {
+    "wall_time": {"relative": 0.3, "absolute": 0.5},
+    "llm_query_num": {"relative": 0.0, "absolute": 0},
+    "input_token_cost": {"relative": 0.0, "absolute": 0},
+    "output_token_cost": {"relative": 0.0, "absolute": 0},
+    "peak_rss_bytes": {"relative": 0.15, "absolute": 8 * 2**20},
+    "f1_score": {"relative": 0.0, "absolute": 0.001},
+}
+
+
+def _to_base_relative_path(path: str) -> str:
+    """Make a path relative to the project root if it is inside it."""
+    try:
+        return str(Path(path).resolve().relative_to(BASE_PATH))
+    except ValueError:
+        return str(path)
+
+
+def measure_request(
+    slice_request_path: str,
+    llm_trace_path: str,
+    oracle_dir: str,
+    model_name: str,
+    repeat: int,
+    call_depth: int,
+    max_symbolic_workers: int,
+) -> Dict:
+    """Run a slice request against the recorded LLM trace and measure its metrics.
+
+    Args:
+        slice_request_path: Path to the slice request JSON file
+        llm_trace_path: Path of the recorded LLM trace to replay
+        oracle_dir: Directory containing oracle files
+        model_name: Name of the model the trace was recorded with
+        repeat: Number of runs of the slice request
+        call_depth: Call depth setting
+        max_symbolic_workers: Max symbolic workers for parsing-based analysis
+
+    Returns:
+        Dictionary mapping the metric names to their medians over the runs (the
+        maximum for the peak RSS). The F1 score is None if there is no oracle.
+    """
+    runs: List[Dict] = []
+    for _ in range(repeat):
+        stage_timing = run_single_benchmark(
+            slice_request_path,
+            model_name,
+            call_depth,
+            max_symbolic_workers,
+            ["--llm-replay-path", llm_trace_path],
+        )
+        slicing_request_id = stage_timing["slicing_request_ids"][0]
+        result_json_path = os.path.join(
+            stage_timing["result_dir_paths"][0],
+            f"slice_info_{slicing_request_id}.json",
+        )
+        cost = load_json_file(result_json_path).get("cost", {})
+        f1_score = None
+        if os.path.exists(os.path.join(oracle_dir, f"{slicing_request_id}.json")):
+            judgment = judge_slice_result(
+                slicing_request_id, result_json_path, oracle_dir
+            )
+            f1_score = judgment["overall_metrics"]["f1_score"]
+        runs.append(
+            {
+                "wall_time": stage_timing["wall_time"],
+                "llm_query_num": cost.get("llm_query_num", 0),
+                "input_token_cost": cost.get("input_token_cost", 0),
+                "output_token_cost": cost.get("output_token_cost", 0),
+                "peak_rss_bytes": stage_timing["peak_rss_bytes"],
+                "f1_score": f1_score,
+            }
+        )
+
+    metrics = {
+        name: statistics.median(run[name] for run in runs)
+        for name in METRIC_DIRECTIONS
+        if name not in ["peak_rss_bytes", "f1_score"]
+    }
+    metrics["peak_rss_bytes"] = max(run["peak_rss_bytes"] for run in runs)
+    f1_scores = [run["f1_score"] for run in runs if run["f1_score"] is not None]
+    metrics["f1_score"] = statistics.median(f1_scores) if f1_scores else None
+    return metrics
+
+
+def compare_metrics(
+    baseline_metrics: Dict, current_metrics: Dict, tolerances: Dict
+) -> List[Dict]:
+    """Compare the metrics of a request with their baseline.
+
+    Args:
+        baseline_metrics: Baseline metrics of the request
+        current_metrics: Measured metrics of the request
+        tolerances: Tolerances of the metrics (see DEFAULT_TOLERANCES)
+
+    Returns:
+        List of the comparisons of the metrics measured in both, each containing
+        the values, the change and whether the metric regressed
+    """
+    comparisons: List[Dict] = []
+    for name, is_higher_better in METRIC_DIRECTIONS.items():
+        baseline = baseline_metrics.get(name)
+        current = current_metrics.get(name)
+        if baseline is None or current is None:
+            continue
+        tolerance = tolerances.get(name, DEFAULT_TOLERANCES[name])
+        allowed_change = max(
+            tolerance.get("relative", 0.0) * abs(baseline),
+            tolerance.get("absolute", 0),
+        )
+        worsening = baseline - current if is_higher_better else current - baseline
+        relative_change = (current - baseline) / baseline if baseline else None
+        comparisons.append(
+            {
+                "metric": name,
+                "baseline": baseline,
+                "current": current,
+                "change": current - baseline,
+                "relative_change": relative_change,
+                "allowed_change": allowed_change,
+                "is_regressed": worsening > allowed_change,
+            }
+        )
+    return comparisons
+
+
+def check_regressions(baseline: Dict, current_requests: Dict) -> Dict:
+    """Compare the measured requests with the baseline.
+
+    Args:
+        baseline: Baseline report, containing the tolerances and the requests
+        current_requests: Dictionary mapping the request names to the measured
+            metrics
+
+    Returns:
+        Dictionary containing the comparisons of each request, the requests
+        missing from the measured ones or from the baseline, and whether the
+        check failed, i.e., a metric regressed or a request is unchecked
+    """
+    tolerances = {**DEFAULT_TOLERANCES, **baseline.get("tolerances", {})}
+    baseline_requests = baseline.get("requests", {})
+    comparisons = {
+        name: compare_metrics(
+            baseline_requests[name]["metrics"], current_requests[name], tolerances
+        )
+        for name in sorted(baseline_requests)
+        if name in current_requests
+    }
+    missing_requests = sorted(set(baseline_requests) - set(current_requests))
+    new_requests = sorted(set(current_requests) - set(baseline_requests))
+    # A request without a baseline is unchecked, so it fails the check too, as an
+    # empty baseline would otherwise pass any run
+    is_regressed = bool(missing_requests) or bool(new_requests) or any(
+        comparison["is_regressed"]
+        for request_comparisons in comparisons.values()
+        for comparison in request_comparisons
+    )
+    return {
+        "comparisons": comparisons,
+        "missing_requests": missing_requests,
+        "new_requests": new_requests,
+        "is_regressed": is_regressed,
+    }
+
+
+def _format_metric_value(name: str, value: float) -> str:
+    """Format a metric value for the diff."""
+    if name == "peak_rss_bytes":
+        return f"{value / 2**20:.1f}MB"
+    if isinstance(value, float) and not value.is_integer():
+        return f"{value:.3f}"
+    if isinstance(value, float):
+        return str(int(value))
+    return str(value)
+
+
+def format_diff(result: Dict) -> str:
+    """Format the result of a regression check as a readable diff.
+
+    Args:
+        result: Result returned by check_regressions
+
+    Returns:
+        The diff, marking the regressed metrics with "!"
+    """
+    lines: List[str] = []
+    for name, comparisons in result["comparisons"].items():
+        lines.append(name)
+        for comparison in comparisons:
+            metric = comparison["metric"]
+            relative_change = comparison["relative_change"]
+            change = (
+                f"{relative_change:+.1%}"
+                if relative_change is not None
+                else f"{comparison['change']:+g}"
+            )
+            lines.append(
+                f"{'!' if comparison['is_regressed'] else ' '} {metric:<20} "
+                f"{_format_metric_value(metric, comparison['baseline']):>10} -> "
+                f"{_format_metric_value(metric, comparison['current']):>10} "
+                f"({change}, allowed "
+                f"{_format_metric_value(metric, comparison['allowed_change'])})"
+            )
+    for name in result["missing_requests"]:
+        lines.append(f"! {name}: in the baseline but not measured")
+    for name in result["new_requests"]:
+        lines.append(f"! {name}: no baseline (run with --update-baseline)")
+    return "\n".join(lines)
+
+
+def main():
+    """Main function for command-line usage."""
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        description="Check the slicing cost and accuracy against a stored baseline"
+    )
+    parser.add_argument(
+        "slice_request_paths",
+        nargs="*",
+        help="Slice request files (default: benchmark/Cpp/slice/*.json)",
+    )
+    parser.add_argument(
+        "--baseline",
+        default=str(REGRESSION_PATH / "baseline.json"),
+        help="Baseline JSON file (default: benchmark/Cpp/regression/baseline.json)",
+    )
+    parser.add_argument(
+        "--llm-trace",
+        default=None,
+        help="Recorded LLM trace to replay (default: the one of the baseline)",
+    )
+    parser.add_argument(
+        "--oracle-dir",
+        default=str(BASE_PATH / "oracle"),
+        help="Directory containing oracle files (default: oracle/ in project root)",
+    )
+    parser.add_argument(
+        "--repeat", type=int, default=3, help="Number of runs per slice request"
+    )
+    parser.add_argument(
+        "--max-symbolic-workers",
+        type=int,
+        default=10,
+        help="Max symbolic workers for parsing-based analysis",
+    )
+    parser.add_argument(
+        "--tolerance",
+        action="append",
+        default=[],
+        metavar="METRIC=RELATIVE[,ABSOLUTE]",
+        help="Override the tolerance of a metric, e.g., wall_time=0.5,1.0 (stored "
+        "in the baseline with --update-baseline)",
+    )
+    parser.add_argument(
+        "--record-trace",
+        action="store_true",
+        help="Record the LLM trace again by querying the model of the baseline",
+    )
+    parser.add_argument(
+        "--update-baseline",
+        action="store_true",
+        help="Store the measured metrics as the new baseline instead of checking",
+    )
+    parser.add_argument(
+        "--output", default=None, help="Path to write the JSON report to"
+    )
+    args = parser.parse_args()
+
+    baseline: Dict = {}
+    if os.path.exists(args.baseline):
+        baseline = load_json_file(args.baseline)
+    model_name = baseline.get("model_name", "mock")
+    call_depth = baseline.get("call_depth", 10)
+    llm_trace_path = args.llm_trace or str(
+        BASE_PATH / baseline.get("llm_trace_path", DEFAULT_LLM_TRACE_PATH)
+    )
+
+    tolerances = baseline.setdefault("tolerances", {})
+    for tolerance in args.tolerance:
+        name, _, values = tolerance.partition("=")
+        if name not in METRIC_DIRECTIONS or not values:
+            parser.error(f"Invalid tolerance {tolerance}")
+        relative, _, absolute = values.partition(",")
+        tolerances[name] = {
+            "relative": float(relative),
+            "absolute": float(absolute) if absolute else 0,
+        }
+
+    slice_request_paths: List[str] = args.slice_request_paths or sorted(
+        str(path) for path in (BASE_PATH / "benchmark/Cpp/slice").glob("*.json")
+    )
+    slice_request_paths = [str(Path(path).resolve()) for path in slice_request_paths]
+
+    if not args.update_baseline and not baseline.get("requests"):
+        print(
+            f"Error: The baseline {args.baseline} does not exist or has no "
+            "requests; record it with --record-trace --update-baseline",
+            file=sys.stderr,
+        )
+        sys.exit(1)
+    if not args.record_trace and not os.path.exists(llm_trace_path):
+        print(
+            f"Error: The LLM trace {llm_trace_path} does not exist; record it with "
+            "--record-trace",
+            file=sys.stderr,
+        )
+        sys.exit(1)
+
+    current_requests: Dict[str, Dict] = {}
+    try:
+        if args.record_trace:
+            # The answers are appended, so the trace is recorded from scratch
+            if os.path.exists(llm_trace_path):
+                os.remove(llm_trace_path)
+            Path(llm_trace_path).parent.mkdir(parents=True, exist_ok=True)
+            for slice_request_path in slice_request_paths:
+                run_single_benchmark(
+                    slice_request_path,
+                    model_name,
+                    call_depth,
+                    args.max_symbolic_workers,
+                    ["--llm-record-path", llm_trace_path],
+                )
+            print(f"The LLM trace is recorded in {llm_trace_path}")
+
+        for slice_request_path in slice_request_paths:
+            current_requests[Path(slice_request_path).stem] = measure_request(
+                slice_request_path,
+                llm_trace_path,
+                args.oracle_dir,
+                model_name,
+                args.repeat,
+                call_depth,
+                args.max_symbolic_workers,
+            )
+    except Exception as e:
+        print(f"Error: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    baseline_requests = baseline.setdefault("requests", {})
+    if args.update_baseline:
+        baseline.update(
+            {
+                "model_name": model_name,
+                "call_depth": call_depth,
+                "llm_trace_path": _to_base_relative_path(llm_trace_path),
+                "python_version": sys.version.split()[0],
+            }
+        )
+        for name, path in zip(current_requests, slice_request_paths):
+            baseline_requests[name] = {
+                "slice_request_path": _to_base_relative_path(path),
+                "metrics": current_requests[name],
+            }
+        Path(args.baseline).parent.mkdir(parents=True, exist_ok=True)
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=4)
+        print(f"The baseline is saved in {args.baseline}")
+        return
+
+    if args.slice_request_paths:
+        # Only the given requests are checked, so the other ones are not missing
+        baseline["requests"] = {
+            name: request
+            for name, request in baseline_requests.items()
+            if name in current_requests
+        }
+    result = check_regressions(baseline, current_requests)
+    print(format_diff(result))
+    if args.output is not None:
+        with open(args.output, "w", encoding="utf-8") as f:
+            json.dump({"requests": current_requests, **result}, f, indent=2)
+        print(f"The report is saved in {args.output}")
+
+    if result["is_regressed"]:
+        print(
+            "Regression check failed: some metrics regressed or some requests are "
+            "unchecked",
+            file=sys.stderr,
+        )
+        sys.exit(1)
+    print("Regression check passed")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,60 +1,160 @@
 from pathlib import Path
+from typing import Callable, List, Optional, Tuple
+
 from utility.errors import RARequestError
 
 
+class SliceSeed:
+    """Represents one seed of a slice request, i.e., a variable at a location."""
+
+    def __init__(self, file_path: str, seed_line_number: int, seed_name: str) -> None:
+        """Initialize a SliceSeed object.
+
+        Args:
+            file_path: Path to the source file containing the seed
+            seed_line_number: Line number of the seed in the file
+            seed_name: Variable or expression of the seed
+        """
+        self.file_path = file_path
+        self.seed_line_number = seed_line_number
+        self.seed_name = seed_name
+
+    def __str__(self) -> str:
+        """Generate string representation of the seed.
+
+        Returns:
+            String containing all seed attributes in readable format
+        """
+        return (
+            f"SliceSeed(file_path='{self.file_path}', "
+            f"seed_line_number={self.seed_line_number}, "
+            f"seed_name='{self.seed_name}')"
+        )
+
+    def __repr__(self) -> str:
+        """Return string representation for debugging.
+
+        Returns:
+            String representation of the seed
+        """
+        return self.__str__()
+
+    def to_tuple(self) -> Tuple[str, int, str]:
+        """Convert the seed into a tuple used for comparison and hashing.
+
+        Returns:
+            Tuple of file path, seed line number and seed name
+        """
+        return (self.file_path, self.seed_line_number, self.seed_name)
+
+    def to_dict(self) -> dict:
+        """Convert SliceSeed object to dictionary representation.
+
+        Returns:
+            Dictionary containing seed metadata
+        """
+        return {
+            "file_path": self.file_path,
+            "seed_line_number": self.seed_line_number,
+            "seed_name": self.seed_name,
+        }
+
+
 class SliceRequest:
     """Represents a request for program slicing with seed information.
 
     This class encapsulates all necessary information to perform program slicing:
-    - Project path: The project path containing the source file
-    - File path: The source file containing the seed
-    - Seed line number: The line number where slicing should start
-    - Seed name: The variable/expression name to slice from
+    - Project path: The project path containing the source files
+    - Seeds: The variables/expressions to slice from. Each seed consists of
+      the source file, the line number and the name of the seed.
+      The slice of a request with multiple seeds is the union of the seeds' slices.
     - Is backward: Whether to perform backward slicing (True) or forward slicing (False)
+    - Tenant: The tenant (e.g., a team) whose LLM budget the request is charged to
+
+    For requests with a single seed, file_path, seed_line_number and seed_name
+    give direct access to the seed.
     """
 
     def __init__(
         self,
         slicing_request_id: str,
         project_path: str,
-        file_path: str,
-        seed_line_number: int,
-        seed_name: str,
+        seeds: List[SliceSeed],
         is_backward: bool = True,
+        tenant: Optional[str] = None,
     ) -> None:
         """Initialize a SliceRequest object.
 
         Args:
             slicing_request_id: The ID of the slicing request
-            project_path: Path to the project containing the source file
-            file_path: Path to the source file containing the slicing seed
-            seed_line_number: Line number of the slicing seed in the file
-            seed_name: Variable or expression of the slicing seed
+            project_path: Path to the project containing the source files
+            seeds: Seeds of the slicing request
             is_backward: Perform backward slicing if True; forward slicing if False (default: True)
+            tenant: Tenant of the request, or None to use the request ID as tenant
 
         Raises:
             RARequestError: If any parameter validation fails
         """
-        self._validate_parameters(project_path, file_path, seed_line_number, seed_name)
+        self._validate_project_path(project_path)
+        if not seeds:
+            raise RARequestError("seeds must be a non-empty list")
+        for seed in seeds:
+            self._validate_seed(
+                project_path, seed.file_path, seed.seed_line_number, seed.seed_name
+            )
 
         self.slicing_request_id = slicing_request_id
         self.project_path = project_path.strip()
-        self.file_path = file_path.strip()
-        self.seed_line_number = seed_line_number
-        self.seed_name = seed_name.strip()
+        self.seeds = [
+            SliceSeed(
+                seed.file_path.strip(), seed.seed_line_number, seed.seed_name.strip()
+            )
+            for seed in seeds
+        ]
         self.is_backward = is_backward
+        self.tenant = tenant if tenant is not None else slicing_request_id
 
-    def _validate_parameters(
+    @property
+    def file_path(self) -> str:
+        """The source file of the first seed."""
+        return self.seeds[0].file_path
+
+    @property
+    def seed_line_number(self) -> int:
+        """The line number of the first seed."""
+        return self.seeds[0].seed_line_number
+
+    @property
+    def seed_name(self) -> str:
+        """The name of the first seed."""
+        return self.seeds[0].seed_name
+
+    def _validate_project_path(self, project_path: str) -> None:
+        """Validate the project path of SliceRequest.
+
+        Args:
+            project_path: The project path to validate
+
+        Raises:
+            RARequestError: If the project path is invalid
+        """
+        if not isinstance(project_path, str) or not project_path.strip():
+            raise RARequestError("project_path must be a non-empty string")
+
+        if not Path(project_path).exists():
+            raise RARequestError("project_path does not exist")
+
+    def _validate_seed(
         self,
         project_path: str,
         file_path: str,
         seed_line_number: int,
         seed_name: str,
     ) -> None:
-        """Validate the input parameters for SliceRequest.
+        """Validate the parameters of a seed.
 
         Args:
-            project_path: The project path to validate
+            project_path: The project path containing the seed
             file_path: The file path to validate
             seed_line_number: The seed line number to validate
             seed_name: The seed name to validate
@@ -62,12 +162,6 @@ class SliceRequest:
         Raises:
             RARequestError: If any parameter is invalid
         """
-        if not isinstance(project_path, str) or not project_path.strip():
-            raise RARequestError("project_path must be a non-empty string")
-
-        if not Path(project_path).exists():
-            raise RARequestError("project_path does not exist")
-
         if not isinstance(file_path, str) or not file_path.strip():
             raise RARequestError("file_path must be a non-empty string")
 
@@ -97,9 +191,7 @@ class SliceRequest:
         return (
             f"SliceRequest(slicing_request_id='{self.slicing_request_id}', "
             f"project_path='{self.project_path}', "
-            f"file_path='{self.file_path}', "
-            f"seed_line_number={self.seed_line_number}, "
-            f"seed_name='{self.seed_name}', "
+            f"seeds={self.seeds}, "
             f"is_backward={self.is_backward})"
         )
 
@@ -116,9 +208,8 @@ class SliceRequest:
             return NotImplemented
         return (
             self.slicing_request_id == other.slicing_request_id
-            and self.seed_line_number == other.seed_line_number
-            and self.seed_name == other.seed_name
-            and self.file_path == other.file_path
+            and [seed.to_tuple() for seed in self.seeds]
+            == [seed.to_tuple() for seed in other.seeds]
             and self.is_backward == other.is_backward
         )
 
@@ -139,9 +230,7 @@ class SliceRequest:
         return hash(
             (
                 self.slicing_request_id,
-                self.seed_line_number,
-                self.seed_name,
-                self.file_path,
+                tuple(seed.to_tuple() for seed in self.seeds),
                 self.is_backward,
             )
         )
@@ -149,16 +238,78 @@ class SliceRequest:
     def to_dict(self) -> dict:
         """Convert SliceRequest object to dictionary representation.
 
+        The keys of the single-seed format hold the first seed, so the consumers
+        of that format still read single-seed requests unchanged. The seeds of a
+        request with several seeds are listed under "seeds" as well.
+
         Returns:
             Dictionary containing slice request metadata
         """
-        return {
+        request_dict = {
             "slicing_request_id": self.slicing_request_id,
             "seed_line_number": self.seed_line_number,
             "seed_name": self.seed_name,
             "file_path": self.file_path,
             "is_backward": self.is_backward,
+            "tenant": self.tenant,
         }
+        if len(self.seeds) > 1:
+            request_dict["seeds"] = [seed.to_dict() for seed in self.seeds]
+        return request_dict
+
+    def relocate(
+        self,
+        project_path: str,
+        map_line: Optional[Callable[[str, int], Optional[int]]] = None,
+    ) -> "SliceRequest":
+        """Create the same request against another copy of the project.
+
+        This is used to issue one request against different revisions of a
+        project, which are checked out into separate directories.
+
+        Args:
+            project_path: Path to the other copy of the project
+            map_line: Maps a file path relative to the project and a seed line
+                number to the line number in the other copy, or to None if the
+                line is changed there (see utility/revision.py), or None if the
+                copies have the same lines
+
+        Returns:
+            SliceRequest whose project and file paths point into project_path
+
+        Raises:
+            RARequestError: If a seed file does not exist in the other copy, or a
+                seed line is changed there
+        """
+        relocated_seeds = []
+        for seed in self.seeds:
+            relative_file_path = Path(seed.file_path).resolve().relative_to(
+                Path(self.project_path).resolve()
+            )
+            seed_line_number: Optional[int] = seed.seed_line_number
+            if map_line is not None:
+                seed_line_number = map_line(
+                    relative_file_path.as_posix(), seed.seed_line_number
+                )
+                if seed_line_number is None:
+                    raise RARequestError(
+                        f"The seed line {seed.seed_line_number} of "
+                        f"{relative_file_path} is changed in {project_path}"
+                    )
+            relocated_seeds.append(
+                SliceSeed(
+                    str(Path(project_path) / relative_file_path),
+                    seed_line_number,
+                    seed.seed_name,
+                )
+            )
+        return SliceRequest(
+            slicing_request_id=self.slicing_request_id,
+            project_path=project_path,
+            seeds=relocated_seeds,
+            is_backward=self.is_backward,
+            tenant=self.tenant,
+        )
 
     def description(self) -> str:
         """Generate human-readable description of the slice request.
@@ -167,10 +318,12 @@ class SliceRequest:
             Descriptive string about the slice request
         """
         slice_type = "backward" if self.is_backward else "forward"
-        desc = (
-            f"{slice_type.capitalize()} slice request for variable '{self.seed_name}' "
-            f"at line {self.seed_line_number} in file '{self.file_path}' "
-        )
+        seed_descs = [
+            f"variable '{seed.seed_name}' at line {seed.seed_line_number} "
+            f"in file '{seed.file_path}'"
+            for seed in self.seeds
+        ]
+        desc = f"{slice_type.capitalize()} slice request for " + "; ".join(seed_descs)
 
         return desc
 
@@ -178,6 +331,9 @@ class SliceRequest:
     def from_dict(cls, data: dict) -> "SliceRequest":
         """Create SliceRequest from dictionary representation.
 
+        A request either lists its seeds under the key "seeds", or describes a
+        single seed with the keys "file_path", "seed_line_number" and "seed_name".
+
         Args:
             data: Dictionary containing slice request data
 
@@ -187,12 +343,11 @@ class SliceRequest:
         Raises:
             RARequestError: If required keys are missing or invalid
         """
-        required_keys = {
-            "slicing_request_id",
-            "seed_line_number",
-            "seed_name",
-            "file_path",
-        }
+        seed_keys = {"seed_line_number", "seed_name", "file_path"}
+        if "seeds" in data:
+            required_keys = {"slicing_request_id", "seeds"}
+        else:
+            required_keys = {"slicing_request_id"} | seed_keys
         missing_keys = required_keys - set(data.keys())
 
         if missing_keys:
@@ -200,11 +355,24 @@ class SliceRequest:
 
         BASE_PATH = Path(__file__).resolve().parents[2]
 
+        seed_dicts = data["seeds"] if "seeds" in data else [data]
+        seeds = []
+        for seed_dict in seed_dicts:
+            missing_seed_keys = seed_keys - set(seed_dict.keys())
+            if missing_seed_keys:
+                raise RARequestError(f"Missing required seed keys: {missing_seed_keys}")
+            seeds.append(
+                SliceSeed(
+                    file_path=str(Path(BASE_PATH) / Path(seed_dict["file_path"])),
+                    seed_line_number=seed_dict["seed_line_number"],
+                    seed_name=seed_dict["seed_name"],
+                )
+            )
+
         return cls(
             slicing_request_id=data["slicing_request_id"],
             project_path=str(Path(BASE_PATH) / Path(data["project_path"])),
-            file_path=str(Path(BASE_PATH) / Path(data["file_path"])),
-            seed_line_number=data["seed_line_number"],
-            seed_name=data["seed_name"],
+            seeds=seeds,
             is_backward=data.get("is_backward", True),
+            tenant=data.get("tenant"),
         )
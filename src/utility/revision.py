@@ -0,0 +1,191 @@
+"""Helpers for materializing git revisions of a project on disk."""
+
+import re
+import subprocess
+import tarfile
+from pathlib import Path
+from typing import Callable, Dict, List, Optional, Tuple
+
+from utility.errors import RAValueError
+
+# Matches the header of a hunk of a unified diff, e.g., "@@ -12,3 +12,5 @@"
+HUNK_HEADER_PATTERN = re.compile(
+    r"^@@ -(\d+)(?:,(\d+))? \+(\d+)(?:,(\d+))? @@", re.MULTILINE
+)
+
+# A hunk is (first old line, old line count, first new line, new line count),
+# where the first line of an empty range is the line after it
+Hunk = Tuple[int, int, int, int]
+
+
+def get_git_toplevel(path: str) -> Path:
+    """Get the root directory of the git repository containing a path.
+
+    Args:
+        path: A file or directory inside the repository
+
+    Returns:
+        Absolute path of the repository root
+
+    Raises:
+        RAValueError: If the path is not inside a git repository
+    """
+    directory = Path(path) if Path(path).is_dir() else Path(path).parent
+    try:
+        output = subprocess.run(
+            ["git", "-C", str(directory), "rev-parse", "--show-toplevel"],
+            check=True,
+            capture_output=True,
+            text=True,
+        ).stdout
+    except (OSError, subprocess.CalledProcessError) as e:
+        raise RAValueError(f"{path} is not inside a git repository: {e}")
+    return Path(output.strip()).resolve()
+
+
+def checkout_revision(project_path: str, revision: str, dest_dir: str) -> str:
+    """Export a revision of a project into a directory without touching the worktree.
+
+    Only the project subtree is exported (via `git archive`), so the cost is
+    proportional to the size of the project rather than the whole repository.
+
+    Args:
+        project_path: Path to the project inside a git repository
+        revision: Any git revision (commit, tag, branch, ...)
+        dest_dir: Directory receiving the exported files
+
+    Returns:
+        Path of the project inside dest_dir
+
+    Raises:
+        RAValueError: If the revision cannot be exported
+    """
+    toplevel = get_git_toplevel(project_path)
+    relative_project_path = Path(project_path).resolve().relative_to(toplevel)
+
+    command = ["git", "-C", str(toplevel), "archive", "--format=tar", revision]
+    if str(relative_project_path) != ".":
+        command.append(relative_project_path.as_posix())
+
+    process = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert process.stdout is not None
+    extract_error = ""
+    try:
+        with tarfile.open(fileobj=process.stdout, mode="r|") as archive:
+            # Reject the members escaping dest_dir (absolute paths, "..", links)
+            archive.extractall(dest_dir, filter="data")
+    except tarfile.TarError as e:
+        extract_error = str(e)
+    _, stderr = process.communicate()
+    if process.returncode != 0 or extract_error:
+        message = stderr.decode(errors="ignore").strip() or extract_error
+        raise RAValueError(f"Cannot export revision {revision}: {message}")
+    return str(Path(dest_dir) / relative_project_path)
+
+
+def get_changed_hunks(
+    file_path: str, base_revision: str, head_revision: str
+) -> List[Hunk]:
+    """Get the hunks of the changes of a file between two revisions.
+
+    Args:
+        file_path: Path of the file in the worktree of a git repository
+        base_revision: Revision the hunks apply to
+        head_revision: Revision the hunks lead to
+
+    Returns:
+        The hunks in order
+
+    Raises:
+        RAValueError: If the diff cannot be computed
+    """
+    toplevel = get_git_toplevel(file_path)
+    relative_file_path = Path(file_path).resolve().relative_to(toplevel)
+    try:
+        output = subprocess.run(
+            [
+                "git",
+                "-C",
+                str(toplevel),
+                "diff",
+                "--no-ext-diff",
+                "--no-color",
+                "-U0",
+                base_revision,
+                head_revision,
+                "--",
+                relative_file_path.as_posix(),
+            ],
+            check=True,
+            capture_output=True,
+            text=True,
+        ).stdout
+    except (OSError, subprocess.CalledProcessError) as e:
+        raise RAValueError(f"Cannot diff {file_path}: {e}")
+
+    hunks: List[Hunk] = []
+    for match in HUNK_HEADER_PATTERN.finditer(output):
+        old_start, old_count, new_start, new_count = (
+            int(group) if group is not None else 1 for group in match.groups()
+        )
+        # git gives the line before an empty range
+        if old_count == 0:
+            old_start += 1
+        if new_count == 0:
+            new_start += 1
+        hunks.append((old_start, old_count, new_start, new_count))
+    return hunks
+
+
+def map_line_number(hunks: List[Hunk], line_number: int) -> Optional[int]:
+    """Map a line of the base revision of a file to its head revision.
+
+    Args:
+        hunks: Hunks of the changes of the file (see get_changed_hunks)
+        line_number: Line number in the base revision
+
+    Returns:
+        The line number in the head revision, or None if the line is removed or
+        changed by a hunk that does not keep the line count
+    """
+    offset = 0
+    for old_start, old_count, new_start, new_count in hunks:
+        if line_number < old_start:
+            break
+        if line_number < old_start + old_count:
+            # A line edited in place keeps its position in the hunk
+            if old_count != new_count:
+                return None
+            return new_start + line_number - old_start
+        offset = new_start + new_count - old_start - old_count
+    return line_number + offset
+
+
+def get_line_mapper(
+    project_path: str, base_revision: str, head_revision: str
+) -> Callable[[str, int], Optional[int]]:
+    """Get the mapping of the lines of a project from a revision to another.
+
+    Args:
+        project_path: Path to the project inside a git repository
+        base_revision: Revision the lines are in
+        head_revision: Revision the lines are mapped to
+
+    Returns:
+        Function mapping a file path relative to the project and a line number
+        in the base revision to the line number in the head revision, or None if
+        the line is changed (see map_line_number)
+    """
+    # Maps relative file paths -> hunks of their changes
+    hunks_by_file: Dict[str, List[Hunk]] = {}
+
+    def map_line(relative_file_path: str, line_number: int) -> Optional[int]:
+        if relative_file_path not in hunks_by_file:
+            hunks_by_file[relative_file_path] = get_changed_hunks(
+                str(Path(project_path) / relative_file_path),
+                base_revision,
+                head_revision,
+            )
+        return map_line_number(hunks_by_file[relative_file_path], line_number)
+
+    return map_line
@@ -0,0 +1,229 @@
+"""End-to-end benchmark recording where the time of the slicing runs goes.
+
+Each slice request is run by reposlice.py in a fresh process against the
+deterministic mock LLM, so that the runs are reproducible and the peak RSS of a
+run is not inflated by the previous ones. The per-stage timings reported by the
+runs (see utility/stage_timer.py) are collected into one JSON report.
+"""
+
+import json
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+from typing import Dict, List, Optional
+
+BASE_PATH = Path(__file__).resolve().parents[2]
+SRC_PATH = BASE_PATH / "src"
+
+STAGE_NAMES = [
+    "traverse_files",
+    "parse_files",
+    "parse_functions",
+    "analyze_call_graph",
+    "prompt_rendering",
+    "llm_wait",
+    "response_parsing",
+    "worklist_bookkeeping",
+]
+
+
+def run_single_benchmark(
+    slice_request_path: str,
+    model_name: str,
+    call_depth: int,
+    max_symbolic_workers: int,
+    extra_args: Optional[List[str]] = None,
+    temperature: float = 0.0,
+) -> Dict:
+    """Run reposlice.py once on a slice request and collect its stage timings.
+
+    Args:
+        slice_request_path: Path to the slice request JSON file
+        model_name: Name of the (mock) model to query
+        call_depth: Call depth setting
+        max_symbolic_workers: Max symbolic workers for parsing-based analysis
+        extra_args: Additional arguments of reposlice.py (e.g., an LLM trace)
+        temperature: Temperature of the queries
+
+    Returns:
+        The stage timing report of the run
+
+    Raises:
+        RuntimeError: If the run fails
+    """
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        stage_timing_path = os.path.join(tmp_dir, "stage_timing.json")
+        command = [
+            sys.executable,
+            "reposlice.py",
+            "--slice-request-path",
+            slice_request_path,
+            "--language",
+            "Cpp",
+            "--audit-model-name",
+            model_name,
+            "--temperature",
+            str(temperature),
+            "--call-depth",
+            str(call_depth),
+            "--max-symbolic-workers",
+            str(max_symbolic_workers),
+            "--stage-timing-output",
+            stage_timing_path,
+        ] + (extra_args or [])
+        process = subprocess.run(command, cwd=SRC_PATH, capture_output=True, text=True)
+        if process.returncode != 0:
+            raise RuntimeError(
+                f"reposlice.py failed on {slice_request_path}:\n{process.stderr}"
+            )
+        with open(stage_timing_path, "r") as f:
+            return json.load(f)
+
+
+def summarize_runs(runs: List[Dict]) -> Dict:
+    """Summarize the repeated runs of one slice request by their medians.
+
+    Args:
+        runs: Stage timing reports of the runs
+
+    Returns:
+        Dictionary containing the median wall/CPU time of the run and of each stage,
+        and the maximum peak RSS
+    """
+    stages: Dict[str, Dict] = {}
+    for stage_name in STAGE_NAMES:
+        # A stage missing from a run (e.g., no LLM query) took no time in the run
+        stage_runs = [run["stages"].get(stage_name, {}) for run in runs]
+        stages[stage_name] = {
+            key: statistics.median(stage_run.get(key, 0) for stage_run in stage_runs)
+            for key in ["wall_time", "cpu_time", "call_num"]
+        }
+    return {
+        "wall_time": statistics.median(run["wall_time"] for run in runs),
+        "cpu_time": statistics.median(run["cpu_time"] for run in runs),
+        "peak_rss_bytes": max(run["peak_rss_bytes"] for run in runs),
+        "stages": stages,
+    }
+
+
+def run_benchmark(
+    slice_request_paths: List[str],
+    model_name: str = "mock",
+    repeat: int = 3,
+    call_depth: int = 10,
+    max_symbolic_workers: int = 10,
+) -> Dict:
+    """Run the benchmark on several slice requests.
+
+    Args:
+        slice_request_paths: Paths to the slice request JSON files
+        model_name: Name of the (mock) model to query
+        repeat: Number of runs of each slice request
+        call_depth: Call depth setting
+        max_symbolic_workers: Max symbolic workers for parsing-based analysis
+
+    Returns:
+        Report with the raw runs and the summary of each slice request
+    """
+    requests: Dict[str, Dict] = {}
+    for slice_request_path in slice_request_paths:
+        runs = []
+        for _ in range(repeat):
+            runs.append(
+                run_single_benchmark(
+                    slice_request_path, model_name, call_depth, max_symbolic_workers
+                )
+            )
+        requests[Path(slice_request_path).stem] = {
+            "slice_request_path": slice_request_path,
+            "summary": summarize_runs(runs),
+            "runs": runs,
+        }
+
+    return {
+        "timestamp": time.strftime("%Y-%m-%d-%H-%M-%S", time.localtime()),
+        "model_name": model_name,
+        "repeat": repeat,
+        "call_depth": call_depth,
+        "python_version": sys.version.split()[0],
+        "requests": requests,
+    }
+
+
+def main():
+    """Main function for command-line usage."""
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        description="Benchmark the stages of reposlice.py against a mock LLM"
+    )
+    parser.add_argument(
+        "slice_request_paths",
+        nargs="*",
+        help="Slice request files (default: benchmark/Cpp/slice/*.json)",
+    )
+    parser.add_argument(
+        "--model",
+        default="mock",
+        help='Mock model to query: "mock" or "mock-<latency in ms>" (default: mock)',
+    )
+    parser.add_argument(
+        "--repeat", type=int, default=3, help="Number of runs per slice request"
+    )
+    parser.add_argument("--call-depth", type=int, default=10, help="Call depth")
+    parser.add_argument(
+        "--max-symbolic-workers",
+        type=int,
+        default=10,
+        help="Max symbolic workers for parsing-based analysis",
+    )
+    parser.add_argument(
+        "--output",
+        default=None,
+        help="Path of the JSON report (default: result/benchmark/stage_timing_*.json)",
+    )
+    args = parser.parse_args()
+
+    slice_request_paths: List[str] = args.slice_request_paths or sorted(
+        str(path) for path in (BASE_PATH / "benchmark/Cpp/slice").glob("*.json")
+    )
+    slice_request_paths = [str(Path(path).resolve()) for path in slice_request_paths]
+
+    report = run_benchmark(
+        slice_request_paths,
+        args.model,
+        args.repeat,
+        args.call_depth,
+        args.max_symbolic_workers,
+    )
+
+    output: Optional[str] = args.output
+    if output is None:
+        output_dir = BASE_PATH / "result" / "benchmark"
+        output_dir.mkdir(parents=True, exist_ok=True)
+        output = str(output_dir / f"stage_timing_{report['timestamp']}.json")
+    with open(output, "w") as f:
+        json.dump(report, f, indent=4)
+
+    # Print the summary table
+    print(f"{'slice_request':<40} {'wall(s)':>8} {'cpu(s)':>8} {'rss(MB)':>8}")
+    for name, request in report["requests"].items():
+        summary = request["summary"]
+        print(
+            f"{name:<40} {summary['wall_time']:>8.3f} {summary['cpu_time']:>8.3f} "
+            f"{summary['peak_rss_bytes'] / 2**20:>8.1f}"
+        )
+        for stage_name, stage in summary["stages"].items():
+            print(
+                f"  {stage_name:<38} {stage['wall_time']:>8.3f} "
+                f"{stage['cpu_time']:>8.3f}"
+            )
+    print(f"The benchmark report is saved in {output}")
+
+
+if __name__ == "__main__":
+    main()
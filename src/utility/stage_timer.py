@@ -0,0 +1,92 @@
+"""Accumulation of the wall and CPU time spent in the stages of a run."""
+
+import resource
+import sys
+import threading
+import time
+from contextlib import contextmanager, nullcontext
+from typing import ContextManager, Dict, Iterator
+
+
+class StageTimer:
+    """Thread-safe accumulator of per-stage wall time, CPU time and call counts.
+
+    The timer is disabled by default, so that the instrumented stages cost a single
+    attribute check in normal runs. CPU time is the process CPU time elapsed during
+    a stage, so it includes the worker threads the stage waits for, and stages
+    running concurrently in several threads are each charged the shared CPU time.
+    """
+
+    def __init__(self) -> None:
+        self.is_enabled = False
+        self._lock = threading.Lock()
+        self._wall_times: Dict[str, float] = {}
+        self._cpu_times: Dict[str, float] = {}
+        self._call_nums: Dict[str, int] = {}
+
+    def enable(self) -> None:
+        """Enable the timer and reset the accumulated times."""
+        with self._lock:
+            self._wall_times = {}
+            self._cpu_times = {}
+            self._call_nums = {}
+            self.is_enabled = True
+
+    def disable(self) -> None:
+        """Disable the timer. The accumulated times are kept."""
+        self.is_enabled = False
+
+    def stage(self, name: str) -> ContextManager[None]:
+        """Time the enclosed block as one call of a stage.
+
+        Args:
+            name: Name of the stage
+
+        Returns:
+            Context manager timing the block if the timer is enabled
+        """
+        if not self.is_enabled:
+            return nullcontext()
+        return self._time_stage(name)
+
+    @contextmanager
+    def _time_stage(self, name: str) -> Iterator[None]:
+        start_wall_time = time.perf_counter()
+        start_cpu_time = time.process_time()
+        try:
+            yield
+        finally:
+            wall_time = time.perf_counter() - start_wall_time
+            cpu_time = time.process_time() - start_cpu_time
+            with self._lock:
+                self._wall_times[name] = self._wall_times.get(name, 0.0) + wall_time
+                self._cpu_times[name] = self._cpu_times.get(name, 0.0) + cpu_time
+                self._call_nums[name] = self._call_nums.get(name, 0) + 1
+
+    def to_dict(self) -> Dict[str, Dict]:
+        """Convert the accumulated times to dictionary representation.
+
+        Returns:
+            Dictionary mapping stage names to their wall time, CPU time (in seconds)
+            and number of calls
+        """
+        with self._lock:
+            return {
+                name: {
+                    "wall_time": self._wall_times[name],
+                    "cpu_time": self._cpu_times[name],
+                    "call_num": self._call_nums[name],
+                }
+                for name in self._wall_times
+            }
+
+
+def get_peak_rss_bytes() -> int:
+    """Get the peak resident set size of the current process in bytes."""
+    peak_rss = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    # ru_maxrss is in kilobytes on Linux and in bytes on macOS
+    return peak_rss if sys.platform == "darwin" else peak_rss * 1024
+
+
+# The timer shared by all the instrumented stages of a process
+STAGE_TIMER = StageTimer()
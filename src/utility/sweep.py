@@ -0,0 +1,489 @@
+"""Accuracy-vs-cost sweep over a grid of slicing configurations.
+
+Each configuration (model, temperature, max query number, call depth and prompt
+templates) is run by reposlice.py on the benchmark slice requests and scored with
+the judger. The LLM answers are cached in one trace per model, temperature and
+prompt templates (see llmtool/LLM_trace.py), so that the configurations sharing
+them, and later sweeps, only query the answers they have not seen. The report
+gives the Pareto frontier of the F1 score against the tokens, dollars and wall
+time, and the cheapest configuration meeting an accuracy bar.
+"""
+
+import hashlib
+import itertools
+import json
+import os
+import re
+import sys
+import time
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+from utility.batch_judger import aggregate_runs, judge_run
+from utility.stage_benchmark import run_single_benchmark
+
+BASE_PATH = Path(__file__).resolve().parents[2]
+
+# List prices in USD per million (input, output) tokens, matched in order by
+# substring of the model name. They change over time, so --price-file overrides
+# them.
+MODEL_PRICES: List[Tuple[str, float, float]] = [
+    ("mock", 0.0, 0.0),
+    ("gpt-5-nano", 0.05, 0.4),
+    ("gpt-5-mini", 0.25, 2.0),
+    ("gpt-5", 1.25, 10.0),
+    ("gpt-4.1-mini", 0.4, 1.6),
+    ("gpt-4.1", 2.0, 8.0),
+    ("gpt-4o-mini", 0.15, 0.6),
+    ("gpt-4o", 2.5, 10.0),
+    ("gpt-3.5", 0.5, 1.5),
+    ("o3-mini", 1.1, 4.4),
+    ("o4-mini", 1.1, 4.4),
+    ("claude", 3.0, 15.0),
+    ("deepseek-reasoner", 0.55, 2.19),
+    ("deepseek", 0.27, 1.1),
+    ("gemini", 1.25, 5.0),
+]
+
+# The cost axes of the Pareto frontiers
+COST_KEYS = ["token_cost", "dollar_cost", "wall_time"]
+
+
+def get_model_price(
+    model_name: str, model_prices: List[Tuple[str, float, float]]
+) -> Optional[Tuple[float, float]]:
+    """Get the price of a model.
+
+    Args:
+        model_name: Name of the model
+        model_prices: Prices of the models (see MODEL_PRICES)
+
+    Returns:
+        The USD prices per million input and output tokens, or None if unknown
+    """
+    for pattern, input_price, output_price in model_prices:
+        if pattern in model_name:
+            return input_price, output_price
+    return None
+
+
+class SweepConfig:
+    """A configuration of the slicer in a sweep."""
+
+    def __init__(
+        self,
+        model_name: str,
+        temperature: float,
+        max_query_num: int,
+        call_depth: int,
+        prompt_dir: Optional[str] = None,
+    ) -> None:
+        """Initialize a configuration.
+
+        Args:
+            model_name: Name of the model
+            temperature: Temperature of the queries
+            max_query_num: Maximum number of queries per intra-procedural slice
+            call_depth: Call depth setting
+            prompt_dir: Directory of the prompt templates, or None for the default
+        """
+        self.model_name = model_name
+        self.temperature = temperature
+        self.max_query_num = max_query_num
+        self.call_depth = call_depth
+        self.prompt_dir = prompt_dir
+
+    @property
+    def prompt_name(self) -> str:
+        """Name of the prompt templates shown in the report."""
+        return "default" if self.prompt_dir is None else Path(self.prompt_dir).name
+
+    @property
+    def config_id(self) -> str:
+        """Identifier of the configuration."""
+        return (
+            f"{self.model_name}|t={self.temperature}|q={self.max_query_num}"
+            f"|d={self.call_depth}|p={self.prompt_name}"
+        )
+
+    @property
+    def trace_name(self) -> str:
+        """File name of the LLM trace shared by the configurations asking the same
+        model the same prompts."""
+        prompt_key = "default"
+        if self.prompt_dir is not None:
+            prompt_dir = str(Path(self.prompt_dir).resolve())
+            prompt_hash = hashlib.sha1(prompt_dir.encode("utf-8")).hexdigest()[:8]
+            prompt_key = f"{self.prompt_name}-{prompt_hash}"
+        trace_name = f"{self.model_name}_t{self.temperature}_{prompt_key}.jsonl"
+        return re.sub(r"[^\w.\-]", "_", trace_name)
+
+    def to_dict(self) -> Dict:
+        """Convert the configuration to dictionary representation."""
+        return {
+            "model_name": self.model_name,
+            "temperature": self.temperature,
+            "max_query_num": self.max_query_num,
+            "call_depth": self.call_depth,
+            "prompt_dir": self.prompt_dir,
+        }
+
+
+def build_grid(
+    model_names: List[str],
+    temperatures: List[float],
+    max_query_nums: List[int],
+    call_depths: List[int],
+    prompt_dirs: List[Optional[str]],
+) -> List[SweepConfig]:
+    """Build the configurations of the cartesian product of the settings.
+
+    Returns:
+        The configurations, grouped by model, temperature and prompt templates so
+        that consecutive configurations share their LLM trace
+    """
+    return [
+        SweepConfig(model_name, temperature, max_query_num, call_depth, prompt_dir)
+        for model_name, temperature, prompt_dir, max_query_num, call_depth in (
+            itertools.product(
+                model_names, temperatures, prompt_dirs, max_query_nums, call_depths
+            )
+        )
+    ]
+
+
+def run_config(
+    config: SweepConfig,
+    slice_request_paths: List[str],
+    oracle_dir: str,
+    trace_dir: Optional[str],
+    is_latency_simulated: bool,
+    max_symbolic_workers: int,
+    model_prices: List[Tuple[str, float, float]],
+) -> Dict:
+    """Run a configuration on the slice requests and score it.
+
+    Args:
+        config: Configuration to run
+        slice_request_paths: Paths to the slice request JSON files
+        oracle_dir: Directory containing oracle files
+        trace_dir: Directory of the cached LLM traces, or None to query the LLMs
+        is_latency_simulated: Whether the replayed answers wait for their recorded
+            latency
+        max_symbolic_workers: Max symbolic workers for parsing-based analysis
+        model_prices: Prices of the models (see MODEL_PRICES)
+
+    Returns:
+        Dictionary containing the configuration, the micro-averaged accuracy, the
+        costs summed over the requests, and the requests that failed
+    """
+    config_args = ["--max-query-num", str(config.max_query_num)]
+    if config.prompt_dir is not None:
+        config_args += ["--prompt-dir", config.prompt_dir]
+
+    runs: List[Dict] = []
+    wall_time = 0.0
+    errors: Dict[str, str] = {}
+    for slice_request_path in slice_request_paths:
+        extra_args = list(config_args)
+        if trace_dir is not None:
+            # The cached answers are replayed, and the missing ones are recorded
+            trace_path = os.path.join(trace_dir, config.trace_name)
+            extra_args += ["--llm-record-path", trace_path]
+            if os.path.exists(trace_path):
+                extra_args += ["--llm-replay-path", trace_path]
+                if is_latency_simulated:
+                    extra_args.append("--llm-replay-latency")
+        try:
+            stage_timing = run_single_benchmark(
+                slice_request_path,
+                config.model_name,
+                config.call_depth,
+                max_symbolic_workers,
+                extra_args,
+                config.temperature,
+            )
+            slicing_request_id = stage_timing["slicing_request_ids"][0]
+            result_json_path = os.path.join(
+                stage_timing["result_dir_paths"][0],
+                f"slice_info_{slicing_request_id}.json",
+            )
+            runs.append(judge_run(slicing_request_id, result_json_path, oracle_dir))
+            wall_time += stage_timing["wall_time"]
+        except (RuntimeError, OSError, KeyError, ValueError) as e:
+            errors[slice_request_path] = str(e)
+
+    summary = aggregate_runs(runs)["overall"]
+    cost = summary["cost"]
+    price = get_model_price(config.model_name, model_prices)
+    dollar_cost = None
+    if price is not None:
+        dollar_cost = (
+            cost["input_token_cost"] * price[0] + cost["output_token_cost"] * price[1]
+        ) / 1e6
+    return {
+        "config_id": config.config_id,
+        "config": config.to_dict(),
+        "f1_score": summary["f1_score"],
+        "macro_f1_score": summary["macro_f1_score"],
+        "precision": summary["precision"],
+        "recall": summary["recall"],
+        "llm_query_num": cost["llm_query_num"],
+        "token_cost": cost["input_token_cost"] + cost["output_token_cost"],
+        "dollar_cost": dollar_cost,
+        "wall_time": wall_time,
+        "run_num": summary["run_num"],
+        "errors": errors,
+    }
+
+
+def compute_pareto_frontier(results: List[Dict], cost_key: str) -> List[str]:
+    """Compute the Pareto frontier of the F1 score against a cost.
+
+    A configuration is on the frontier if no other configuration has a higher F1
+    score for at most the same cost, or the same F1 score for a lower cost.
+
+    Args:
+        results: Results of the configurations returned by run_config
+        cost_key: Key of the cost in the results
+
+    Returns:
+        The identifiers of the configurations on the frontier, by increasing cost
+    """
+    # Failed configurations and unknown costs are not comparable
+    candidates = [
+        result
+        for result in results
+        if result[cost_key] is not None and not result["errors"]
+    ]
+    candidates.sort(key=lambda result: (result[cost_key], -result["f1_score"]))
+    frontier: List[str] = []
+    best_f1_score = -1.0
+    for result in candidates:
+        if result["f1_score"] > best_f1_score:
+            frontier.append(result["config_id"])
+            best_f1_score = result["f1_score"]
+    return frontier
+
+
+def select_cheapest_config(
+    results: List[Dict], min_f1_score: float, cost_key: str
+) -> Optional[Dict]:
+    """Select the cheapest configuration meeting an accuracy bar.
+
+    Args:
+        results: Results of the configurations returned by run_config
+        min_f1_score: Minimum F1 score
+        cost_key: Key of the cost to minimize
+
+    Returns:
+        The result of the cheapest configuration (the most accurate on ties), or
+        None if no configuration meets the bar
+    """
+    candidates = [
+        result
+        for result in results
+        if result[cost_key] is not None
+        and not result["errors"]
+        and result["f1_score"] >= min_f1_score
+    ]
+    if not candidates:
+        return None
+    return min(candidates, key=lambda result: (result[cost_key], -result["f1_score"]))
+
+
+def main():
+    """Main function for command-line usage."""
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        description="Sweep slicing configurations and report their accuracy and cost"
+    )
+    parser.add_argument(
+        "slice_request_paths",
+        nargs="*",
+        help="Slice request files (default: the benchmark/Cpp/slice/*.json requests "
+        "with an oracle)",
+    )
+    parser.add_argument(
+        "--models", nargs="+", default=["mock"], help="Models to sweep"
+    )
+    parser.add_argument(
+        "--temperatures",
+        type=float,
+        nargs="+",
+        default=[0.0],
+        help="Temperatures to sweep",
+    )
+    parser.add_argument(
+        "--max-query-nums",
+        type=int,
+        nargs="+",
+        default=[3],
+        help="Maximum query numbers to sweep",
+    )
+    parser.add_argument(
+        "--call-depths", type=int, nargs="+", default=[3], help="Call depths to sweep"
+    )
+    parser.add_argument(
+        "--prompt-dirs",
+        nargs="+",
+        default=["default"],
+        help='Prompt template directories to sweep ("default" for the default ones)',
+    )
+    parser.add_argument(
+        "--oracle-dir",
+        default=str(BASE_PATH / "oracle"),
+        help="Directory containing oracle files (default: oracle/ in project root)",
+    )
+    parser.add_argument(
+        "--trace-dir",
+        default=str(BASE_PATH / "result" / "sweep" / "llm_traces"),
+        help="Directory of the cached LLM traces (default: result/sweep/llm_traces)",
+    )
+    parser.add_argument(
+        "--no-cache",
+        action="store_true",
+        help="Query the LLMs for every configuration instead of the cached traces",
+    )
+    parser.add_argument(
+        "--simulate-latency",
+        action="store_true",
+        help="Wait for the recorded latency of the cached answers, so that the wall "
+        "times are comparable to live runs",
+    )
+    parser.add_argument(
+        "--price-file",
+        default=None,
+        help="A json file mapping model name substrings to their USD prices per "
+        "million [input, output] tokens",
+    )
+    parser.add_argument(
+        "--min-f1",
+        type=float,
+        default=None,
+        help="Accuracy bar of the cheapest configuration to select",
+    )
+    parser.add_argument(
+        "--max-symbolic-workers",
+        type=int,
+        default=10,
+        help="Max symbolic workers for parsing-based analysis",
+    )
+    parser.add_argument(
+        "--output",
+        default=None,
+        help="Path of the JSON report (default: result/sweep/sweep_*.json)",
+    )
+    args = parser.parse_args()
+
+    model_prices = list(MODEL_PRICES)
+    if args.price_file is not None:
+        with open(args.price_file, "r") as f:
+            price_dict = json.load(f)
+        # The given prices take precedence over the default ones
+        model_prices = [
+            (pattern, float(prices[0]), float(prices[1]))
+            for pattern, prices in price_dict.items()
+        ] + model_prices
+
+    slice_request_paths: List[str] = args.slice_request_paths
+    if not slice_request_paths:
+        slice_request_paths = sorted(
+            str(path)
+            for path in (BASE_PATH / "benchmark/Cpp/slice").glob("*.json")
+            if (Path(args.oracle_dir) / path.name).exists()
+        )
+    slice_request_paths = [str(Path(path).resolve()) for path in slice_request_paths]
+
+    trace_dir: Optional[str] = None
+    if not args.no_cache:
+        trace_dir = args.trace_dir
+        os.makedirs(trace_dir, exist_ok=True)
+
+    configs = build_grid(
+        args.models,
+        args.temperatures,
+        args.max_query_nums,
+        args.call_depths,
+        [
+            None if prompt_dir == "default" else prompt_dir
+            for prompt_dir in args.prompt_dirs
+        ],
+    )
+    results: List[Dict] = []
+    for index, config in enumerate(configs):
+        print(f"[{index + 1}/{len(configs)}] {config.config_id}")
+        results.append(
+            run_config(
+                config,
+                slice_request_paths,
+                args.oracle_dir,
+                trace_dir,
+                args.simulate_latency,
+                args.max_symbolic_workers,
+                model_prices,
+            )
+        )
+
+    report = {
+        "timestamp": time.strftime("%Y-%m-%d-%H-%M-%S", time.localtime()),
+        "slice_request_paths": slice_request_paths,
+        "is_cached": trace_dir is not None,
+        "is_latency_simulated": args.simulate_latency,
+        "results": results,
+        "pareto_frontiers": {
+            cost_key: compute_pareto_frontier(results, cost_key)
+            for cost_key in COST_KEYS
+        },
+    }
+    if args.min_f1 is not None:
+        report["cheapest_configs"] = {
+            cost_key: select_cheapest_config(results, args.min_f1, cost_key)
+            for cost_key in COST_KEYS
+        }
+
+    output: Optional[str] = args.output
+    if output is None:
+        output_dir = BASE_PATH / "result" / "sweep"
+        output_dir.mkdir(parents=True, exist_ok=True)
+        output = str(output_dir / f"sweep_{report['timestamp']}.json")
+    with open(output, "w") as f:
+        json.dump(report, f, indent=4)
+
+    # Print the summary table, marking the configurations on a frontier
+    print(
+        f"{'configuration':<48} {'F1':>6} {'tokens':>10} {'USD':>8} {'time(s)':>8} "
+        f"{'pareto':>8}"
+    )
+    for result in results:
+        pareto_marks = "".join(
+            cost_key[0] if result["config_id"] in frontier else "-"
+            for cost_key, frontier in report["pareto_frontiers"].items()
+        )
+        dollar_cost = f"{'?':>8}"
+        if result["dollar_cost"] is not None:
+            dollar_cost = f"{result['dollar_cost']:>8.4f}"
+        print(
+            f"{result['config_id']:<48} {result['f1_score']:>6.3f} "
+            f"{result['token_cost']:>10} {dollar_cost} {result['wall_time']:>8.1f} "
+            f"{pareto_marks:>8}"
+        )
+        for slice_request_path, error in result["errors"].items():
+            print(f"  failed on {slice_request_path}: {error.split(chr(10))[0]}")
+    print("pareto: t = tokens, d = dollars, w = wall time")
+    if args.min_f1 is not None:
+        for cost_key, result in report["cheapest_configs"].items():
+            config_id = result["config_id"] if result is not None else "none"
+            print(
+                f"Cheapest configuration by {cost_key} with F1 >= {args.min_f1}: "
+                f"{config_id}"
+            )
+    print(f"The sweep report is saved in {output}")
+
+    if any(result["errors"] for result in results):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
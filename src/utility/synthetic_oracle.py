@@ -0,0 +1,498 @@
+"""Exact slicing oracles of the synthetic projects.
+
+The generated code is pointer-free and every statement records its definitions,
+uses and enclosing control header, so the program dependence graph is exact:
+data dependences come from reaching definitions over the structured control flow
+of each function, and control dependences from the enclosing headers. Calls are
+handled with summaries (the parameters a return value depends on), so the slices
+are context-sensitive like the ones of the inter-procedural agent:
+
+- Backward slices descend from a relevant call into the slice of the callee's
+  return values, and ascend from relevant parameters to the arguments at all the
+  call sites of the function.
+- Forward slices descend from a tainted argument into the callee from the
+  parameter, and ascend from a tainted return value to all the call sites of the
+  function, unless the function was entered from a call site.
+
+The oracles use the format of oracle/*.json: line numbers are relative to the
+function (the signature is line 1), and the whitelist holds the lines that carry
+no semantics (closing braces, "} else {" and blank lines) as well as the
+signature and return lines outside the slice.
+"""
+
+from collections import deque
+from typing import Deque, Dict, FrozenSet, Iterable, List, Optional, Set, Tuple
+
+from utility.synthetic_project import SyntheticFunction, SyntheticStatement
+
+# A def node is a statement index and the variable it defines
+DefNode = Tuple[int, str]
+
+
+class SyntheticFunctionAnalysis:
+    """Intra-procedural dependences of a synthetic function."""
+
+    def __init__(self, function: SyntheticFunction) -> None:
+        """Analyze the control flow and the reaching definitions of a function.
+
+        Args:
+            function: The function to analyze
+        """
+        self.function = function
+        statements = function.statements
+        self.successors = self._build_successors(statements)
+
+        # Maps header index -> indices of the statements directly controlled by it
+        self.children: Dict[int, List[int]] = {}
+        for index, statement in enumerate(statements):
+            if statement.parent is not None:
+                self.children.setdefault(statement.parent, []).append(index)
+
+        # Maps statement index -> used variable -> indices of the reaching defs
+        self.use_defs: List[Dict[str, Set[int]]] = []
+        # Maps def node -> indices of the statements it reaches and that use it
+        self.def_uses: Dict[DefNode, Set[int]] = {}
+        self._compute_reaching_definitions(statements)
+
+    @staticmethod
+    def _build_successors(statements: List[SyntheticStatement]) -> List[List[int]]:
+        """Build the control flow successors of the statements.
+
+        Args:
+            statements: Statements of the function
+
+        Returns:
+            List mapping each statement index to its successor indices
+        """
+        block_closes: Dict[int, int] = {}
+        else_indices: Dict[int, int] = {}
+        loop_headers: Dict[int, int] = {}
+        open_blocks: List[int] = []
+        for index, statement in enumerate(statements):
+            if statement.kind in ("if", "for"):
+                open_blocks.append(index)
+            elif statement.kind == "else":
+                else_indices[open_blocks.pop()] = index
+                open_blocks.append(index)
+            elif statement.kind == "close" and open_blocks:
+                header = open_blocks.pop()
+                block_closes[header] = index
+                if statements[header].kind == "for":
+                    loop_headers[index] = header
+
+        successors: List[List[int]] = []
+        for index, statement in enumerate(statements):
+            if statement.kind == "return":
+                successors.append([])
+            elif statement.kind == "if":
+                false_target = (
+                    else_indices[index] + 1
+                    if index in else_indices
+                    else block_closes[index]
+                )
+                successors.append([index + 1, false_target])
+            elif statement.kind == "for":
+                successors.append([index + 1, block_closes[index] + 1])
+            elif statement.kind == "else":
+                # Reached at the end of the then branch, which skips the else branch
+                successors.append([block_closes[index]])
+            elif index in loop_headers:
+                successors.append([loop_headers[index]])
+            elif index + 1 < len(statements):
+                successors.append([index + 1])
+            else:
+                successors.append([])
+        return successors
+
+    def _compute_reaching_definitions(
+        self, statements: List[SyntheticStatement]
+    ) -> None:
+        """Compute the reaching definitions of all the used variables."""
+        statement_num = len(statements)
+        predecessors: List[List[int]] = [[] for _ in range(statement_num)]
+        for index, successors in enumerate(self.successors):
+            for successor in successors:
+                predecessors[successor].append(index)
+
+        # The signature defines the parameters
+        gens: List[Set[str]] = [set(statement.defs) for statement in statements]
+        gens[0] = set(self.function.params)
+
+        outs: List[Dict[str, FrozenSet[int]]] = [{} for _ in range(statement_num)]
+        ins: List[Dict[str, FrozenSet[int]]] = [{} for _ in range(statement_num)]
+        worklist: Deque[int] = deque(range(statement_num))
+        is_queued = [True] * statement_num
+        while worklist:
+            index = worklist.popleft()
+            is_queued[index] = False
+            in_defs: Dict[str, Set[int]] = {}
+            for predecessor in predecessors[index]:
+                for variable, defs in outs[predecessor].items():
+                    in_defs.setdefault(variable, set()).update(defs)
+            ins[index] = {
+                variable: frozenset(defs) for variable, defs in in_defs.items()
+            }
+
+            out_defs = dict(ins[index])
+            for variable in gens[index]:
+                out_defs[variable] = frozenset([index])
+            if out_defs != outs[index]:
+                outs[index] = out_defs
+                for successor in self.successors[index]:
+                    if not is_queued[successor]:
+                        worklist.append(successor)
+                        is_queued[successor] = True
+
+        for index, statement in enumerate(statements):
+            use_defs = {
+                variable: set(ins[index].get(variable, frozenset()))
+                for variable in statement.uses
+            }
+            self.use_defs.append(use_defs)
+            for variable, defs in use_defs.items():
+                for def_index in defs:
+                    self.def_uses.setdefault((def_index, variable), set()).add(index)
+
+
+class SyntheticOracleBuilder:
+    """Builder of the exact slices of the synthetic projects."""
+
+    def __init__(self, functions: List[SyntheticFunction]) -> None:
+        """Initialize the builder.
+
+        Args:
+            functions: All the functions of the project
+        """
+        self.functions = {function.name: function for function in functions}
+        self._analyses: Dict[str, SyntheticFunctionAnalysis] = {}
+        self._summaries: Dict[str, Set[int]] = {}
+
+        # Maps function name -> (caller name, index of the call statement)
+        self.call_sites: Dict[str, List[Tuple[str, int]]] = {}
+        for function in functions:
+            for index, statement in enumerate(function.statements):
+                if statement.kind == "call" and statement.callee_name is not None:
+                    self.call_sites.setdefault(statement.callee_name, []).append(
+                        (function.name, index)
+                    )
+
+    def analysis(self, function_name: str) -> SyntheticFunctionAnalysis:
+        """Get the (cached) intra-procedural analysis of a function."""
+        if function_name not in self._analyses:
+            self._analyses[function_name] = SyntheticFunctionAnalysis(
+                self.functions[function_name]
+            )
+        return self._analyses[function_name]
+
+    def summary(self, function_name: str) -> Set[int]:
+        """Get the indices of the parameters the return value of a function depends on.
+
+        Args:
+            function_name: Name of the function
+
+        Returns:
+            Set of parameter indices
+        """
+        if function_name not in self._summaries:
+            # Recursive call chains see an empty summary while it is computed
+            self._summaries[function_name] = set()
+            _, params, _ = self._backward_local(
+                function_name, self._return_indices(function_name)
+            )
+            self._summaries[function_name] = params
+        return self._summaries[function_name]
+
+    def _return_indices(
+        self, function_name: str
+    ) -> List[Tuple[int, Optional[Set[str]]]]:
+        """Get the return statements of a function as backward slicing criteria."""
+        statements = self.functions[function_name].statements
+        return [
+            (index, None)
+            for index, statement in enumerate(statements)
+            if statement.kind == "return"
+        ]
+
+    ##################################################
+    #                Backward slicing                #
+    ##################################################
+
+    def _backward_local(
+        self, function_name: str, criteria: Iterable[Tuple[int, Optional[Set[str]]]]
+    ) -> Tuple[Set[int], Set[int], Set[str]]:
+        """Slice backward within a function.
+
+        Args:
+            function_name: Name of the function
+            criteria: Pairs of a statement index and the used variables to slice
+                from, or None for the relevant uses of the statement. A statement
+                with explicit variables does not descend into its callee.
+
+        Returns:
+            Tuple of (line numbers, indices of the relevant parameters, names of
+            the callees whose return values are relevant)
+        """
+        function = self.functions[function_name]
+        analysis = self.analysis(function_name)
+        line_numbers: Set[int] = set()
+        params: Set[int] = set()
+        callee_names: Set[str] = set()
+
+        visited: Set[int] = set()
+        worklist: List[Tuple[int, Optional[Set[str]]]] = list(criteria)
+        while worklist:
+            index, variables = worklist.pop()
+            if variables is None:
+                if index in visited:
+                    continue
+                visited.add(index)
+            statement = function.statements[index]
+            if statement.kind != "else":
+                line_numbers.add(index + 1)
+
+            if variables is None:
+                variables = set(statement.uses)
+                if statement.kind == "call" and statement.callee_name is not None:
+                    callee_names.add(statement.callee_name)
+                    variables = {
+                        statement.args[param_index]
+                        for param_index in self.summary(statement.callee_name)
+                    }
+            for variable in variables:
+                for def_index in analysis.use_defs[index].get(variable, set()):
+                    if def_index == 0:
+                        params.add(function.params.index(variable))
+                        line_numbers.add(1)
+                    else:
+                        worklist.append((def_index, None))
+            if statement.parent is not None:
+                worklist.append((statement.parent, None))
+        return line_numbers, params, callee_names
+
+    def backward_slice(
+        self, function_name: str, index: int, seed_name: str
+    ) -> Dict[str, Set[int]]:
+        """Compute the inter-procedural backward slice of a seed.
+
+        Args:
+            function_name: Name of the function containing the seed
+            index: Index of the statement using the seed
+            seed_name: Name of the seed variable
+
+        Returns:
+            Dictionary mapping function names to their relevant line numbers
+        """
+        slice_lines: Dict[str, Set[int]] = {}
+        descended: Set[str] = set()
+        ascended: Set[Tuple[str, int, FrozenSet[int]]] = set()
+
+        def add_local_slice(
+            name: str, criteria: List[Tuple[int, Optional[Set[str]]]]
+        ) -> Set[int]:
+            line_numbers, params, callee_names = self._backward_local(name, criteria)
+            slice_lines.setdefault(name, set()).update(line_numbers)
+            for callee_name in callee_names:
+                if callee_name not in descended:
+                    descended.add(callee_name)
+                    add_local_slice(callee_name, self._return_indices(callee_name))
+            return params
+
+        # (function name, relevant parameters) whose call sites are sliced
+        seed_params = add_local_slice(function_name, [(index, {seed_name})])
+        pending = [(function_name, seed_params)]
+        while pending:
+            name, params = pending.pop()
+            if not params:
+                continue
+            for caller_name, call_index in self.call_sites.get(name, []):
+                key = (caller_name, call_index, frozenset(params))
+                if key in ascended:
+                    continue
+                ascended.add(key)
+                call_statement = self.functions[caller_name].statements[call_index]
+                arg_names = {call_statement.args[param] for param in params}
+                caller_params = add_local_slice(caller_name, [(call_index, arg_names)])
+                pending.append((caller_name, caller_params))
+        return slice_lines
+
+    ##################################################
+    #                 Forward slicing                #
+    ##################################################
+
+    def _forward_local(
+        self, function_name: str, criteria: Iterable[Tuple[int, Set[str]]]
+    ) -> Tuple[Set[int], Set[Tuple[str, int]], bool]:
+        """Slice forward within a function.
+
+        Args:
+            function_name: Name of the function
+            criteria: Pairs of a statement index and the variables it defines that
+                are tainted
+
+        Returns:
+            Tuple of (line numbers, (callee name, parameter index) pairs of the
+            tainted arguments, whether the return value is tainted)
+        """
+        function = self.functions[function_name]
+        analysis = self.analysis(function_name)
+        line_numbers: Set[int] = set()
+        tainted_args: Set[Tuple[str, int]] = set()
+        is_return_tainted = False
+
+        tainted_defs: Set[DefNode] = set()
+        worklist: List[DefNode] = []
+        controlled_headers: Set[int] = set()
+
+        def taint(index: int, variables: Iterable[str]) -> None:
+            for variable in variables:
+                if (index, variable) not in tainted_defs:
+                    tainted_defs.add((index, variable))
+                    worklist.append((index, variable))
+
+        def taint_controlled(header: int) -> None:
+            nonlocal is_return_tainted
+            if header in controlled_headers:
+                return
+            controlled_headers.add(header)
+            for child in analysis.children.get(header, []):
+                child_statement = function.statements[child]
+                if child_statement.kind in ("if", "for", "else"):
+                    if child_statement.kind != "else":
+                        line_numbers.add(child + 1)
+                    taint_controlled(child)
+                    continue
+                line_numbers.add(child + 1)
+                if child_statement.kind == "return":
+                    is_return_tainted = True
+                taint(child, child_statement.defs)
+
+        for index, variables in criteria:
+            line_numbers.add(index + 1)
+            taint(index, variables)
+
+        while worklist:
+            def_node = worklist.pop()
+            variable = def_node[1]
+            for index in analysis.def_uses.get(def_node, set()):
+                statement = function.statements[index]
+                line_numbers.add(index + 1)
+                if statement.kind == "call" and statement.callee_name is not None:
+                    summary = self.summary(statement.callee_name)
+                    for param_index, arg_name in enumerate(statement.args):
+                        if arg_name != variable:
+                            continue
+                        tainted_args.add((statement.callee_name, param_index))
+                        if param_index in summary:
+                            taint(index, statement.defs)
+                elif statement.kind == "if":
+                    taint_controlled(index)
+                elif statement.kind == "return":
+                    is_return_tainted = True
+                else:
+                    taint(index, statement.defs)
+        return line_numbers, tainted_args, is_return_tainted
+
+    def forward_slice(
+        self, function_name: str, index: int, seed_name: str
+    ) -> Dict[str, Set[int]]:
+        """Compute the inter-procedural forward slice of a seed.
+
+        Args:
+            function_name: Name of the function containing the seed
+            index: Index of the statement defining the seed
+            seed_name: Name of the seed variable
+
+        Returns:
+            Dictionary mapping function names to their relevant line numbers
+        """
+        slice_lines: Dict[str, Set[int]] = {}
+        descended: Set[Tuple[str, int]] = set()
+        ascended: Set[Tuple[str, int]] = set()
+
+        def add_local_slice(
+            name: str, criteria: List[Tuple[int, Set[str]]], can_ascend: bool
+        ) -> None:
+            line_numbers, tainted_args, is_return_tainted = self._forward_local(
+                name, criteria
+            )
+            slice_lines.setdefault(name, set()).update(line_numbers)
+            for callee_name, param_index in tainted_args:
+                if (callee_name, param_index) in descended:
+                    continue
+                descended.add((callee_name, param_index))
+                param_name = self.functions[callee_name].params[param_index]
+                add_local_slice(callee_name, [(0, {param_name})], False)
+            if not (can_ascend and is_return_tainted):
+                return
+            for caller_name, call_index in self.call_sites.get(name, []):
+                if (caller_name, call_index) in ascended:
+                    continue
+                ascended.add((caller_name, call_index))
+                call_statement = self.functions[caller_name].statements[call_index]
+                add_local_slice(
+                    caller_name, [(call_index, set(call_statement.defs))], True
+                )
+
+        add_local_slice(function_name, [(index, {seed_name})], True)
+        return slice_lines
+
+    ##################################################
+    #                 Oracle output                  #
+    ##################################################
+
+    def whitelist(self, function_name: str, line_numbers: Set[int]) -> List[int]:
+        """Get the whitelist line numbers of a function.
+
+        Args:
+            function_name: Name of the function
+            line_numbers: Relevant line numbers of the function
+
+        Returns:
+            Sorted whitelist line numbers
+        """
+        whitelist = []
+        for index, statement in enumerate(self.functions[function_name].statements):
+            if statement.kind in ("close", "else", "blank") or (
+                statement.kind in ("signature", "return")
+                and index + 1 not in line_numbers
+            ):
+                whitelist.append(index + 1)
+        return whitelist
+
+    def build_oracle(
+        self,
+        slicing_request_id: str,
+        function_name: str,
+        index: int,
+        seed_name: str,
+        is_backward: bool,
+    ) -> Dict:
+        """Build the oracle of a slice request.
+
+        Args:
+            slicing_request_id: The ID of the slicing request
+            function_name: Name of the function containing the seed
+            index: Index of the seed statement in the function
+            seed_name: Name of the seed variable
+            is_backward: Whether the request is a backward slice
+
+        Returns:
+            Oracle in the format of oracle/*.json
+        """
+        if is_backward:
+            slice_lines = self.backward_slice(function_name, index, seed_name)
+        else:
+            slice_lines = self.forward_slice(function_name, index, seed_name)
+        return {
+            "slicing_request_id": slicing_request_id,
+            "relevant_function_names_to_line_numbers": {
+                name: sorted(line_numbers)
+                for name, line_numbers in slice_lines.items()
+                if line_numbers
+            },
+            "whitelist_line_numbers": {
+                name: self.whitelist(name, line_numbers)
+                for name, line_numbers in slice_lines.items()
+                if line_numbers
+            },
+        }
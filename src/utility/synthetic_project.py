@@ -0,0 +1,687 @@
+"""Generator of synthetic C projects for scalability and accuracy testing.
+
+The generated projects follow the style of the projects in benchmark/Cpp/slice
+(e.g., data_processing): integer functions with local bookkeeping, branches,
+loops and printf noise, organized in call levels below main and spread over
+several source files that share one header. The generation is deterministic
+for a given configuration and random seed.
+
+Each function is first built as a list of statements annotated with their
+definitions and uses, and then rendered to C, so that the dependencies of the
+generated code are known exactly. utility/synthetic_oracle.py derives the exact
+oracles of the generated slice requests from them.
+"""
+
+import json
+import random
+from pathlib import Path
+from typing import Dict, List, Optional, Set, Tuple
+
+BASE_PATH = Path(__file__).resolve().parents[2]
+
+VERBS = [
+    "analyze", "apply", "check", "compute", "filter", "normalize", "process",
+    "reduce", "scale", "transform", "update", "validate",
+]  # fmt: skip
+NOUNS = [
+    "bounds", "buffer", "data", "delta", "input", "level", "offset", "range",
+    "ratio", "sample", "signal", "value",
+]  # fmt: skip
+VARIABLE_NOUNS = [
+    "acc", "base", "count", "factor", "flag", "limit", "mode", "result",
+    "score", "step", "temp", "total",
+]  # fmt: skip
+OPERATORS = ["+", "-", "*"]
+
+
+class SyntheticProjectConfig:
+    """Parameters of a synthetic project."""
+
+    def __init__(
+        self,
+        file_num: int = 4,
+        function_num: int = 20,
+        call_depth: int = 3,
+        fan_out: int = 2,
+        fan_in: int = 2,
+        function_length: int = 30,
+        branch_density: float = 0.2,
+        loop_density: float = 0.1,
+        request_num: int = 2,
+        seed: int = 0,
+    ) -> None:
+        """Initialize the configuration.
+
+        Args:
+            file_num: Number of source files besides main.c
+            function_num: Number of functions besides main
+            call_depth: Number of call levels below main
+            fan_out: Number of call sites in a function calling the next level
+            fan_in: Preferred maximum number of call sites calling a function
+            function_length: Approximate number of lines of a function
+            branch_density: Probability that a body statement opens an if block
+            loop_density: Probability that a body statement opens a for loop
+            request_num: Number of slice requests to emit
+            seed: Seed of the random generator
+        """
+        assert file_num > 0, "file_num must be positive"
+        assert function_num >= call_depth > 0, "need call_depth <= function_num"
+        assert fan_out > 0 and fan_in > 0, "fan_out and fan_in must be positive"
+        assert function_length >= 10, "function_length must be at least 10"
+        assert 0.0 <= branch_density + loop_density <= 1.0, "invalid densities"
+        self.file_num = file_num
+        self.function_num = function_num
+        self.call_depth = call_depth
+        self.fan_out = fan_out
+        self.fan_in = fan_in
+        self.function_length = function_length
+        self.branch_density = branch_density
+        self.loop_density = loop_density
+        self.request_num = request_num
+        self.seed = seed
+
+    def to_dict(self) -> dict:
+        """Convert the configuration to dictionary representation.
+
+        Returns:
+            Dictionary containing all the parameters
+        """
+        return dict(self.__dict__)
+
+
+class SyntheticStatement:
+    """A line of a synthetic function, annotated with its data and control deps."""
+
+    def __init__(
+        self,
+        kind: str,
+        code: str,
+        indent: int,
+        defs: Optional[Set[str]] = None,
+        uses: Optional[Set[str]] = None,
+        parent: Optional[int] = None,
+        callee_name: Optional[str] = None,
+        args: Optional[List[str]] = None,
+    ) -> None:
+        """Initialize a statement.
+
+        Args:
+            kind: One of "signature", "decl", "assign", "call", "print", "if",
+                "else", "for", "close", "return" and "blank"
+            code: The code of the line without indentation
+            indent: Indentation level of the line
+            defs: Variables defined by the statement
+            uses: Variables used by the statement
+            parent: Index of the innermost enclosing if/else/for header, if any
+            callee_name: Name of the called function of a call statement
+            args: Argument variables of a call statement, by parameter index
+        """
+        self.kind = kind
+        self.code = code
+        self.indent = indent
+        self.defs = defs or set()
+        self.uses = uses or set()
+        self.parent = parent
+        self.callee_name = callee_name
+        self.args = args or []
+
+
+class SyntheticFunction:
+    """A synthetic function and its statements (statement i is at line i + 1)."""
+
+    def __init__(self, name: str, level: int, params: List[str]) -> None:
+        """Initialize a function without statements.
+
+        Args:
+            name: Name of the function
+            level: Call level of the function (0 for main)
+            params: Names of the parameters
+        """
+        self.name = name
+        self.level = level
+        self.params = params
+        self.statements: List[SyntheticStatement] = []
+        self.callee_names: List[str] = []
+        self.file_name = ""
+        self.start_line_number = 0
+
+    def signature(self) -> str:
+        """Get the signature of the function (without the opening brace)."""
+        params = ", ".join(f"int {param}" for param in self.params)
+        return f"int {self.name}({params or 'void'})"
+
+    def render(self) -> List[str]:
+        """Render the function to lines of C code."""
+        return [
+            ("    " * statement.indent + statement.code).rstrip()
+            for statement in self.statements
+        ]
+
+
+class SyntheticProjectGenerator:
+    """Generator of a synthetic C project and its slice requests."""
+
+    def __init__(self, config: SyntheticProjectConfig) -> None:
+        """Initialize the generator.
+
+        Args:
+            config: Parameters of the project
+        """
+        self.config = config
+        self.rng = random.Random(config.seed)
+        self.functions: List[SyntheticFunction] = []
+        self.function_names: Dict[str, SyntheticFunction] = {}
+        self.levels: List[List[SyntheticFunction]] = []
+
+    ##################################################
+    #               Call graph shaping               #
+    ##################################################
+
+    def _create_functions(self) -> None:
+        """Create the functions of each level, without their bodies."""
+        config = self.config
+        main = SyntheticFunction("main", 0, [])
+        self.levels = [[main]]
+        for level in range(1, config.call_depth + 1):
+            level_size = config.function_num // config.call_depth + (
+                1 if level <= config.function_num % config.call_depth else 0
+            )
+            level_functions = []
+            for _ in range(level_size):
+                name = (
+                    f"{self.rng.choice(VERBS)}_{self.rng.choice(NOUNS)}"
+                    f"_{len(self.functions) + 1}"
+                )
+                params = [
+                    f"{noun}_{index}"
+                    for index, noun in enumerate(
+                        self.rng.sample(NOUNS, self.rng.randint(1, 3))
+                    )
+                ]
+                level_functions.append(SyntheticFunction(name, level, params))
+                self.functions.append(level_functions[-1])
+            self.levels.append(level_functions)
+        self.functions.insert(0, main)
+        self.function_names = {function.name: function for function in self.functions}
+
+    def _connect_levels(self) -> None:
+        """Choose the callees of each function in the next level.
+
+        The callees are first chosen among the functions of the next level that
+        have no caller yet, then among those with fewer than fan_in callers, so that
+        every function below main is reachable when the fan-out allows it.
+        """
+        config = self.config
+        for level in range(config.call_depth):
+            callers = self.levels[level]
+            callees = self.levels[level + 1]
+            caller_nums = {callee.name: 0 for callee in callees}
+            uncalled = list(callees)
+            self.rng.shuffle(uncalled)
+            # Callees with fewer than fan_in callers, pruned lazily
+            open_callees = list(callees)
+            for caller in callers:
+                # main fans out to more functions, so that more of the project is live
+                fan_out = config.fan_out if level > 0 else max(config.fan_out, 8)
+                for _ in range(min(fan_out, len(callees))):
+                    callee = None
+                    if uncalled:
+                        callee = uncalled.pop()
+                    while callee is None and open_callees:
+                        index = self.rng.randrange(len(open_callees))
+                        if caller_nums[open_callees[index].name] < config.fan_in:
+                            callee = open_callees[index]
+                        else:
+                            open_callees[index] = open_callees[-1]
+                            open_callees.pop()
+                    if callee is None:
+                        callee = self.rng.choice(callees)
+                    caller_nums[callee.name] += 1
+                    caller.callee_names.append(callee.name)
+
+    ##################################################
+    #               Function synthesis               #
+    ##################################################
+
+    def _random_operand(self, variables: List[str]) -> str:
+        """Get a variable or a small constant operand."""
+        if variables and self.rng.random() < 0.8:
+            return self.rng.choice(variables)
+        return str(self.rng.randint(1, 9))
+
+    def _assign_statement(
+        self,
+        variables: List[str],
+        indent: int,
+        parent: Optional[int],
+        read_only_variables: Optional[List[str]] = None,
+    ) -> SyntheticStatement:
+        """Create an assignment of an expression over one or two operands.
+
+        Args:
+            variables: Variables that can be assigned and read
+            indent: Indentation level of the statement
+            parent: Index of the enclosing if/else/for header, if any
+            read_only_variables: Variables that can only be read (e.g., loop counters)
+        """
+        target = self.rng.choice(variables)
+        readable_variables = variables + (read_only_variables or [])
+        left = self._random_operand(readable_variables)
+        if self.rng.random() < 0.5:
+            right = self._random_operand(readable_variables)
+            expression = f"{left} {self.rng.choice(OPERATORS)} {right}"
+            operands = [left, right]
+        else:
+            expression = left
+            operands = [left]
+        uses = {operand for operand in operands if not operand.isdigit()}
+        return SyntheticStatement(
+            "assign", f"{target} = {expression};", indent, {target}, uses, parent
+        )
+
+    def _call_statement(
+        self,
+        callee: SyntheticFunction,
+        variables: List[str],
+        indent: int,
+        parent: Optional[int],
+    ) -> SyntheticStatement:
+        """Create a call whose output value is assigned to a variable."""
+        target = self.rng.choice(variables)
+        args = [self.rng.choice(variables) for _ in callee.params]
+        return SyntheticStatement(
+            "call",
+            f"{target} = {callee.name}({', '.join(args)});",
+            indent,
+            {target},
+            set(args),
+            parent,
+            callee.name,
+            args,
+        )
+
+    def _print_statement(
+        self, variables: List[str], indent: int, parent: Optional[int]
+    ) -> SyntheticStatement:
+        """Create a printf of a variable (noise that defines nothing)."""
+        variable = self.rng.choice(variables)
+        return SyntheticStatement(
+            "print",
+            f'printf("{variable}: %d\\n", {variable});',
+            indent,
+            set(),
+            {variable},
+            parent,
+        )
+
+    def _synthesize_function(self, function: SyntheticFunction) -> None:
+        """Synthesize the statements of a function."""
+        config = self.config
+        statements = function.statements
+        statements.append(
+            SyntheticStatement("signature", function.signature() + " {", 0)
+        )
+
+        # Local variables are declared and initialized at the top of the function
+        local_num = max(3, config.function_length // 6)
+        local_names = [
+            f"{noun}_{index}"
+            for index, noun in enumerate(
+                self.rng.choice(VARIABLE_NOUNS) for _ in range(local_num)
+            )
+        ]
+        variables = function.params + local_names
+        for local_name in local_names:
+            operand = self._random_operand(function.params)
+            uses = set() if operand.isdigit() else {operand}
+            statements.append(
+                SyntheticStatement(
+                    "decl", f"int {local_name} = {operand};", 1, {local_name}, uses
+                )
+            )
+        statements.append(SyntheticStatement("blank", "", 0))
+
+        # Spread the call sites over the body
+        body_length = max(
+            len(function.callee_names) + 1, config.function_length - len(statements) - 3
+        )
+        call_positions = sorted(
+            self.rng.sample(range(body_length), len(function.callee_names))
+        )
+        calls = dict(zip(call_positions, function.callee_names))
+
+        def is_free(length: int) -> bool:
+            """Check whether a block of lines at the position skips no call site."""
+            return position + length <= body_length and not any(
+                position + offset in calls for offset in range(length)
+            )
+
+        position = 0
+        while position < body_length:
+            if position in calls:
+                callee = self.function_names[calls[position]]
+                statements.append(self._call_statement(callee, variables, 1, None))
+                position += 1
+                continue
+
+            choice = self.rng.random()
+            if choice < config.branch_density and is_free(3):
+                header = len(statements)
+                condition = self.rng.choice(variables)
+                statements.append(
+                    SyntheticStatement(
+                        "if",
+                        f"if ({condition} > {self.rng.randint(0, 50)}) {{",
+                        1,
+                        set(),
+                        {condition},
+                    )
+                )
+                statements.append(self._assign_statement(variables, 2, header))
+                if self.rng.random() < 0.5 and is_free(5):
+                    else_header = len(statements)
+                    statements.append(
+                        SyntheticStatement("else", "} else {", 1, parent=header)
+                    )
+                    statements.append(
+                        self._assign_statement(variables, 2, else_header)
+                    )
+                    position += 2
+                statements.append(SyntheticStatement("close", "}", 1))
+                position += 3
+            elif (
+                choice < config.branch_density + config.loop_density and is_free(3)
+            ):
+                header = len(statements)
+                counter = f"i_{header}"
+                statements.append(
+                    SyntheticStatement(
+                        "for",
+                        f"for (int {counter} = 0; {counter} < "
+                        f"{self.rng.randint(2, 5)}; {counter}++) {{",
+                        1,
+                        {counter},
+                        {counter},
+                    )
+                )
+                statements.append(
+                    self._assign_statement(variables, 2, header, [counter])
+                )
+                statements.append(SyntheticStatement("close", "}", 1))
+                position += 3
+            elif choice < 0.9:
+                statements.append(self._assign_statement(variables, 1, None))
+                position += 1
+            else:
+                statements.append(self._print_statement(variables, 1, None))
+                position += 1
+
+        statements.append(SyntheticStatement("blank", "", 0))
+        result = self.rng.choice(local_names)
+        if function.level == 0:
+            statements.append(
+                SyntheticStatement(
+                    "print",
+                    f'printf("Final result: %d\\n", {result});',
+                    1,
+                    set(),
+                    {result},
+                )
+            )
+            statements.append(SyntheticStatement("return", "return 0;", 1))
+        else:
+            statements.append(
+                SyntheticStatement("return", f"return {result};", 1, set(), {result})
+            )
+        statements.append(SyntheticStatement("close", "}", 0))
+
+    ##################################################
+    #                 Project output                 #
+    ##################################################
+
+    def generate(self) -> List[SyntheticFunction]:
+        """Generate the functions of the project.
+
+        Returns:
+            All the functions, main first
+        """
+        self._create_functions()
+        self._connect_levels()
+        for function in self.functions:
+            self._synthesize_function(function)
+        return self.functions
+
+    def layout_files(self) -> Dict[str, List[str]]:
+        """Lay out the generated functions in the files of the project.
+
+        The file name and start line number of each function are set accordingly.
+
+        Returns:
+            Dictionary mapping the file names to their lines
+        """
+        header_lines = ["#ifndef PROJECT_H", "#define PROJECT_H", ""]
+        header_lines += [f"{function.signature()};" for function in self.functions[1:]]
+        header_lines += ["", "#endif"]
+
+        file_functions: Dict[str, List[SyntheticFunction]] = {"main.c": []}
+        self.functions[0].file_name = "main.c"
+        file_functions["main.c"].append(self.functions[0])
+        for index, function in enumerate(self.functions[1:]):
+            function.file_name = f"module_{index % self.config.file_num + 1}.c"
+            file_functions.setdefault(function.file_name, []).append(function)
+
+        file_lines = {"project.h": header_lines}
+        for file_name, functions in file_functions.items():
+            lines = ["#include <stdio.h>", '#include "project.h"']
+            for function in functions:
+                lines.append("")
+                function.start_line_number = len(lines) + 1
+                lines += function.render()
+            file_lines[file_name] = lines
+        return file_lines
+
+    def write_project(self, project_path: str) -> Dict[str, int]:
+        """Write the generated project to a directory.
+
+        Args:
+            project_path: Directory receiving the source files
+
+        Returns:
+            Dictionary mapping the file names to their numbers of lines
+        """
+        project_dir = Path(project_path)
+        project_dir.mkdir(parents=True, exist_ok=True)
+
+        line_nums = {}
+        for file_name, lines in self.layout_files().items():
+            (project_dir / file_name).write_text("\n".join(lines) + "\n")
+            line_nums[file_name] = len(lines)
+        return line_nums
+
+    def create_slice_requests(
+        self, project_path: str, name: str
+    ) -> List[Tuple[Dict, SyntheticFunction, int]]:
+        """Create slice requests seeded in the generated project.
+
+        The first request slices backward from the final result printed by main and
+        the second one slices forward from the first local variable of main. The
+        other requests alternate between backward slices from the return values
+        and forward slices from the local variables of random functions.
+
+        Args:
+            project_path: Directory containing the written project
+            name: Name of the project, used in the request IDs
+
+        Returns:
+            List of triples of a slice request in the format of
+            SliceRequest.from_dict, the function containing its seed and the index
+            of the seed statement in the function
+        """
+        project_dir = Path(project_path).resolve()
+        try:
+            request_project_path = str(project_dir.relative_to(BASE_PATH))
+        except ValueError:
+            request_project_path = str(project_dir)
+
+        requests = []
+        for index in range(self.config.request_num):
+            is_backward = index % 2 == 0
+            if index < 2:
+                function = self.functions[0]
+            else:
+                function = self.rng.choice(self.functions)
+            if is_backward:
+                # The final printf of main, or the return statement of the others
+                line_index = len(function.statements) - 2
+                if function.level == 0:
+                    line_index -= 1
+            else:
+                line_index = next(
+                    i
+                    for i, statement in enumerate(function.statements)
+                    if statement.kind == "decl"
+                )
+            statement = function.statements[line_index]
+            seed_name = sorted(statement.uses if is_backward else statement.defs)[0]
+            direction = "backward" if is_backward else "forward"
+            request = {
+                "slicing_request_id": f"{name}_{direction}_{index + 1:02d}",
+                "project_path": request_project_path,
+                "file_path": f"{request_project_path}/{function.file_name}",
+                "seed_line_number": function.start_line_number + line_index,
+                "seed_name": seed_name,
+                "is_backward": is_backward,
+            }
+            requests.append((request, function, line_index))
+        return requests
+
+
+def generate_synthetic_project(
+    config: SyntheticProjectConfig,
+    project_path: str,
+    request_dir: str,
+    oracle_dir: Optional[str] = None,
+) -> Dict:
+    """Generate a synthetic project, its slice requests and their oracles.
+
+    Args:
+        config: Parameters of the project
+        project_path: Directory receiving the source files
+        request_dir: Directory receiving the slice request JSON files
+        oracle_dir: Directory receiving the oracle JSON files, or None to skip them
+
+    Returns:
+        Summary of the generated project
+    """
+    # Imported here, as the oracle builder depends on the classes of this module
+    from utility.synthetic_oracle import SyntheticOracleBuilder
+
+    name = Path(project_path).resolve().name
+    generator = SyntheticProjectGenerator(config)
+    generator.generate()
+    line_nums = generator.write_project(project_path)
+    oracle_builder = SyntheticOracleBuilder(generator.functions)
+
+    Path(request_dir).mkdir(parents=True, exist_ok=True)
+    if oracle_dir is not None:
+        Path(oracle_dir).mkdir(parents=True, exist_ok=True)
+    request_paths = []
+    oracle_paths = []
+    for request, function, line_index in generator.create_slice_requests(
+        project_path, name
+    ):
+        slicing_request_id = request["slicing_request_id"]
+        request_path = Path(request_dir) / f"{slicing_request_id}.json"
+        with open(request_path, "w") as f:
+            json.dump(request, f, indent=4)
+        request_paths.append(str(request_path))
+
+        if oracle_dir is None:
+            continue
+        oracle = oracle_builder.build_oracle(
+            slicing_request_id,
+            function.name,
+            line_index,
+            request["seed_name"],
+            request["is_backward"],
+        )
+        oracle_path = Path(oracle_dir) / f"{slicing_request_id}.json"
+        with open(oracle_path, "w") as f:
+            json.dump(oracle, f, indent=4)
+        oracle_paths.append(str(oracle_path))
+
+    return {
+        "project_path": str(Path(project_path).resolve()),
+        "config": config.to_dict(),
+        "function_num": len(generator.functions),
+        "line_num": sum(line_nums.values()),
+        "request_paths": request_paths,
+        "oracle_paths": oracle_paths,
+    }
+
+
+def main():
+    """Main function for command-line usage."""
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        description="Generate a synthetic C project and its slice requests"
+    )
+    parser.add_argument("project_path", help="Directory receiving the project")
+    parser.add_argument(
+        "--request-dir",
+        default=None,
+        help="Directory receiving the slice requests (default: the parent directory)",
+    )
+    parser.add_argument(
+        "--oracle-dir",
+        default=None,
+        help="Directory receiving the oracles (default: oracle/ in the request dir)",
+    )
+    parser.add_argument(
+        "--no-oracle", action="store_true", help="Do not generate the oracles"
+    )
+    parser.add_argument("--files", type=int, default=4, help="Number of files")
+    parser.add_argument("--functions", type=int, default=20, help="Number of functions")
+    parser.add_argument("--call-depth", type=int, default=3, help="Call levels")
+    parser.add_argument("--fan-out", type=int, default=2, help="Callees per function")
+    parser.add_argument("--fan-in", type=int, default=2, help="Callers per function")
+    parser.add_argument(
+        "--function-length", type=int, default=30, help="Lines per function"
+    )
+    parser.add_argument(
+        "--branch-density", type=float, default=0.2, help="Probability of if blocks"
+    )
+    parser.add_argument(
+        "--loop-density", type=float, default=0.1, help="Probability of for loops"
+    )
+    parser.add_argument(
+        "--requests", type=int, default=2, help="Number of slice requests"
+    )
+    parser.add_argument("--seed", type=int, default=0, help="Random seed")
+    args = parser.parse_args()
+
+    config = SyntheticProjectConfig(
+        file_num=args.files,
+        function_num=args.functions,
+        call_depth=args.call_depth,
+        fan_out=args.fan_out,
+        fan_in=args.fan_in,
+        function_length=args.function_length,
+        branch_density=args.branch_density,
+        loop_density=args.loop_density,
+        request_num=args.requests,
+        seed=args.seed,
+    )
+    request_dir = args.request_dir or str(Path(args.project_path).resolve().parent)
+    oracle_dir = None
+    if not args.no_oracle:
+        oracle_dir = args.oracle_dir or str(Path(request_dir) / "oracle")
+    summary = generate_synthetic_project(
+        config, args.project_path, request_dir, oracle_dir
+    )
+    print(json.dumps(summary, indent=4))
+
+
+if __name__ == "__main__":
+    main()
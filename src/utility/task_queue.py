@@ -0,0 +1,280 @@
+"""Task queues connecting the coordinator and the workers of a distributed run.
+
+TaskQueue is the interface used by utility/distributed.py. FileTaskQueue keeps the
+tasks as JSON files in a directory, so that the coordinator and workers on several
+hosts can share it on a network file system, or test it on one host:
+
+    <queue_dir>/pending/<task_id>.json   tasks waiting for a worker
+    <queue_dir>/claimed/<task_id>.json   tasks run by a worker (the lease)
+    <queue_dir>/done/<task_id>.json      results of the completed tasks
+    <queue_dir>/failed/<task_id>.json    errors of the failed tasks
+    <queue_dir>/CLOSED                   marker: no task will be added
+
+A worker claims a task by renaming it from pending/ to claimed/, which succeeds for
+one worker only. It renews its lease by touching the claimed file, and the
+coordinator returns the tasks of expired leases (e.g., of a crashed worker) to
+pending/.
+
+The task ids are the slicing request ids, which are reused across runs, so a
+queue directory serves a single run: the files of an earlier run would be taken
+for the results of the new tasks.
+"""
+
+import json
+import os
+import socket
+import tempfile
+import time
+from abc import ABC, abstractmethod
+from pathlib import Path
+from typing import Dict, List, Optional, Set, Tuple
+
+from utility.errors import RAValueError
+
+PENDING_DIR = "pending"
+CLAIMED_DIR = "claimed"
+DONE_DIR = "done"
+FAILED_DIR = "failed"
+CLOSED_MARKER = "CLOSED"
+
+
+class TaskQueue(ABC):
+    """Queue of the tasks of a distributed run."""
+
+    @abstractmethod
+    def put(self, task_id: str, payload: Dict) -> None:
+        """Add a task.
+
+        Args:
+            task_id: Unique id of the task
+            payload: JSON-serializable description of the task
+        """
+
+    @abstractmethod
+    def is_empty(self) -> bool:
+        """Check whether the queue has no task and is not closed."""
+
+    @abstractmethod
+    def close(self) -> None:
+        """Mark that no task will be added, so that idle workers can exit."""
+
+    @abstractmethod
+    def is_closed(self) -> bool:
+        """Check whether no task will be added."""
+
+    @abstractmethod
+    def claim(self, worker_id: str) -> Optional[Tuple[str, Dict]]:
+        """Claim a pending task.
+
+        Args:
+            worker_id: Id of the claiming worker
+
+        Returns:
+            Tuple of (task id, payload), or None if no task is pending
+        """
+
+    @abstractmethod
+    def renew(self, task_id: str) -> None:
+        """Renew the lease of a claimed task."""
+
+    @abstractmethod
+    def complete(self, task_id: str, result: Dict) -> None:
+        """Store the result of a claimed task.
+
+        Args:
+            task_id: Id of the task
+            result: JSON-serializable result of the task
+        """
+
+    @abstractmethod
+    def fail(self, task_id: str, error: str, max_attempt_num: int = 1) -> bool:
+        """Report the failure of a claimed task.
+
+        Args:
+            task_id: Id of the task
+            error: Description of the failure
+            max_attempt_num: Number of attempts before the task is failed
+
+        Returns:
+            True if the task is failed, False if it is pending again
+        """
+
+    @abstractmethod
+    def requeue_expired(self, lease_seconds: float) -> List[str]:
+        """Return the claimed tasks whose lease expired to the pending ones.
+
+        Args:
+            lease_seconds: Seconds after the last renewal a lease expires
+
+        Returns:
+            Ids of the requeued tasks
+        """
+
+    @abstractmethod
+    def get_status(self) -> Dict[str, int]:
+        """Count the pending, claimed, done and failed tasks."""
+
+    @abstractmethod
+    def get_finished_task_ids(self) -> Set[str]:
+        """Get the ids of the completed and failed tasks."""
+
+    @abstractmethod
+    def get_results(self) -> Dict[str, Dict]:
+        """Get the results of the completed tasks, keyed by task id."""
+
+    @abstractmethod
+    def get_errors(self) -> Dict[str, Dict]:
+        """Get the errors of the failed tasks, keyed by task id."""
+
+
+def _write_json_atomically(path: Path, data: Dict) -> None:
+    """Write a JSON file under a temporary name and rename it."""
+    fd, tmp_path = tempfile.mkstemp(dir=path.parent, suffix=".tmp")
+    with os.fdopen(fd, "w", encoding="utf-8") as f:
+        json.dump(data, f, indent=4)
+    os.replace(tmp_path, path)
+
+
+class FileTaskQueue(TaskQueue):
+    """Task queue stored in a directory, shared by processes and hosts."""
+
+    def __init__(self, queue_dir: str) -> None:
+        """Open the queue, creating its directories if missing.
+
+        Args:
+            queue_dir: Directory of the queue
+        """
+        self.queue_dir = Path(queue_dir)
+        for dir_name in (PENDING_DIR, CLAIMED_DIR, DONE_DIR, FAILED_DIR):
+            (self.queue_dir / dir_name).mkdir(parents=True, exist_ok=True)
+
+    def _get_task_path(self, dir_name: str, task_id: str) -> Path:
+        if not task_id or "/" in task_id or task_id.startswith("."):
+            raise RAValueError(f"Invalid task id: {task_id}")
+        return self.queue_dir / dir_name / f"{task_id}.json"
+
+    def _load_tasks(self, dir_name: str) -> Dict[str, Dict]:
+        tasks: Dict[str, Dict] = {}
+        for task_path in sorted((self.queue_dir / dir_name).glob("*.json")):
+            try:
+                with open(task_path, "r", encoding="utf-8") as f:
+                    tasks[task_path.stem] = json.load(f)
+            except FileNotFoundError:
+                # Moved by another process meanwhile
+                continue
+        return tasks
+
+    def put(self, task_id: str, payload: Dict) -> None:
+        task = {"task_id": task_id, "payload": payload, "attempt_num": 0}
+        _write_json_atomically(self._get_task_path(PENDING_DIR, task_id), task)
+
+    def is_empty(self) -> bool:
+        if (self.queue_dir / CLOSED_MARKER).exists():
+            return False
+        return not any(
+            any((self.queue_dir / dir_name).iterdir())
+            for dir_name in (PENDING_DIR, CLAIMED_DIR, DONE_DIR, FAILED_DIR)
+        )
+
+    def close(self) -> None:
+        (self.queue_dir / CLOSED_MARKER).touch()
+
+    def is_closed(self) -> bool:
+        return (self.queue_dir / CLOSED_MARKER).exists()
+
+    def claim(self, worker_id: str) -> Optional[Tuple[str, Dict]]:
+        for pending_path in sorted((self.queue_dir / PENDING_DIR).glob("*.json")):
+            claimed_path = self.queue_dir / CLAIMED_DIR / pending_path.name
+            try:
+                os.rename(pending_path, claimed_path)
+            except FileNotFoundError:
+                # Claimed by another worker
+                continue
+            # The rename keeps the modification time of the put, so the lease is
+            # started before the task is read
+            os.utime(claimed_path)
+            if (self.queue_dir / DONE_DIR / pending_path.name).exists():
+                # Requeued after an expired lease, but completed since
+                os.remove(claimed_path)
+                continue
+            with open(claimed_path, "r", encoding="utf-8") as f:
+                task = json.load(f)
+            task["attempt_num"] += 1
+            task["worker_id"] = worker_id
+            task["host"] = socket.gethostname()
+            _write_json_atomically(claimed_path, task)
+            return task["task_id"], task["payload"]
+        return None
+
+    def renew(self, task_id: str) -> None:
+        try:
+            os.utime(self._get_task_path(CLAIMED_DIR, task_id))
+        except FileNotFoundError:
+            # The lease expired and the task was requeued
+            pass
+
+    def _release(self, task_id: str) -> Optional[Dict]:
+        """Remove a claimed task, returning it, or None if its lease was lost."""
+        claimed_path = self._get_task_path(CLAIMED_DIR, task_id)
+        try:
+            with open(claimed_path, "r", encoding="utf-8") as f:
+                task = json.load(f)
+            os.remove(claimed_path)
+        except FileNotFoundError:
+            return None
+        return task
+
+    def complete(self, task_id: str, result: Dict) -> None:
+        # A task requeued after an expired lease may complete twice, in which
+        # case the later result replaces the earlier one
+        _write_json_atomically(self._get_task_path(DONE_DIR, task_id), result)
+        self._release(task_id)
+        try:
+            os.remove(self._get_task_path(FAILED_DIR, task_id))
+        except FileNotFoundError:
+            pass
+
+    def fail(self, task_id: str, error: str, max_attempt_num: int = 1) -> bool:
+        task = self._release(task_id)
+        if task is None:
+            # Another worker runs the requeued task
+            return False
+        task["error"] = error
+        if task["attempt_num"] < max_attempt_num:
+            _write_json_atomically(self._get_task_path(PENDING_DIR, task_id), task)
+            return False
+        _write_json_atomically(self._get_task_path(FAILED_DIR, task_id), task)
+        return True
+
+    def requeue_expired(self, lease_seconds: float) -> List[str]:
+        requeued_task_ids: List[str] = []
+        now = time.time()
+        for claimed_path in sorted((self.queue_dir / CLAIMED_DIR).glob("*.json")):
+            try:
+                if now - claimed_path.stat().st_mtime < lease_seconds:
+                    continue
+                pending_path = self.queue_dir / PENDING_DIR / claimed_path.name
+                os.rename(claimed_path, pending_path)
+            except FileNotFoundError:
+                continue
+            requeued_task_ids.append(claimed_path.stem)
+        return requeued_task_ids
+
+    def get_status(self) -> Dict[str, int]:
+        return {
+            dir_name: len(list((self.queue_dir / dir_name).glob("*.json")))
+            for dir_name in (PENDING_DIR, CLAIMED_DIR, DONE_DIR, FAILED_DIR)
+        }
+
+    def get_finished_task_ids(self) -> Set[str]:
+        return {
+            task_path.stem
+            for dir_name in (DONE_DIR, FAILED_DIR)
+            for task_path in (self.queue_dir / dir_name).glob("*.json")
+        }
+
+    def get_results(self) -> Dict[str, Dict]:
+        return self._load_tasks(DONE_DIR)
+
+    def get_errors(self) -> Dict[str, Dict]:
+        return self._load_tasks(FAILED_DIR)
@@ -0,0 +1,165 @@
+"""Span tracing of a run, exported in the Chrome trace-event format.
+
+The exported JSON file can be opened in chrome://tracing or https://ui.perfetto.dev
+to see the spans of all the threads on one timeline, e.g., the concurrency of the
+LLM queries, the idle gaps between them and the critical path of the worklist.
+"""
+
+import json
+import os
+import threading
+import time
+from contextlib import contextmanager, nullcontext
+from typing import Any, ContextManager, Dict, Iterator, List
+
+
+class TraceSpan:
+    """A span being recorded, whose arguments can be set until it ends."""
+
+    def __init__(self, name: str, category: str, args: Dict[str, Any]) -> None:
+        """Initialize a span.
+
+        Args:
+            name: Name of the span
+            category: Category of the span (e.g., "analyzer" or "llm")
+            args: Arguments shown with the span in the trace viewer
+        """
+        self.name = name
+        self.category = category
+        self.args = args
+
+    def set(self, **args: Any) -> None:
+        """Set arguments of the span."""
+        self.args.update(args)
+
+
+class NullTraceSpan(TraceSpan):
+    """The span of a disabled tracer, which ignores its arguments."""
+
+    def __init__(self) -> None:
+        super().__init__("", "", {})
+
+    def set(self, **args: Any) -> None:
+        pass
+
+
+NULL_SPAN = NullTraceSpan()
+
+# nullcontext is reentrant, so one instance serves all the spans of a disabled tracer
+NULL_SPAN_CONTEXT = nullcontext(NULL_SPAN)
+
+
+class Tracer:
+    """Thread-safe recorder of the spans of a run.
+
+    The tracer is disabled by default, so that the traced code costs a single
+    attribute check in normal runs. Each span is recorded as a complete event
+    ("ph": "X") of the thread it runs in.
+    """
+
+    def __init__(self) -> None:
+        self.is_enabled = False
+        self._lock = threading.Lock()
+        self._local = threading.local()
+        self._events: List[Dict] = []
+        self._thread_names: Dict[int, str] = {}
+        self._start_time = time.perf_counter()
+
+    def enable(self) -> None:
+        """Enable the tracer and drop the recorded spans."""
+        with self._lock:
+            self._events = []
+            self._thread_names = {}
+            self._start_time = time.perf_counter()
+            self.is_enabled = True
+
+    def disable(self) -> None:
+        """Disable the tracer. The recorded spans are kept."""
+        self.is_enabled = False
+
+    def span(self, name: str, category: str, **args: Any) -> ContextManager[TraceSpan]:
+        """Record the enclosed block as a span.
+
+        Args:
+            name: Name of the span
+            category: Category of the span
+            args: Initial arguments of the span
+
+        Returns:
+            Context manager yielding the span, or a span ignoring its arguments if
+            the tracer is disabled
+        """
+        if not self.is_enabled:
+            return NULL_SPAN_CONTEXT
+        return self._record_span(TraceSpan(name, category, args))
+
+    def current_span(self) -> TraceSpan:
+        """Get the innermost span being recorded in the current thread.
+
+        Returns:
+            The span, or a span ignoring its arguments if there is none
+        """
+        if not self.is_enabled:
+            return NULL_SPAN
+        spans = getattr(self._local, "spans", None)
+        return spans[-1] if spans else NULL_SPAN
+
+    @contextmanager
+    def _record_span(self, span: TraceSpan) -> Iterator[TraceSpan]:
+        spans = getattr(self._local, "spans", None)
+        if spans is None:
+            spans = self._local.spans = []
+        spans.append(span)
+        start_time = time.perf_counter()
+        try:
+            yield span
+        finally:
+            end_time = time.perf_counter()
+            spans.pop()
+            thread = threading.current_thread()
+            event = {
+                "name": span.name,
+                "cat": span.category,
+                "ph": "X",
+                "ts": (start_time - self._start_time) * 1e6,
+                "dur": (end_time - start_time) * 1e6,
+                "pid": os.getpid(),
+                "tid": thread.ident,
+                "args": span.args,
+            }
+            with self._lock:
+                self._events.append(event)
+                self._thread_names.setdefault(thread.ident, thread.name)
+
+    def to_dict(self) -> Dict:
+        """Convert the recorded spans to the Chrome trace-event format.
+
+        Returns:
+            Dictionary with the span events, preceded by the thread name events
+        """
+        with self._lock:
+            events = [
+                {
+                    "name": "thread_name",
+                    "ph": "M",
+                    "pid": os.getpid(),
+                    "tid": tid,
+                    "args": {"name": thread_name},
+                }
+                for tid, thread_name in self._thread_names.items()
+            ]
+            events.extend(sorted(self._events, key=lambda event: event["ts"]))
+        return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+    def export(self, trace_path: str) -> None:
+        """Write the recorded spans to a Chrome trace-event JSON file.
+
+        Args:
+            trace_path: Path of the JSON file
+        """
+        with open(trace_path, "w") as f:
+            json.dump(self.to_dict(), f, default=str)
+
+
+# The tracer shared by all the traced code of a process
+TRACER = Tracer()